@@ -0,0 +1,672 @@
+/*
+ * bench.cpp - Micro benchmarks for every DSP stage, plus the whole TX chain.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <span>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "bit_stream_reader.h"
+#include "config.h"
+#include "convolutional_code.h"
+#include "demapper.h"
+#include "fft.h"
+#include "fir_filter.h"
+#include "gaussian_noise.h"
+#include "nco.h"
+#include "ofdm.h"
+#include "output_handler.h"
+#include "packet.h"
+#include "pipeline.h"
+#include "pulse_shaping_filter.h"
+#include "reed_solomon.h"
+#include "resampler.h"
+#include "sample_format.h"
+#include "symbol_mapper.h"
+#include "symbol_table.h"
+
+/*
+ *  Google Benchmark in miniature, without the dependency. Every benchmark
+ *  is a callable that processes one block; it's run with the iteration
+ *  count doubled until a run takes a tenth of --min-time, then REPETITIONS
+ *  runs of that size are timed and the median kept. Throughput is items
+ *  (samples, symbols or bits, whatever the stage counts in) and bytes
+ *  produced per second.
+ *
+ *  --json file saves the results, one benchmark per line; --baseline file
+ *  compares against an earlier save and flags anything more than
+ *  --threshold percent slower (exit status 2 if there was any). --filter
+ *  runs only the benchmarks whose name contains the text.
+ *
+ *  The macro benchmark is main's TX chain in process, both fused and
+ *  threaded: bits off a file through BitStreamReader, mapping, RRC, the
+ *  carrier NCO, conversion to the -o format and OutputHandler into
+ *  /dev/null. It takes main's options (--samp-rate, --mod, ...).
+ */
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int REPETITIONS = 5;
+constexpr size_t BLOCKS[] = {256, 4096, 65536};
+constexpr size_t MAX_BLOCK = 65536;
+constexpr size_t WRITE_FILE_LIMIT = 256 << 20; // Start over past this
+
+// Keeps the compiler from dropping work whose result nobody reads.
+inline void keep(const void *p) { asm volatile("" : : "r"(p) : "memory"); }
+
+struct Result {
+  std::string name;
+  size_t block;
+  uint64_t iterations;
+  double nsPerIter;
+  double itemsPerSec;
+  double bytesPerSec;
+};
+
+std::string human(double v) {
+  const char *units[] = {"", "k", "M", "G", "T"};
+  int u = 0;
+  while (v >= 1000.0 && u < 4) {
+    v /= 1000.0;
+    u++;
+  }
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%.3g%s", v, units[u]);
+  return buf;
+}
+
+class Bench {
+public:
+  Bench(double minTime, std::string filter)
+      : minTime(minTime), filter(std::move(filter)) {}
+
+  // items and bytes are what one call of fn processes and produces.
+  void run(const std::string &name, size_t block, double items, double bytes,
+           const std::function<void()> &fn) {
+    if (!filter.empty() && name.find(filter) == std::string::npos)
+      return;
+    auto timeOf = [&](uint64_t n) {
+      auto t0 = Clock::now();
+      for (uint64_t i = 0; i < n; i++)
+        fn();
+      return std::chrono::duration<double>(Clock::now() - t0).count();
+    };
+    fn(); // Warm the caches (and any lazily sized buffers)
+    uint64_t n = 1;
+    double t;
+    while ((t = timeOf(n)) < minTime / 10.0 && n < (uint64_t(1) << 40))
+      n *= 2;
+    n = std::max<uint64_t>(1, (uint64_t)(n * (minTime / REPETITIONS) /
+                                         std::max(t, 1e-9)));
+    double times[REPETITIONS];
+    for (double &rep : times)
+      rep = timeOf(n) / (double)n;
+    std::sort(times, times + REPETITIONS);
+    const double perIter = times[REPETITIONS / 2];
+
+    Result r{name, block, n, perIter * 1e9, items / perIter, bytes / perIter};
+    printf("%-28s %8zu %12.1f ns %10s/s %10sB/s\n", r.name.c_str(), r.block,
+           r.nsPerIter, human(r.itemsPerSec).c_str(),
+           human(r.bytesPerSec).c_str());
+    fflush(stdout);
+    results.push_back(r);
+  }
+
+  const std::vector<Result> &all() const { return results; }
+
+private:
+  double minTime;
+  std::string filter;
+  std::vector<Result> results;
+};
+
+// *** === Micro benchmarks === ***
+void benchMapping(Bench &b) {
+  Xoshiro256 rng(1);
+  std::vector<uint8_t> labels(MAX_BLOCK);
+  for (uint8_t &l : labels)
+    l = (uint8_t)rng.next();
+  std::vector<std::complex<float>> out(MAX_BLOCK);
+  for (Modulation mod : {Modulation::BPSK, Modulation::QPSK, Modulation::QAM16,
+                         Modulation::QAM64})
+    for (size_t n : BLOCKS)
+      b.run(std::string("map/") + modulationName(mod), n, n,
+            n * sizeof(std::complex<float>), [&] {
+              withMapper(mod, [&](auto mapper) {
+                mapper.map(labels.data(), n, out.data());
+              });
+              keep(out.data());
+            });
+}
+
+// mapSymToIQ's work without its debug file writes: a carrier template from
+// the NCO, scaled and rotated into every row. The block is the row length.
+void benchSymbolTable(Bench &b) {
+  const auto points = constellationPoints(Modulation::QPSK);
+  for (size_t sps : {8, 64, 1085}) {
+    SymbolTable table(points.size(), sps);
+    std::vector<std::complex<float>> tmpl(sps);
+    b.run("mapSymToIQ/build", sps, (double)sps * points.size(),
+          (double)sps * points.size() * sizeof(std::complex<float>), [&] {
+            NCO(2440.0, 1e6).generate(tmpl.data(), sps);
+            for (size_t s = 0; s < points.size(); s++)
+              std::transform(tmpl.begin(), tmpl.end(), table.row(s).begin(),
+                             [&](std::complex<float> x) { return x * points[s]; });
+            keep(table.row(0).data());
+          });
+  }
+
+  // What main's modulate stage does with the table: a row per symbol.
+  const size_t sps = 8;
+  SymbolTable table(points.size(), sps);
+  std::vector<uint8_t> labels(MAX_BLOCK);
+  Xoshiro256 rng(2);
+  for (uint8_t &l : labels)
+    l = (uint8_t)(rng.next() & 3);
+  std::vector<std::complex<float>> out(MAX_BLOCK * sps);
+  for (size_t n : BLOCKS)
+    b.run("mapSymToIQ/render", n, (double)n * sps,
+          (double)n * sps * sizeof(std::complex<float>), [&] {
+            for (size_t k = 0; k < n; k++) {
+              auto row = table[labels[k]];
+              std::copy(row.begin(), row.end(), out.begin() + k * sps);
+            }
+            keep(out.data());
+          });
+}
+
+void benchNco(Bench &b) {
+  NCO nco(100e3, 2.56e6);
+  std::vector<std::complex<float>> buf(MAX_BLOCK, {0.5f, 0.25f});
+  for (size_t n : BLOCKS)
+    b.run("nco/mix", n, n, n * sizeof(std::complex<float>), [&] {
+      nco.mix(buf.data(), buf.data(), n);
+      keep(buf.data());
+    });
+}
+
+void benchFilters(Bench &b) {
+  std::vector<std::complex<float>> in(MAX_BLOCK, {0.5f, -0.5f});
+  std::vector<std::complex<float>> out(MAX_BLOCK * 8);
+  for (size_t numTaps : {17, 65, 257}) {
+    FirFilter fir(designPulse(PulseShape::RootRaisedCosine, 0.35f, 8.0,
+                              (numTaps - 1) / 8));
+    for (size_t n : BLOCKS)
+      b.run("fir/" + std::to_string(fir.taps().size()) + "taps", n, n,
+            n * sizeof(std::complex<float>), [&] {
+              fir.filter(in.data(), n, out.data());
+              keep(out.data());
+            });
+  }
+
+  // Where FirFilter::FFT_THRESHOLD comes from: both ways, around it.
+  for (size_t numTaps : {64, 128, 256, 1024}) {
+    for (FirMethod method : {FirMethod::Direct, FirMethod::OverlapSave}) {
+      FirFilter fir(std::vector<float>(numTaps, 1.0f / numTaps), method);
+      const char *how = method == FirMethod::Direct ? "direct" : "ols";
+      b.run("fir/" + std::string(how) + "/" + std::to_string(numTaps) +
+                "taps",
+            MAX_BLOCK, MAX_BLOCK, MAX_BLOCK * sizeof(std::complex<float>),
+            [&] {
+              fir.filter(in.data(), MAX_BLOCK, out.data());
+              keep(out.data());
+            });
+    }
+  }
+
+  // Symbols in, 8 samples a symbol out.
+  PulseShapingFilter rrc(0.35f, 8, 8);
+  for (size_t n : BLOCKS) {
+    const size_t numSyms = n / 8;
+    b.run("rrc/interpolate", n, n, n * sizeof(std::complex<float>), [&] {
+      rrc.interpolate(in.data(), numSyms, out.data());
+      keep(out.data());
+    });
+  }
+}
+
+// RRC (rolloff 0.6) at 4 samples a symbol to and from 2.56 MS/s at 72 kBd.
+// Items are input samples.
+void benchResampler(Bench &b) {
+  const size_t cf32 = sizeof(std::complex<float>);
+  std::vector<std::complex<float>> in(MAX_BLOCK, {0.5f, -0.5f});
+  std::vector<std::complex<float>> out(MAX_BLOCK * 9 + 2);
+  const double passband = 1.6 / 8.0;
+  Resampler up(320, 36, passband), down(36, 320, passband);
+  for (size_t n : BLOCKS) {
+    b.run("resample/up", n, n, n * cf32, [&] {
+      up.process(in.data(), n, out.data());
+      keep(out.data());
+    });
+    b.run("resample/down", n, n, n * cf32, [&] {
+      down.process(in.data(), n, out.data());
+      keep(out.data());
+    });
+  }
+}
+
+void benchConversion(Bench &b) {
+  std::vector<std::complex<float>> in(MAX_BLOCK);
+  GaussianNoise(3).add(in.data(), in.size(), 0.5f);
+  std::vector<uint8_t> out(MAX_BLOCK * sizeof(std::complex<float>));
+  for (SampleFormat fmt : {SampleFormat::CS16, SampleFormat::CS8,
+                           SampleFormat::CU8}) {
+    FormatConverter conv(fmt, 1.5f);
+    for (size_t n : BLOCKS)
+      b.run(std::string("convert/") + formatName(fmt), n, n,
+            n * conv.bytesPerSample(), [&] {
+              conv.convert(in.data(), n, out.data());
+              keep(out.data());
+            });
+  }
+}
+
+void benchWriting(Bench &b, const std::string &tmpDir) {
+  std::vector<std::complex<float>> buf(MAX_BLOCK, {0.5f, 0.5f});
+  {
+    OutputHandler sink("/dev/null");
+    for (size_t n : BLOCKS)
+      b.run("write/devnull", n, n, n * sizeof(std::complex<float>),
+            [&] { sink.writeToFile(buf.data(), n); });
+  }
+
+  // A real file, started over every WRITE_FILE_LIMIT so it stays in the
+  // page cache's reach.
+  const std::string path = tmpDir + "/qpsk_bench_" +
+                           std::to_string(getpid()) + ".cf32";
+  auto sink = std::make_unique<OutputHandler>(path);
+  if (!sink->isOpen())
+    return;
+  for (size_t n : BLOCKS)
+    b.run("write/file", n, n, n * sizeof(std::complex<float>), [&] {
+      if (sink->bytesWritten() > WRITE_FILE_LIMIT) {
+        sink.reset();
+        sink = std::make_unique<OutputHandler>(
+            path, OutputHandler::DEFAULT_BUFFER_BYTES, FlushPolicy::WhenFull,
+            false);
+      }
+      sink->writeToFile(buf.data(), n);
+    });
+  sink.reset();
+  unlink(path.c_str());
+}
+
+void benchReceive(Bench &b) {
+  std::vector<std::complex<float>> syms(MAX_BLOCK);
+  Xoshiro256 rng(4);
+  std::vector<uint8_t> labels(MAX_BLOCK);
+  for (uint8_t &l : labels)
+    l = (uint8_t)(rng.next() & 3);
+  QPSKSymbolMapper::map(labels.data(), MAX_BLOCK, syms.data());
+  GaussianNoise noise(5);
+
+  std::vector<std::complex<float>> work(MAX_BLOCK);
+  for (size_t n : BLOCKS)
+    b.run("noise/add", n, n, n * sizeof(std::complex<float>), [&] {
+      noise.add(work.data(), n, 0.1f);
+      keep(work.data());
+    });
+  noise.add(syms.data(), syms.size(), 0.3f);
+
+  Demapper demapper(Modulation::QPSK, 0.2f);
+  std::vector<int8_t> llrs(2 * MAX_BLOCK);
+  std::vector<uint8_t> bits(2 * MAX_BLOCK);
+  for (size_t n : BLOCKS)
+    b.run("demap/qpsk/soft", n, n, 2 * n, [&] {
+      demapper.soft(syms.data(), n, llrs.data());
+      keep(llrs.data());
+    });
+
+  demapper.soft(syms.data(), MAX_BLOCK, llrs.data());
+  ViterbiDecoder viterbi;
+  for (size_t n : BLOCKS)
+    b.run("viterbi/decode", n, n / 2.0, n / 16.0, [&] {
+      viterbi.decode(llrs.data(), n, bits.data());
+      keep(bits.data());
+    });
+
+  ReedSolomon rs;
+  std::vector<uint8_t> frame(rs::N * rs::MAX_INTERLEAVE);
+  for (size_t i = 0; i < frame.size(); i++)
+    frame[i] = (uint8_t)rng.next();
+  rs.encodeInterleaved(frame.data(), rs::MAX_INTERLEAVE);
+  b.run("rs/decode_clean", frame.size(), (double)frame.size(),
+        (double)frame.size(), [&] {
+          rs.decodeInterleaved(frame.data(), rs::MAX_INTERLEAVE);
+          keep(frame.data());
+        });
+
+  std::vector<uint8_t> data(MAX_BLOCK);
+  for (uint8_t &d : data)
+    d = (uint8_t)rng.next();
+  for (size_t n : BLOCKS) {
+    b.run("crc/16", n, n, n, [&] {
+      uint16_t c = crc::crc16(data.data(), n);
+      keep(&c);
+    });
+    b.run("crc/32", n, n, n, [&] {
+      uint32_t c = crc::crc32(data.data(), n);
+      keep(&c);
+    });
+  }
+
+  // 1 KiB payloads, deframed in 4096 byte pieces as rx's frames would be.
+  PacketSettings ps;
+  ps.maxPayload = 1024;
+  Packetizer packetizer(ps);
+  Deframer deframer(ps);
+  std::vector<uint8_t> stream;
+  for (size_t at = 0; at + ps.maxPayload <= MAX_BLOCK; at += ps.maxPayload) {
+    const size_t start = stream.size();
+    stream.resize(start + packetizer.maxPacketBytes());
+    std::copy(data.begin() + at, data.begin() + at + ps.maxPayload,
+              stream.begin() + start + packet::HEADER_BYTES);
+    packetizer.seal(&stream[start], ps.maxPayload);
+  }
+  std::vector<std::span<const uint8_t>> payloads;
+  b.run("packet/deframe", stream.size(), (double)stream.size(),
+        (double)stream.size(), [&] {
+          for (size_t at = 0; at < stream.size(); at += 4096)
+            deframer.process(stream.data() + at,
+                             std::min<size_t>(4096, stream.size() - at),
+                             payloads);
+          keep(payloads.data());
+        });
+}
+
+// MAX_BLOCK samples per iteration whatever the FFT size: a batch of them.
+void benchOfdm(Bench &b) {
+  const size_t cf32 = sizeof(std::complex<float>);
+  std::vector<std::complex<float>> in(MAX_BLOCK, {0.5f, -0.25f});
+  std::vector<std::complex<float>> out(MAX_BLOCK);
+  for (size_t n : {64, 1024, 8192}) {
+    const FftPlan &fft = FftPlan::cached(n);
+    b.run("fft/" + std::to_string(n), MAX_BLOCK, MAX_BLOCK, MAX_BLOCK * cf32,
+          [&] {
+            fft.forward(in.data(), out.data(), MAX_BLOCK / n);
+            keep(out.data());
+          });
+  }
+
+  OfdmSettings settings;
+  settings.fftSize = 64;
+  OfdmModulator mod(settings, Modulation::QPSK);
+  OfdmDemodulator demod(settings);
+  Xoshiro256 rng(6);
+  const size_t numLabels = mod.dataCarriers() * 1024;
+  std::vector<uint8_t> labels(numLabels);
+  for (uint8_t &l : labels)
+    l = (uint8_t)(rng.next() & 3);
+  std::vector<std::complex<float>> iq(mod.maxOutput(numLabels));
+  std::vector<std::complex<float>> points(demod.maxOutput(iq.size()));
+  b.run("ofdm/modulate", iq.size(), (double)iq.size(), iq.size() * cf32, [&] {
+    mod.modulate(labels.data(), numLabels, iq.data());
+    keep(iq.data());
+  });
+  b.run("ofdm/demodulate", iq.size(), (double)iq.size(), iq.size() * cf32,
+        [&] {
+          demod.demodulate(iq.data(), iq.size(), points.data());
+          keep(points.data());
+        });
+}
+
+// *** === Macro benchmark === ***
+struct TxBlock {
+  std::vector<uint8_t> symIdx;
+  std::vector<std::complex<float>> symVals;
+  std::vector<std::complex<float>> iqBlock;
+  std::vector<uint8_t> packed;
+  size_t numSyms = 0;
+  size_t numSamps = 0;
+};
+
+// Seconds for one run of main's shaped TX path over the bits in inPath.
+double runTx(const Config &cfg, const std::string &inPath, bool threaded,
+             size_t &numSamples, size_t &numBytes) {
+  FILE *in = fopen(inPath.c_str(), "rb");
+  if (!in)
+    return -1.0;
+  BitStreamReader reader(fileno(in), cfg.bitsPerSymbol);
+  PulseShapingFilter rrc(cfg.rollOff, cfg.sps.num, cfg.spanSymbols,
+                         PulseShape::RootRaisedCosine, Window::Rectangular,
+                         cfg.sps.den);
+  NCO carrier(cfg.carrierFreq, cfg.sampleRate);
+  FormatConverter converter(formatFromFilename(cfg.outFile), cfg.fullScale);
+  OutputHandler sink("/dev/null");
+  const size_t symsPerBlock = std::max<size_t>(
+      rrc.tapsPerPhase(), (1 << 16) / cfg.sps.ceil() + 1);
+  const size_t blockSamps = rrc.maxSamples(symsPerBlock);
+
+  Pipeline<TxBlock> tx(8, [&](TxBlock &b) {
+    b.symIdx.resize(symsPerBlock);
+    b.symVals.resize(symsPerBlock);
+    b.iqBlock.resize(blockSamps);
+    b.packed.resize(blockSamps * converter.bytesPerSample());
+  });
+  numSamples = 0;
+  tx.addStage("read", [&](TxBlock &b) {
+    b.numSyms = reader.readSymbols(b.symIdx.data(), symsPerBlock);
+    return b.numSyms ? StageResult::Ok : StageResult::Done;
+  });
+  tx.addStage("modulate", [&](TxBlock &b) {
+    withMapper(cfg.mod, [&](auto mapper) {
+      mapper.map(b.symIdx.data(), b.numSyms, b.symVals.data());
+    });
+    b.numSamps = rrc.interpolate(b.symVals.data(), b.numSyms,
+                                 b.iqBlock.data());
+    carrier.mix(b.iqBlock.data(), b.iqBlock.data(), b.numSamps);
+    return StageResult::Ok;
+  });
+  tx.addStage("convert", [&](TxBlock &b) {
+    converter.convert(b.iqBlock.data(), b.numSamps, b.packed.data());
+    return StageResult::Ok;
+  });
+  tx.addStage("write", [&](TxBlock &b) {
+    numSamples += b.numSamps;
+    return sink.writeBytes(b.packed.data(),
+                           b.numSamps * converter.bytesPerSample()) == 0
+               ? StageResult::Ok
+               : StageResult::Error;
+  });
+
+  auto t0 = Clock::now();
+  const int err = threaded ? tx.runThreaded() : tx.runFused();
+  const double seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+  fclose(in);
+  numBytes = numSamples * converter.bytesPerSample();
+  return err ? -1.0 : seconds;
+}
+
+void benchTx(Bench &b, const Config &cfg, const std::string &tmpDir,
+             size_t inputBytes) {
+  const std::string path = tmpDir + "/qpsk_bench_" +
+                           std::to_string(getpid()) + ".bin";
+  {
+    std::vector<uint8_t> bits(inputBytes);
+    Xoshiro256 rng(6);
+    for (uint8_t &x : bits)
+      x = (uint8_t)rng.next();
+    std::ofstream(path, std::ios::binary)
+        .write(reinterpret_cast<const char *>(bits.data()), bits.size());
+  }
+  for (bool threaded : {false, true}) {
+    size_t numSamples = 0, numBytes = 0;
+    // Sized by a dry run, so items and bytes are what the chain produced.
+    if (runTx(cfg, path, threaded, numSamples, numBytes) < 0)
+      break;
+    b.run(threaded ? "tx/threaded" : "tx/fused", inputBytes,
+          (double)numSamples, (double)numBytes, [&] {
+            size_t s, y;
+            runTx(cfg, path, threaded, s, y);
+          });
+  }
+  unlink(path.c_str());
+}
+
+// *** === Saving and comparing === ***
+int saveJson(const std::string &path, const std::vector<Result> &results) {
+  FILE *f = fopen(path.c_str(), "w");
+  if (!f) {
+    fprintf(stderr, "[ERROR] Could not open %s (%s)\n", path.c_str(),
+            strerror(errno));
+    return 1;
+  }
+  char date[32];
+  const time_t now = time(nullptr);
+  strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+  fprintf(f, "{\n  \"context\": {\"date\": \"%s\", \"cpus\": %u, "
+             "\"compiler\": \"%s\"},\n  \"benchmarks\": [\n",
+          date, std::thread::hardware_concurrency(), __VERSION__);
+  for (size_t i = 0; i < results.size(); i++) {
+    const Result &r = results[i];
+    fprintf(f, "    {\"name\": \"%s\", \"block\": %zu, \"iterations\": %llu, "
+               "\"ns_per_iter\": %.3f, \"items_per_second\": %.6g, "
+               "\"bytes_per_second\": %.6g}%s\n",
+            r.name.c_str(), r.block, (unsigned long long)r.iterations,
+            r.nsPerIter, r.itemsPerSec, r.bytesPerSec,
+            i + 1 < results.size() ? "," : "");
+  }
+  fprintf(f, "  ]\n}\n");
+  fclose(f);
+  return 0;
+}
+
+// Reads back what saveJson() wrote (one benchmark per line). Returns the
+// number of regressions, or -1 if the file couldn't be read.
+int compare(const std::string &path, const std::vector<Result> &results,
+            double threshold) {
+  std::ifstream in(path);
+  if (!in) {
+    fprintf(stderr, "[ERROR] Could not open baseline %s\n", path.c_str());
+    return -1;
+  }
+  auto field = [](const std::string &line, const char *key,
+                  std::string &value) {
+    const std::string tag = std::string("\"") + key + "\": ";
+    size_t p = line.find(tag);
+    if (p == std::string::npos)
+      return false;
+    p += tag.size();
+    const bool quoted = line[p] == '"';
+    const size_t end = quoted ? line.find('"', p + 1) : line.find_first_of(",}", p);
+    value = line.substr(p + quoted, end - p - quoted);
+    return true;
+  };
+
+  printf("\n%-28s %8s %12s %12s %8s\n", "vs baseline", "block", "before/s",
+         "now/s", "change");
+  int regressions = 0;
+  std::string line, name, block, rate;
+  while (std::getline(in, line)) {
+    if (!field(line, "name", name) || !field(line, "block", block) ||
+        !field(line, "items_per_second", rate))
+      continue;
+    for (const Result &r : results) {
+      if (r.name != name || std::to_string(r.block) != block)
+        continue;
+      const double before = atof(rate.c_str());
+      const double change = 100.0 * (r.itemsPerSec / before - 1.0);
+      const bool slower = change < -threshold;
+      regressions += slower;
+      printf("%-28s %8zu %12s %12s %+7.1f%%%s\n", name.c_str(), r.block,
+             human(before).c_str(), human(r.itemsPerSec).c_str(), change,
+             slower ? "  REGRESSION" : "");
+    }
+  }
+  return regressions;
+}
+
+static void usage(const char *prog) {
+  fprintf(stderr,
+          "Usage: %s [--filter text] [--min-time s] [--json file] "
+          "[--baseline file [--threshold %%]] [--tmp dir] [--tx-bytes N] "
+          "[main's options]\n",
+          prog);
+  Config::usage(stderr);
+}
+
+int main(int argc, char *argv[]) {
+  std::string filter, jsonFile, baseline, tmpDir = "/tmp";
+  double minTime = 0.5, threshold = 10.0, txBytes = 64 << 10;
+  Config cfg;
+  cfg.sampleRate = 2.56e6; // ~35.6 samples a symbol, not main's 1064
+  cfg.baudRate = 72e3;
+  cfg.carrierFreq = 100e3;
+  cfg.outFile = "tx.cs16"; // Only the format: the chain writes to /dev/null
+
+  for (int a = 1; a < argc; a++) {
+    std::string arg = argv[a];
+    bool hasValue = a + 1 < argc;
+    double value = 0;
+    if (arg == "--filter" && hasValue)
+      filter = argv[++a];
+    else if (arg == "--min-time" && hasValue && parseAmount(argv[++a], value))
+      minTime = value;
+    else if (arg == "--json" && hasValue)
+      jsonFile = argv[++a];
+    else if (arg == "--baseline" && hasValue)
+      baseline = argv[++a];
+    else if (arg == "--threshold" && hasValue &&
+             parseAmount(argv[++a], value))
+      threshold = value;
+    else if (arg == "--tmp" && hasValue)
+      tmpDir = argv[++a];
+    else if (arg == "--tx-bytes" && hasValue && parseAmount(argv[++a], value))
+      txBytes = value;
+    else {
+      Config::ParseResult r = cfg.parseArg(argc, argv, a);
+      if (r == Config::ParseResult::Error)
+        return 1;
+      if (r == Config::ParseResult::Unknown) {
+        usage(argv[0]);
+        return 1;
+      }
+    }
+  }
+  if (cfg.finalize() != 0)
+    return 1;
+
+  printf("%-28s %8s %15s %12s %13s\n", "Benchmark", "Block", "Time/iter",
+         "Items/s", "Bytes/s");
+  Bench b(minTime, filter);
+  benchMapping(b);
+  benchSymbolTable(b);
+  benchNco(b);
+  benchFilters(b);
+  benchResampler(b);
+  benchConversion(b);
+  benchWriting(b, tmpDir);
+  benchReceive(b);
+  benchOfdm(b);
+  benchTx(b, cfg, tmpDir, (size_t)txBytes);
+
+  if (!jsonFile.empty() && saveJson(jsonFile, b.all()) != 0)
+    return 1;
+  if (!baseline.empty()) {
+    int regressions = compare(baseline, b.all(), threshold);
+    if (regressions < 0)
+      return 1;
+    if (regressions > 0) {
+      printf("[WARNING] %d benchmarks more than %g%% slower.\n", regressions,
+             threshold);
+      return 2;
+    }
+  }
+  return 0;
+}
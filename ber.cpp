@@ -0,0 +1,470 @@
+/*
+ * ber.cpp - Monte-Carlo BER/SER sweep over Eb/N0, across every core.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "config.h"
+#include "convolutional_code.h"
+#include "demapper.h"
+#include "gaussian_noise.h"
+#include "pipeline.h"
+#include "reed_solomon.h"
+#include "symbol_mapper.h"
+
+/*
+ *  The same mapper, codes and demapper main and rx use, with the filters and
+ *  loops taken out: random bits -> (RS) -> (convolutional code) -> symbols
+ *  -> AWGN -> hard or soft demapping -> (Viterbi) -> (RS) -> count. One
+ *  symbol per sample, so Es/N0 is exactly the symbol SNR:
+ *
+ *    Es/N0 = Eb/N0 + 10 log10(M * code rate)
+ *
+ *  Every thread works through chunks of CHUNK_BITS information bits (RS
+ *  codes a whole number of frames instead) with its own noise and data
+ *  streams, long jumps apart, and its own codec state: nothing is shared
+ *  but two counters, bumped once a chunk. A point ends when the bit errors
+ *  reach --target-errors or the bits --max-bits; the sweep ends early after
+ *  a point without any errors, the rest would show none either.
+ *
+ *  Convolutionally coded chunks are terminated (encoder flushed, decoder
+ *  traced back from state 0), so chunks are independent of each other. The
+ *  six tail bits are not counted against the rate.
+ *
+ *  Counts go to stdout or --report file as CSV, or JSON for a .json file.
+ */
+
+constexpr size_t CHUNK_BITS = 1 << 15;
+constexpr size_t RS_FRAMES_PER_CHUNK = 4;
+
+struct Counts {
+  uint64_t bits = 0;
+  uint64_t bitErrors = 0;
+  uint64_t symbols = 0;
+  uint64_t symbolErrors = 0;
+  uint64_t codewords = 0;
+  uint64_t codewordErrors = 0;
+
+  void add(const Counts &o) {
+    bits += o.bits;
+    bitErrors += o.bitErrors;
+    symbols += o.symbols;
+    symbolErrors += o.symbolErrors;
+    codewords += o.codewords;
+    codewordErrors += o.codewordErrors;
+  }
+};
+
+struct SweepPoint {
+  float ebN0; // dB
+  float esN0;
+  Counts counts;
+  double seconds;
+};
+
+// What a point's workers share: when to stop. Own cache lines, the workers
+// hammer them from every core.
+struct alignas(64) StopCounters {
+  std::atomic<uint64_t> bits{0};
+  alignas(64) std::atomic<uint64_t> bitErrors{0};
+};
+
+class BerWorker {
+public:
+  BerWorker(const Config &cfg, unsigned stream);
+
+  // One chunk at noise power n0 (per complex symbol).
+  Counts chunk(float n0);
+
+private:
+  void randomBits(uint8_t *bits, size_t n);
+  size_t toLabels(const uint8_t *bits, size_t n);
+
+  Modulation mod;
+  size_t M;
+  bool coded;
+  unsigned rsDepth;
+  size_t infoBits; // Per chunk
+  size_t codeBits; // After RS, before the convolutional code
+
+  Xoshiro256 data;
+  GaussianNoise noise;
+  ConvEncoder encoder;
+  ViterbiDecoder viterbi;
+  ReedSolomon rs;
+  Demapper demapper;
+
+  std::vector<uint8_t> sent;  // Information bytes (RS)
+  std::vector<uint8_t> frames;
+  std::vector<uint8_t> codeIn; // Bit per byte, what the conv code gets
+  std::vector<uint8_t> chan;   // Bit per byte on the channel
+  std::vector<uint8_t> labels;
+  std::vector<std::complex<float>> syms;
+  std::vector<uint8_t> hard;
+  std::vector<int8_t> llrs;
+  std::vector<uint8_t> decoded;
+};
+
+BerWorker::BerWorker(const Config &cfg, unsigned stream)
+    : mod(cfg.mod), M(cfg.bitsPerSymbol), coded(cfg.convolutional),
+      rsDepth(cfg.rsDepth), data(~cfg.channel.seed),
+      noise(cfg.channel.seed, stream), encoder(cfg.invertG2),
+      viterbi(ViterbiDecoder::DEFAULT_TRACEBACK, cfg.invertG2),
+      demapper(cfg.mod) {
+  for (unsigned k = 0; k < stream; k++)
+    data.longJump();
+  if (rsDepth > 0) {
+    infoBits = 8 * rs::K * rsDepth * RS_FRAMES_PER_CHUNK;
+    codeBits = 8 * rs::N * rsDepth * RS_FRAMES_PER_CHUNK;
+    sent.resize(infoBits / 8);
+    frames.resize(codeBits / 8);
+  } else {
+    infoBits = codeBits = CHUNK_BITS;
+  }
+  const size_t chanBits = coded ? 2 * codeBits + 2 * (conv::K - 1) : codeBits;
+  const size_t numSyms = (chanBits + M - 1) / M;
+  codeIn.resize(codeBits);
+  chan.resize(numSyms * M);
+  labels.resize(numSyms);
+  syms.resize(numSyms);
+  hard.resize(numSyms * M);
+  llrs.resize(coded ? numSyms * M : 0);
+  decoded.resize(codeBits + conv::K);
+}
+
+void BerWorker::randomBits(uint8_t *bits, size_t n) {
+  for (size_t i = 0; i < n; i += 64) {
+    const uint64_t r = data.next();
+    const size_t m = std::min<size_t>(64, n - i);
+    for (size_t j = 0; j < m; j++)
+      bits[i + j] = (uint8_t)((r >> j) & 1);
+  }
+}
+
+// Channel bits to labels, MSB first, the last symbol padded with zeros.
+size_t BerWorker::toLabels(const uint8_t *bits, size_t n) {
+  std::fill(chan.begin() + n, chan.end(), 0);
+  const size_t numSyms = (n + M - 1) / M;
+  for (size_t k = 0; k < numSyms; k++) {
+    uint8_t label = 0;
+    for (size_t j = 0; j < M; j++)
+      label = (uint8_t)((label << 1) | bits[k * M + j]);
+    labels[k] = label;
+  }
+  return numSyms;
+}
+
+Counts BerWorker::chunk(float n0) {
+  Counts c;
+  c.bits = infoBits;
+
+  // Bits for the code (RS encoded frames, or straight from the generator).
+  if (rsDepth > 0) {
+    for (size_t i = 0; i < sent.size(); i += 8) {
+      const uint64_t r = data.next();
+      std::memcpy(&sent[i], &r, std::min<size_t>(8, sent.size() - i));
+    }
+    const size_t dataBytes = rs::K * rsDepth, frameBytes = rs::N * rsDepth;
+    for (size_t f = 0; f < RS_FRAMES_PER_CHUNK; f++) {
+      uint8_t *frame = &frames[f * frameBytes];
+      std::copy(&sent[f * dataBytes], &sent[(f + 1) * dataBytes], frame);
+      rs.encodeInterleaved(frame, rsDepth);
+    }
+    for (size_t k = 0; k < codeBits; k++)
+      codeIn[k] = (frames[k / 8] >> (7 - k % 8)) & 1;
+  } else {
+    randomBits(codeIn.data(), codeBits);
+  }
+
+  size_t chanBits = codeBits;
+  if (coded) {
+    encoder.reset();
+    chanBits = encoder.encode(codeIn.data(), codeBits, chan.data());
+    chanBits += encoder.flush(&chan[chanBits]);
+  } else {
+    std::copy(codeIn.begin(), codeIn.end(), chan.begin());
+  }
+  const size_t numSyms = toLabels(chan.data(), chanBits);
+
+  withMapper(mod, [&](auto mapper) {
+    mapper.map(labels.data(), numSyms, syms.data());
+  });
+  noise.add(syms.data(), numSyms, std::sqrt(n0 / 2.0f));
+
+  // Channel symbol errors, from the hard decisions.
+  demapper.hard(syms.data(), numSyms, hard.data());
+  c.symbols = numSyms;
+  for (size_t k = 0; k < numSyms; k++) {
+    uint8_t diff = 0;
+    for (size_t j = 0; j < M; j++)
+      diff |= hard[k * M + j] ^ chan[k * M + j];
+    c.symbolErrors += diff;
+  }
+
+  const uint8_t *out = hard.data();
+  if (coded) {
+    demapper.setNoiseVariance(n0);
+    demapper.soft(syms.data(), numSyms, llrs.data());
+    viterbi.reset();
+    size_t n = viterbi.decode(llrs.data(), chanBits, decoded.data());
+    viterbi.flush(&decoded[n], true);
+    out = decoded.data();
+  }
+
+  if (rsDepth == 0) {
+    for (size_t k = 0; k < infoBits; k++)
+      c.bitErrors += out[k] ^ codeIn[k];
+    return c;
+  }
+
+  // Back to bytes, RS decoded, compared codeword by codeword.
+  std::fill(frames.begin(), frames.end(), 0);
+  for (size_t k = 0; k < codeBits; k++)
+    frames[k / 8] |= (uint8_t)(out[k] << (7 - k % 8));
+  const size_t dataBytes = rs::K * rsDepth, frameBytes = rs::N * rsDepth;
+  for (size_t f = 0; f < RS_FRAMES_PER_CHUNK; f++) {
+    uint8_t *frame = &frames[f * frameBytes];
+    const uint8_t *want = &sent[f * dataBytes];
+    rs.decodeInterleaved(frame, rsDepth);
+    for (unsigned j = 0; j < rsDepth; j++) {
+      unsigned wrong = 0;
+      for (size_t k = j; k < dataBytes; k += rsDepth)
+        wrong += (unsigned)std::popcount((unsigned)(frame[k] ^ want[k]));
+      c.bitErrors += wrong;
+      c.codewordErrors += wrong != 0;
+    }
+    c.codewords += rsDepth;
+  }
+  return c;
+}
+
+// *** === Reports === ***
+std::string codeName(const Config &cfg) {
+  std::string name;
+  if (cfg.rsDepth > 0)
+    name = "rs255_223_i" + std::to_string(cfg.rsDepth);
+  if (cfg.convolutional)
+    name += std::string(name.empty() ? "" : "+") +
+            (cfg.invertG2 ? "ccsds_k7" : "ccsds_k7_noninverted");
+  return name.empty() ? "none" : name;
+}
+
+double rate(uint64_t errors, uint64_t total) {
+  return total ? (double)errors / (double)total : 0.0;
+}
+
+void writeCsv(FILE *f, const Config &cfg,
+              const std::vector<SweepPoint> &points) {
+  fprintf(f, "# %s, code %s, seed %llu\n", modulationName(cfg.mod),
+          codeName(cfg).c_str(), (unsigned long long)cfg.channel.seed);
+  fprintf(f, "ebn0_db,esn0_db,bits,bit_errors,ber,symbols,symbol_errors,ser,"
+             "codewords,codeword_errors,fer,seconds\n");
+  for (const SweepPoint &p : points) {
+    const Counts &c = p.counts;
+    fprintf(f, "%g,%.4f,%llu,%llu,%.6e,%llu,%llu,%.6e,%llu,%llu,%.6e,%.3f\n",
+            p.ebN0, p.esN0, (unsigned long long)c.bits,
+            (unsigned long long)c.bitErrors, rate(c.bitErrors, c.bits),
+            (unsigned long long)c.symbols, (unsigned long long)c.symbolErrors,
+            rate(c.symbolErrors, c.symbols), (unsigned long long)c.codewords,
+            (unsigned long long)c.codewordErrors,
+            rate(c.codewordErrors, c.codewords), p.seconds);
+  }
+}
+
+void writeJson(FILE *f, const Config &cfg,
+               const std::vector<SweepPoint> &points) {
+  fprintf(f, "{\n  \"modulation\": \"%s\",\n  \"code\": \"%s\",\n"
+             "  \"seed\": %llu,\n  \"points\": [",
+          modulationName(cfg.mod), codeName(cfg).c_str(),
+          (unsigned long long)cfg.channel.seed);
+  for (size_t i = 0; i < points.size(); i++) {
+    const SweepPoint &p = points[i];
+    const Counts &c = p.counts;
+    fprintf(f, "%s\n    {\"ebn0_db\": %g, \"esn0_db\": %.4f, "
+               "\"bits\": %llu, \"bit_errors\": %llu, \"ber\": %.6e, "
+               "\"symbols\": %llu, \"symbol_errors\": %llu, \"ser\": %.6e, "
+               "\"codewords\": %llu, \"codeword_errors\": %llu, "
+               "\"fer\": %.6e, \"seconds\": %.3f}",
+            i ? "," : "", p.ebN0, p.esN0, (unsigned long long)c.bits,
+            (unsigned long long)c.bitErrors, rate(c.bitErrors, c.bits),
+            (unsigned long long)c.symbols, (unsigned long long)c.symbolErrors,
+            rate(c.symbolErrors, c.symbols), (unsigned long long)c.codewords,
+            (unsigned long long)c.codewordErrors,
+            rate(c.codewordErrors, c.codewords), p.seconds);
+  }
+  fprintf(f, "\n  ]\n}\n");
+}
+
+// "from:to:step" in dB, or a single point.
+bool parseSweep(const std::string &text, float &from, float &to, float &step) {
+  float v[3];
+  int n = 0;
+  const char *p = text.c_str();
+  for (; n < 3; n++) {
+    char *end;
+    v[n] = strtof(p, &end);
+    if (end == p)
+      return false;
+    p = end;
+    if (*p != ':')
+      break;
+    p++;
+  }
+  if (*p != '\0')
+    return false;
+  from = v[0];
+  to = n >= 1 ? v[1] : v[0];
+  step = n >= 2 ? v[2] : 1.0f;
+  return step > 0.0f && to >= from;
+}
+
+static void usage(const char *prog) {
+  fprintf(stderr,
+          "Usage: %s [--ebn0 from:to:step] [--target-errors N] "
+          "[--max-bits N] [--threads N] [--report file.{csv,json}] "
+          "[main's options]\n",
+          prog);
+  Config::usage(stderr);
+}
+
+int main(int argc, char *argv[]) {
+  float from = 0.0f, to = 10.0f, step = 1.0f; // Eb/N0, dB
+  uint64_t targetErrors = 1000;
+  uint64_t maxBits = 1000000000;
+  unsigned numThreads = std::max(1u, std::thread::hardware_concurrency());
+  std::string reportFile; // Empty: stdout, CSV
+  Config cfg;
+
+  for (int a = 1; a < argc; a++) {
+    std::string arg = argv[a];
+    bool hasValue = a + 1 < argc;
+    double value = 0;
+    if (arg == "--ebn0" && hasValue) {
+      if (!parseSweep(argv[++a], from, to, step)) {
+        fprintf(stderr, "[ERROR] Bad sweep '%s', want from:to:step.\n",
+                argv[a]);
+        return 1;
+      }
+    } else if (arg == "--target-errors" && hasValue &&
+               parseAmount(argv[++a], value))
+      targetErrors = (uint64_t)value;
+    else if (arg == "--max-bits" && hasValue && parseAmount(argv[++a], value))
+      maxBits = (uint64_t)value;
+    else if (arg == "--threads" && hasValue && parseAmount(argv[++a], value))
+      numThreads = std::max(1u, (unsigned)value);
+    else if (arg == "--report" && hasValue)
+      reportFile = argv[++a];
+    else {
+      Config::ParseResult r = cfg.parseArg(argc, argv, a);
+      if (r == Config::ParseResult::Error)
+        return 1;
+      if (r == Config::ParseResult::Unknown) {
+        usage(argv[0]);
+        return 1;
+      }
+    }
+  }
+  if (cfg.finalize() != 0)
+    return 1;
+
+  const double codeRate = (cfg.convolutional ? 0.5 : 1.0) *
+                          (cfg.rsDepth > 0 ? (double)rs::K / rs::N : 1.0);
+  const double bitsPerEs = 10.0 * std::log10(cfg.bitsPerSymbol * codeRate);
+  if (cfg.verbosity >= 1)
+    printf("[NOTE] %s, code %s (rate %.4f), %u threads, seed %llu\n",
+           modulationName(cfg.mod), codeName(cfg).c_str(), codeRate,
+           numThreads, (unsigned long long)cfg.channel.seed);
+
+  // One worker per thread for the whole sweep: the streams carry on from
+  // point to point.
+  std::vector<BerWorker> workers;
+  workers.reserve(numThreads);
+  for (unsigned t = 0; t < numThreads; t++)
+    workers.emplace_back(cfg, t);
+  const unsigned numCpus = std::max(1u, std::thread::hardware_concurrency());
+
+  std::vector<SweepPoint> points;
+  for (int i = 0;; i++) {
+    const float ebN0 = from + (float)i * step;
+    if (ebN0 > to + 1e-4f * step)
+      break;
+    SweepPoint p{ebN0, (float)(ebN0 + bitsPerEs), {}, 0.0};
+    const float n0 = (float)std::pow(10.0, -p.esN0 / 10.0);
+
+    StopCounters stop;
+    std::vector<Counts> counts(numThreads);
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < numThreads; t++)
+      threads.emplace_back([&, t] {
+        if (cfg.pinCpus)
+          pinThisThread((int)(t % numCpus));
+        while (stop.bitErrors.load(std::memory_order_relaxed) <
+                   targetErrors &&
+               stop.bits.load(std::memory_order_relaxed) < maxBits) {
+          Counts c = workers[t].chunk(n0);
+          stop.bits.fetch_add(c.bits, std::memory_order_relaxed);
+          stop.bitErrors.fetch_add(c.bitErrors, std::memory_order_relaxed);
+          counts[t].add(c);
+        }
+      });
+    for (std::thread &th : threads)
+      th.join();
+    p.seconds = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - t0)
+                    .count();
+    for (const Counts &c : counts)
+      p.counts.add(c);
+    points.push_back(p);
+
+    if (cfg.verbosity >= 1)
+      fprintf(stderr,
+              "[STATUS] Eb/N0 %5.2f dB: BER %.3e (%llu / %llu), SER %.3e, "
+              "%.1f Mbit/s\n",
+              p.ebN0, rate(p.counts.bitErrors, p.counts.bits),
+              (unsigned long long)p.counts.bitErrors,
+              (unsigned long long)p.counts.bits,
+              rate(p.counts.symbolErrors, p.counts.symbols),
+              (double)p.counts.bits / p.seconds / 1e6);
+    if (p.counts.bitErrors == 0) {
+      if (cfg.verbosity >= 1)
+        fprintf(stderr, "[NOTE] No errors at %g dB, stopping the sweep.\n",
+                ebN0);
+      break;
+    }
+  }
+
+  FILE *f = stdout;
+  if (!reportFile.empty()) {
+    f = fopen(reportFile.c_str(), "w");
+    if (!f) {
+      fprintf(stderr, "[ERROR] Could not open %s (%s)\n", reportFile.c_str(),
+              strerror(errno));
+      return 1;
+    }
+  }
+  const bool json = reportFile.size() >= 5 &&
+                    reportFile.compare(reportFile.size() - 5, 5, ".json") == 0;
+  if (json)
+    writeJson(f, cfg, points);
+  else
+    writeCsv(f, cfg, points);
+  if (f != stdout)
+    fclose(f);
+  return 0;
+}
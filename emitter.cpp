@@ -5,48 +5,269 @@
  * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
  */
 
+#include <algorithm>
+#include <cerrno>
 #include <chrono>
+#include <csignal>
+#include <cstdint>
 #include <cstdio>
-#include <iostream>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
 #include <thread>
+#include <unistd.h>
+#include <vector>
 
-// In nanosecond precision (=> max possible speed = 1GBps), emit
-// a byte to stdout representing the bit we want to send.
-// 0xff is 1 and 0x00 is 0.
+#include "bit_pattern.h"
+#include "config.h"
+
+// Bits go out packed, MSB first (what ./main reads by default). With
+// --bit-per-byte every bit becomes a whole byte instead, 0xff for 1 and 0x00
+// for 0, which ./main reads with --bit-per-byte (only bit 0 of each byte).
+// --lsb-first flips the order within each byte, same as ./main.
 //
-// Our emit rate should be equal to our baud rate input for ./main
-// Which means it will be R_baud = bytesPerSecond / M (=bits per symbol)
-// clang-format off
-#define M                                 2
-#define BAUD_RATE                       940
-#define EMIT_RATE             BAUD_RATE / M
-#define DELAY_NS      (int) 1e9 / EMIT_RATE
-// clang-format on
-
-// We'll be outputting `EMIT_RATE` number of bytes to stdout every second.
-
-int main(void) {
-  char counter = 0;
-  std::cout << "[NOTE] Desired baud rate    : " << BAUD_RATE << std::endl
-            << "Actual obtainable baud rate : " << (float)1e9 / (DELAY_NS)
-            << std::endl;
-
-  // TODO: Make a cli argument on what pattern of bitstream to generate (all
-  // ones, alternating, random...), also one to control the emit rate.
-  for (;;) {
-    std::this_thread::sleep_for(std::chrono::nanoseconds(DELAY_NS));
-    // std::cout << counter;
-    if (counter % 2)
-      std::cout << 0x00;
+// Our emit rate should be equal to our baud rate input for ./main times the
+// bits per symbol: R_bit = R_baud * M. That's the default, from the same
+// Config ./main uses (so --config, --mod and --baud-rate work here too);
+// --rate picks any other bit rate and --rate 0 takes the brakes off entirely.
+
+using Clock = std::chrono::steady_clock;
+
+// Aim for this many writes a second when throttled: small enough blocks that
+// the output looks smooth to the reader, big enough that we're not a syscall
+// per byte at high rates.
+constexpr double BLOCKS_PER_SECOND = 100.0;
+constexpr size_t MAX_BLOCK_BYTES = 1 << 16;
+constexpr size_t UNTHROTTLED_BLOCK_BYTES = 1 << 18;
+
+/*
+ *  Tokens are output bytes, refilled continuously at `rate` and capped at
+ *  `burst`; the bucket starts empty. A block waits (sleep_until, so no drift
+ *  builds up from sleep overshoot) until there are enough tokens for all of
+ *  it. Over any window the output is within one burst of rate * time,
+ *  however coarse the scheduler's sleep is.
+ */
+class TokenBucket {
+public:
+  TokenBucket(double bytesPerSecond, double burstBytes)
+      : rate(bytesPerSecond), burst(burstBytes), tokens(0),
+        last(Clock::now()) {}
+
+  void acquire(size_t numBytes) {
+    refill();
+    if (tokens < numBytes) {
+      std::chrono::duration<double> wait((numBytes - tokens) / rate);
+      std::this_thread::sleep_until(
+          last + std::chrono::duration_cast<Clock::duration>(wait));
+      refill();
+    }
+    tokens -= numBytes; // May dip just below zero if we woke a bit early
+  }
+
+private:
+  void refill() {
+    Clock::time_point now = Clock::now();
+    double elapsed = std::chrono::duration<double>(now - last).count();
+    tokens = std::min(burst, tokens + rate * elapsed);
+    last = now;
+  }
+
+  double rate, burst, tokens;
+  Clock::time_point last;
+};
+
+// 0 on success, 1 if the reader went away or write failed.
+static int writeAll(const uint8_t *data, size_t numBytes) {
+  while (numBytes > 0) {
+    ssize_t n = write(STDOUT_FILENO, data, numBytes);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      if (errno != EPIPE)
+        fprintf(stderr, "[ERROR] write: %s\n", strerror(errno));
+      return 1;
+    }
+    data += n;
+    numBytes -= size_t(n);
+  }
+  return 0;
+}
+
+// Reads up to numBytes of the passthrough file, rewinding at EOF if looping.
+// Returns bytes read (0 at the end of a non-looping file, -1 on error).
+static ssize_t readFile(int fd, uint8_t *out, size_t numBytes, bool loop) {
+  size_t got = 0;
+  while (got < numBytes) {
+    ssize_t n = read(fd, out + got, numBytes - got);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      fprintf(stderr, "[ERROR] read: %s\n", strerror(errno));
+      return -1;
+    }
+    if (n == 0) {
+      if (!loop || (got == 0 && lseek(fd, 0, SEEK_CUR) == 0))
+        break; // Done, or an empty file we'd loop on forever
+      if (lseek(fd, 0, SEEK_SET) < 0) {
+        fprintf(stderr, "[ERROR] Can't loop a file that can't seek.\n");
+        return -1;
+      }
+      continue;
+    }
+    got += size_t(n);
+  }
+  return ssize_t(got);
+}
+
+// Packed byte -> 8 bytes of 0x00/0xff, first bit first.
+static void expandBits(const uint8_t *packed, size_t numBytes, uint8_t *out) {
+  for (size_t i = 0; i < numBytes; i++)
+    for (int b = 0; b < 8; b++)
+      *out++ = ((packed[i] >> (7 - b)) & 1) ? 0xff : 0x00;
+}
+
+static void reverseBits(uint8_t *data, size_t numBytes) {
+  for (size_t i = 0; i < numBytes; i++) {
+    uint8_t v = data[i];
+    v = uint8_t((v & 0xf0) >> 4 | (v & 0x0f) << 4);
+    v = uint8_t((v & 0xcc) >> 2 | (v & 0x33) << 2);
+    data[i] = uint8_t((v & 0xaa) >> 1 | (v & 0x55) << 1);
+  }
+}
+
+static void usage(const char *prog) {
+  fprintf(stderr,
+          "Usage: %s [--pattern zeros|ones|alt|prbs7|prbs15|prbs23|prbs31] "
+          "[--file path [--loop]] [--rate bits/s | --unthrottled] "
+          "[--bits N] [--block bytes] [main's options]\n",
+          prog);
+  Config::usage(stderr);
+}
+
+int main(int argc, char *argv[]) {
+  Pattern pattern = Pattern::Alternating;
+  std::string inFile; // Passthrough instead of a pattern
+  bool loop = false;
+  double bitRate = -1;    // 0: unthrottled, < 0: baud rate * M from cfg
+  double maxBits = 0;     // 0: forever
+  size_t blockBytes = 0;  // 0: pick from the rate
+  Config cfg;
+
+  for (int a = 1; a < argc; a++) {
+    std::string arg = argv[a];
+    bool hasValue = a + 1 < argc;
+    double value = 0;
+    if (arg == "--pattern" && hasValue) {
+      if (!parsePattern(argv[++a], pattern)) {
+        fprintf(stderr, "[ERROR] Unknown pattern '%s'.\n", argv[a]);
+        return 1;
+      }
+    } else if (arg == "--file" && hasValue)
+      inFile = argv[++a];
+    else if (arg == "--loop")
+      loop = true;
+    else if (arg == "--rate" && hasValue && parseAmount(argv[++a], value))
+      bitRate = value;
+    else if (arg == "--unthrottled")
+      bitRate = 0;
+    else if (arg == "--bits" && hasValue && parseAmount(argv[++a], value))
+      maxBits = value;
+    else if (arg == "--block" && hasValue && parseAmount(argv[++a], value))
+      blockBytes = size_t(value);
+    else {
+      Config::ParseResult r = cfg.parseArg(argc, argv, a);
+      if (r == Config::ParseResult::Error)
+        return 1;
+      if (r == Config::ParseResult::Unknown) {
+        usage(argv[0]);
+        return 1;
+      }
+    }
+  }
+  if (cfg.finalize() != 0)
+    return 1;
+  if (bitRate < 0)
+    bitRate = cfg.baudRate * cfg.bitsPerSymbol;
+  const bool bitPerByte = cfg.inMode == InputMode::BitPerByte;
+  const bool lsbFirst = cfg.inOrder == BitOrder::LsbFirst;
+  const int verbosity = cfg.verbosity;
+
+  // A reader that exits is how most runs end; let write() say EPIPE instead.
+  signal(SIGPIPE, SIG_IGN);
+
+  int fd = -1;
+  if (!inFile.empty()) {
+    fd = open(inFile.c_str(), O_RDONLY);
+    if (fd < 0) {
+      fprintf(stderr, "[ERROR] Could not open %s (%s)\n", inFile.c_str(),
+              strerror(errno));
+      return 1;
+    }
+  }
+
+  // Everything below counts *output* bytes.
+  const size_t expand = bitPerByte ? 8 : 1;
+  const double byteRate = bitRate * expand / 8.0;
+  const bool throttled = bitRate > 0;
+  if (blockBytes == 0)
+    blockBytes = throttled ? std::clamp(size_t(byteRate / BLOCKS_PER_SECOND),
+                                        size_t(1), MAX_BLOCK_BYTES)
+                           : UNTHROTTLED_BLOCK_BYTES;
+  blockBytes = std::max(blockBytes / expand, size_t(1)) * expand;
+  const size_t packedBlock = blockBytes / expand;
+
+  if (verbosity >= 1) {
+    fprintf(stderr, "[NOTE] Emitting %s ",
+            inFile.empty() ? patternName(pattern) : inFile.c_str());
+    if (throttled)
+      fprintf(stderr, "at %.6g bit/s", bitRate);
     else
-      std::cout << 0xff;
+      fprintf(stderr, "unthrottled");
+    fprintf(stderr, " (%zu byte blocks, %s)\n", blockBytes,
+            bitPerByte ? "bit per byte" : "packed");
+  }
+
+  PatternGenerator gen(pattern);
+  TokenBucket bucket(throttled ? byteRate : 1.0, 2.0 * blockBytes);
+  std::vector<uint8_t> packed(packedBlock);
+  std::vector<uint8_t> expanded(bitPerByte ? blockBytes : 0);
+
+  const uint64_t maxPacked =
+      maxBits > 0 ? uint64_t((maxBits + 7) / 8) : UINT64_MAX;
+  uint64_t packedOut = 0;
+  Clock::time_point start = Clock::now();
+
+  while (packedOut < maxPacked) {
+    size_t n = size_t(std::min<uint64_t>(packedBlock, maxPacked - packedOut));
+    if (fd >= 0) {
+      ssize_t got = readFile(fd, packed.data(), n, loop);
+      if (got <= 0)
+        break;
+      n = size_t(got);
+    } else
+      gen.fill(packed.data(), n);
+
+    if (lsbFirst)
+      reverseBits(packed.data(), n);
+    const uint8_t *out = packed.data();
+    if (bitPerByte) {
+      expandBits(packed.data(), n, expanded.data());
+      out = expanded.data();
+    }
+    if (throttled)
+      bucket.acquire(n * expand);
+    if (writeAll(out, n * expand) != 0)
+      break;
+    packedOut += n;
+  }
 
-    // TODO: Write bytes themselves and not chars, though is there really a
-    // difference? char bit = 0x00;
-    // // std::cout.write(&bit, 1);
-    // fwrite(&bit, 1, 1, stdout);
-    // fflush(stdout);
-    counter++;
+  if (verbosity >= 1) {
+    double secs = std::chrono::duration<double>(Clock::now() - start).count();
+    fprintf(stderr, "[STATUS] %llu bits in %.3f s (%.6g bit/s)\n",
+            (unsigned long long)(packedOut * 8), secs,
+            secs > 0 ? packedOut * 8 / secs : 0.0);
   }
+  if (fd >= 0)
+    close(fd);
   return 0;
 }
@@ -0,0 +1,62 @@
+/*
+ * bit_pattern.h - Deterministic test bit patterns (constant, alternating, PRBS).
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class Pattern {
+  Zeros,
+  Ones,
+  Alternating, // 1010... (0xaa bytes)
+  PRBS7,       // x^7 + x^6 + 1
+  PRBS15,      // x^15 + x^14 + 1
+  PRBS23,      // x^23 + x^18 + 1
+  PRBS31,      // x^31 + x^28 + 1
+};
+
+// Accepts zeros, ones, alt, prbs7, prbs15, prbs23, prbs31.
+// Returns false (and leaves `pattern` alone) for anything else.
+bool parsePattern(const std::string &name, Pattern &pattern);
+const char *patternName(Pattern pattern);
+
+/*
+ *  Packed bits, MSB first (the BitStreamReader default). The PRBS polynomials
+ *  are the ITU-T O.150 ones; every LFSR starts from the all-ones state so two
+ *  generators of the same pattern always agree.
+ *
+ *  Anything with a period that fits in a few tens of KB (everything up to
+ *  PRBS15) is rendered once and then memcpy'd out. PRBS23/31 run the LFSR a
+ *  whole number of bytes at a time: with only two taps, the next w bits
+ *  depend on history at least (shorter tap) bits old, so as long as w is no
+ *  bigger than that they all come out of one shift-and-XOR.
+ */
+class PatternGenerator {
+public:
+  explicit PatternGenerator(Pattern pattern);
+
+  void fill(uint8_t *out, size_t numBytes);
+  void reset(); // Back to the start of the sequence
+
+  Pattern pattern() const { return pat; }
+  // Sequence period in bits (1 for constants, 2 for alternating).
+  uint64_t periodBits() const;
+
+private:
+  void stepBytes(uint8_t *out, size_t numBytes);
+
+  Pattern pat;
+  unsigned degree = 0;    // LFSR length n
+  unsigned tap = 0;       // Shorter tap k
+  unsigned stepBits = 0;  // Bits per LFSR step (multiple of 8, <= tap)
+  uint64_t history = 0;   // Last `degree` output bits, newest in bit 0
+  std::vector<uint8_t> period; // Rendered period (short patterns only)
+  size_t periodPos = 0;
+};
@@ -0,0 +1,76 @@
+/*
+ * bit_stream_reader.h - Block based bits -> M-bit symbol index front end.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ *  Pulls large chunks off a file descriptor with read(2) into a ring buffer
+ *  and slices them into M-bit symbol indices, a whole array per call.
+ *
+ *  The first bit read becomes the MSB of the symbol index, same as the old
+ *  `rxBit = (rxBit << 1) ^ dataBit` accumulator in main.cpp.
+ */
+
+enum class InputMode {
+  Packed,     // Every bit of every byte is data
+  BitPerByte, // Only bit 0 of each byte is data (what emitter.cpp speaks)
+};
+
+enum class BitOrder {
+  MsbFirst, // Bit 7 of a byte goes out first
+  LsbFirst, // Bit 0 of a byte goes out first
+};
+
+class BitStreamReader {
+public:
+  static constexpr size_t DEFAULT_CHUNK_BYTES = 64 << 10; // 64 KiB
+
+  BitStreamReader(int fd, size_t bitsPerSymbol,
+                  InputMode mode = InputMode::Packed,
+                  BitOrder order = BitOrder::MsbFirst,
+                  size_t chunkBytes = DEFAULT_CHUNK_BYTES);
+
+  // Fill up to maxSymbols indices; returns how many were written. Only
+  // blocks (on read(2)) while it has nothing to hand back, so it can come
+  // back short of maxSymbols whenever the input is slower than the caller:
+  // only 0 means the end of the stream. Loop until 0 to fill a whole buffer.
+  size_t readSymbols(uint8_t *symbols, size_t maxSymbols);
+  size_t readSymbols(std::vector<uint8_t> &symbols) {
+    return readSymbols(symbols.data(), symbols.size());
+  }
+
+  bool eof() const { return inputDone && head == tail && accBits < M; }
+  // Bits left over at end of stream that did not make up a whole symbol.
+  size_t danglingBits() const { return eof() ? accBits : 0; }
+  size_t bytesRead() const { return totalBytes; }
+
+private:
+  size_t refill();
+  size_t available() const { return tail - head; }
+
+  int fd;
+  size_t M;
+  uint64_t symMask;
+  InputMode mode;
+  BitOrder order;
+
+  // Ring buffer. head/tail are free running, wrapped with ringMask.
+  std::vector<uint8_t> ring;
+  size_t ringMask;
+  size_t head = 0;
+  size_t tail = 0;
+  bool inputDone = false;
+  size_t totalBytes = 0;
+
+  // Bit accumulator; the oldest bit sits at position accBits - 1.
+  uint64_t acc = 0;
+  size_t accBits = 0;
+};
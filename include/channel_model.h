@@ -0,0 +1,94 @@
+/*
+ * channel_model.h - AWGN, carrier offset, clock drift and multipath.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gaussian_noise.h"
+#include "nco.h"
+
+// One path of a tapped delay line.
+struct ChannelPath {
+  size_t delay; // Samples
+  std::complex<float> gain;
+};
+
+// "delay:gain[@degrees],..." e.g. "0:1,3:0.4@90". False on junk.
+bool parseMultipath(const std::string &text, std::vector<ChannelPath> &paths);
+
+struct ChannelSettings {
+  float esN0 = INFINITY;          // dB; infinite: no noise
+  double freqOffset = 0.0;        // Hz
+  float phaseOffset = 0.0f;       // Degrees
+  double clockPpm = 0.0;          // Sample clock offset
+  std::vector<ChannelPath> paths; // Empty: one unit path
+  uint64_t seed = 1;
+
+  bool active() const {
+    return std::isfinite(esN0) || freqOffset != 0.0 || phaseOffset != 0.0f ||
+           clockPpm != 0.0 || !paths.empty();
+  }
+};
+
+/*
+ *  What happens to the samples between main and the receiver, in order:
+ *
+ *  - Multipath: y[n] = sum_k g_k x[n - d_k], the gains scaled to unit total
+ *    power so Es/N0 stays the average received one. One complex
+ *    multiply-accumulate pass per path, 4 samples a step with AVX2.
+ *  - Clock offset: the receiver's sample clock runs clockPpm fast, so it
+ *    takes a sample every 1 / (1 + ppm 1e-6) transmitted ones (more of
+ *    them, slowly sliding against the symbols). Cubic Lagrange
+ *    interpolation between the four nearest.
+ *  - Carrier: a frequency and phase offset, through the NCO.
+ *  - AWGN at esN0 for samplesPerSymbol samples of unit average power per
+ *    symbol (what main generates): N0 = sps / 10^(esN0 / 10), half of it
+ *    per component. GaussianNoise, so a seed gives the same noise every run
+ *    whatever the block sizes.
+ *
+ *  Everything is carried between calls; blocks can be cut anywhere.
+ */
+class ChannelModel {
+public:
+  ChannelModel(const ChannelSettings &settings, double sampleRate,
+               double samplesPerSymbol);
+
+  // Writes up to maxOutput(n) samples to out (which may be in), returns
+  // how many.
+  size_t process(const std::complex<float> *in, size_t n,
+                 std::complex<float> *out);
+  size_t maxOutput(size_t n) const {
+    return drifting ? (size_t)((n + CARRIED) / step) + 2 : n;
+  }
+  float noiseSigma() const { return sigma; } // Per component
+
+private:
+  static constexpr size_t CARRIED = 3; // Interpolator history
+
+  void fade(const std::complex<float> *in, size_t n, std::complex<float> *out);
+  size_t resample(std::complex<float> *out);
+
+  std::vector<ChannelPath> paths;
+  size_t maxDelay = 0;
+  std::vector<std::complex<float>> history; // maxDelay inputs + the block
+
+  bool drifting;
+  double step;                            // Input samples per output
+  double when;                            // Next output, index into faded
+  std::vector<std::complex<float>> faded; // Carried + faded block
+
+  bool rotating;
+  NCO rotator;
+  float sigma;
+  GaussianNoise noise;
+};
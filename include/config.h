@@ -0,0 +1,170 @@
+/*
+ * config.h - Runtime configuration: CLI, INI or JSON, validated once.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <string>
+
+#include "bit_stream_reader.h"
+#include "channel_model.h"
+#include "ofdm.h"
+#include "packet.h"
+#include "spectrum_monitor.h"
+#include "symbol_mapper.h"
+
+// clang-format off
+constexpr float  RAD2DEG(float radians) { return (float) (radians * 180 / constellation::PI); }
+constexpr float  DEG2RAD(float degrees) { return (float) (degrees * constellation::PI / 180); }
+constexpr size_t fVEC_SIZE(std::span<const std::complex<float>> vec){ return (size_t) 2 * vec.size() * sizeof(float); }
+// clang-format on
+
+// "2.56M" -> 2.56e6; k, M and G suffixes. False on junk or a negative value.
+bool parseAmount(const std::string &text, double &value);
+
+// Samples per symbol as num / den in lowest terms (sampleRate / baudRate).
+struct SampleRatio {
+  uint64_t num = 1;
+  uint64_t den = 1;
+
+  bool integer() const { return den == 1; }
+  size_t floor() const { return num / den; }
+  size_t ceil() const { return (num + den - 1) / den; }
+  double value() const { return (double)num / den; }
+};
+
+/*
+ *  How many samples the next symbol gets when sps isn't a whole number.
+ *  Symbol n spans samples [floor(n*num/den), floor((n+1)*num/den)), so the
+ *  lengths are floor(sps) or ceil(sps) and never drift: after any number of
+ *  symbols the sample count is exact to within one sample. One add and one
+ *  compare per symbol, nothing divides in the loop.
+ */
+class SymbolClock {
+public:
+  explicit SymbolClock(SampleRatio sps)
+      : whole(sps.num / sps.den), frac(sps.num % sps.den), den(sps.den) {}
+
+  size_t next() {
+    acc += frac;
+    if (acc >= den) {
+      acc -= den;
+      return whole + 1;
+    }
+    return whole;
+  }
+
+private:
+  size_t whole;
+  uint64_t frac, den;
+  uint64_t acc = 0;
+};
+
+// What rx writes out.
+enum class RxOutput {
+  Symbols,  // cf32, one sample per symbol
+  HardBits, // Packed bytes, MSB first: what main reads
+  SoftBits, // int8 LLRs, one per bit, positive means 0
+};
+
+/*
+ *  One object for everything that used to be baked in at compile time.
+ *  Settings can come from a config file (INI `key = value` lines, or a flat
+ *  JSON object with the same keys) and from the command line (`--key value`,
+ *  `--flag`), applied in order so later ones win. finalize() validates the
+ *  lot once and fills in the derived fields the hot loops use; nothing after
+ *  that should touch the settings.
+ */
+struct Config {
+  enum class ParseResult { Ok, Unknown, Error };
+
+  // *** === Settings === ***
+  Modulation mod = Modulation::QPSK;
+  double carrierFreq = 2440.0; // Hz
+  double sampleRate = 1e6;     // Samples/s
+  double baudRate = 940.0;     // Symbols/s
+  bool shaped = true;          // RRC pulses; false for rectangular ones
+  float rollOff = 0.35f;
+  size_t spanSymbols = 8;
+  // RRC at this many samples a symbol and a Farrow resampler to sampleRate
+  // (main interpolates, rx decimates first). 0: main shapes at the exact
+  // ratio, rx filters at sampleRate; finalize() picks 4 if the exact ratio
+  // needs too many filter phases.
+  size_t oversample = 0;
+
+  // CCSDS r=1/2 K=7 convolutional code: main encodes, rx decodes.
+  bool convolutional = false;
+  bool invertG2 = true; // CCSDS inverts G2; some (Meteor LRPT) don't
+  // CCSDS transfer frames: 0x1ACFFC1D, then frameBytes (0: no framing),
+  // PN randomized unless told otherwise and optionally RS(255,223) coded
+  // at interleave depth rsDepth (frameBytes = 255 * rsDepth).
+  size_t frameBytes = 0;
+  unsigned rsDepth = 0;
+  bool randomize = true;
+  // Alternating opposite symbols ahead of the first frame, so rx's loops
+  // have locked by its marker (framed output only).
+  size_t preambleSymbols = 256;
+  // Packets (packet.h) of up to packet.maxPayload bytes in the frame bodies
+  // instead of the raw input; rx checks them with --demap hard.
+  PacketSettings packet;
+
+  // main: impairments between the generator and the file (off by default).
+  ChannelSettings channel;
+
+  // OFDM instead of a single carrier when ofdm.fftSize > 0 (main and rx).
+  // The baud rate and pulse shape don't apply then; the carrier does.
+  OfdmSettings ofdm;
+
+  // PSD, constellation and eye summary files (off unless monitor.prefix).
+  MonitorSettings monitor;
+
+  InputMode inMode = InputMode::Packed;
+  BitOrder inOrder = BitOrder::MsbFirst;
+
+  std::string inFile = "./data/qpsk.iq";  // rx: recording to demodulate
+  std::string outFile = "./data/qpsk.iq"; // Format follows the extension
+  float fullScale = 1.5f; // Amplitude that maps to integer full scale
+  bool dither = false;
+
+  float timingBw = 0.01f;   // rx: Gardner loop BnTs
+  float carrierBw = 0.005f; // rx: Costas loop BnTs
+  RxOutput rxOutput = RxOutput::Symbols;
+
+  bool threaded = true; // One thread per stage (finalize() checks cores)
+  bool pinCpus = false;
+  int verbosity = 0; // 0: quiet, 1: status notes, 2: per-symbol chatter
+  // Stage stats (builds with QPSK_STATS, make STATS=1): a stderr summary
+  // every statsInterval seconds (0: off) and/or a JSON snapshot on a socket.
+  double statsInterval = 0.0;
+  std::string statsSocket;
+
+  // *** === Derived by finalize() === ***
+  size_t bitsPerSymbol = 0; // M
+  size_t numSymbols = 0;    // 2^M
+  SampleRatio sps;
+  // Whole number of carrier cycles per (whole number of samples per) symbol,
+  // so every symbol starts at the same carrier phase.
+  bool carrierInTable = false;
+  // With oversample: the RRC's band in cycles per sample at K samples a
+  // symbol, (1 + rollOff) / 2K, what the resamplers have to keep.
+  double resamplerPassband = 0.0;
+
+  // key is the long option name without dashes. Flags take true/false.
+  int set(const std::string &key, const std::string &value);
+  // By extension: .json is JSON, anything else INI.
+  int load(const std::string &path);
+  // Handles argv[a] (and its value, advancing a). --config loads a file.
+  ParseResult parseArg(int argc, char *argv[], int &a);
+  int finalize();
+
+  void print(FILE *f) const;
+  static void usage(FILE *f);
+};
@@ -0,0 +1,105 @@
+/*
+ * convolutional_code.h - CCSDS r=1/2 K=7 convolutional encoder and Viterbi.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ *  CCSDS 131.0-B: G1 = 171, G2 = 133 (octal), G1's symbol first and G2's
+ *  inverted. Meteor-M2 LRPT and a lot of older kit don't invert G2, hence
+ *  the switch.
+ *
+ *  Bits are one per byte (0/1) on both sides, like Demapper::hard(). The
+ *  register holds the last six input bits, newest in bit 0, so the taps
+ *  are the octal polynomials mirrored: 0x4F and 0x6D on the 7 bit window
+ *  (state << 1) | bit.
+ */
+namespace conv {
+constexpr unsigned K = 7;
+constexpr unsigned NUM_STATES = 1 << (K - 1);
+constexpr unsigned POLY_A = 0x4F; // 171 octal, mirrored
+constexpr unsigned POLY_B = 0x6D; // 133 octal, mirrored
+} // namespace conv
+
+class ConvEncoder {
+public:
+  explicit ConvEncoder(bool invertG2 = true);
+
+  // 2 * numBits coded bits to out. Returns how many.
+  size_t encode(const uint8_t *bits, size_t numBits, uint8_t *out);
+  // Six zeros to bring the register back to state 0 (12 coded bits), so
+  // the decoder can end on a known state.
+  size_t flush(uint8_t *out);
+  void reset() { state = 0; }
+
+private:
+  uint8_t outputs[2 * conv::NUM_STATES]; // Coded pair per 7 bit window
+  unsigned state = 0;
+};
+
+enum class ViterbiKernel {
+  Auto,   // AVX2 when built for it, else scalar
+  Scalar, // Reference, bit for bit the same decisions (tests/units.cpp)
+};
+
+/*
+ *  Soft decision, streaming. Input is int8 LLRs, two per data bit in
+ *  encoder order, positive meaning 0 (what Demapper::soft() writes); 0 is
+ *  an erasure, so punctured positions can be filled with zeros.
+ *
+ *  Path metrics are int16 (saturating, rebased every RENORM_STEPS steps)
+ *  and the add-compare-select works on butterflies: the two states i and
+ *  i + 32 feed 2i and 2i + 1, and because both taps include the newest and
+ *  oldest bits, the four branch metrics are +-g for a single g per pair.
+ *  With AVX2 that's all 32 butterflies in two registers' worth of adds,
+ *  maxes and compares per bit, the 64 decisions coming out as one movemask
+ *  each (a 64 bit word per step).
+ *
+ *  Decisions are kept for the traceback depth plus whatever hasn't been
+ *  output yet. Each decode() call traces back once from the best state and
+ *  releases every bit older than tracebackDepth, so the cost of the
+ *  traceback is spread over the whole call, not paid per bit.
+ */
+class ViterbiDecoder {
+public:
+  static constexpr size_t DEFAULT_TRACEBACK = 96; // ~14 K, plenty at r=1/2
+  static constexpr size_t RENORM_STEPS = 32;
+
+  explicit ViterbiDecoder(size_t tracebackDepth = DEFAULT_TRACEBACK,
+                          bool invertG2 = true,
+                          ViterbiKernel kernel = ViterbiKernel::Auto);
+
+  // numLlrs / 2 steps (an odd one out waits for its partner). Writes the
+  // decoded bits that are now tracebackDepth old; returns how many. out
+  // needs room for numLlrs / 2 + pending() bits.
+  size_t decode(const int8_t *llrs, size_t numLlrs, uint8_t *out);
+  // Everything still pending. terminated: the encoder was flushed, so
+  // trace back from state 0 instead of the best one.
+  size_t flush(uint8_t *out, bool terminated = false);
+  void reset();
+
+  size_t pending() const { return decisions.size(); }
+
+private:
+  void steps(const int8_t *llrs, size_t numSteps);
+  void stepsScalar(const int8_t *llrs, size_t numSteps, uint64_t *dec);
+  size_t traceback(unsigned state, size_t numOut, uint8_t *out);
+  unsigned bestState() const;
+
+  size_t depth;
+  bool scalar;
+  int16_t signA[conv::NUM_STATES / 2]; // +-1: G1 bit of butterfly i is 0/1
+  int16_t signB[conv::NUM_STATES / 2];
+  alignas(32) int16_t metrics[conv::NUM_STATES];
+  std::vector<uint64_t> decisions; // Oldest first
+  size_t sinceRenorm = 0;
+  int8_t heldLlr = 0;
+  bool holding = false;
+};
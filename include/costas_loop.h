@@ -0,0 +1,58 @@
+/*
+ * costas_loop.h - Decision directed carrier phase/frequency recovery.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <span>
+
+#include "loop_filter.h"
+#include "symbol_mapper.h"
+
+/*
+ *  Runs on timing recovered symbols (one per symbol, unit average energy)
+ *  and rotates them back onto the constellation:
+ *
+ *    y = x * e^{-j phase};  e = Im{y * conj(d)}  with d the decision for y
+ *    freq += Ki * e;  phase += freq + Kp * e
+ *
+ *  BPSK and QPSK have closed form decisions (signs), so their detector is
+ *  the classic Costas one; every other constellation searches the table
+ *  from symbol_mapper.h. e is scaled so the slope is 1 per radian for all
+ *  of them, which makes the bandwidth mean the same thing.
+ *
+ *  The loop is inherently one symbol at a time, but it only runs at the
+ *  symbol rate, after all the per-sample work. There is an M-fold phase
+ *  ambiguity (the loop can't tell one rotation of the constellation from
+ *  another); that's for the frame sync to sort out.
+ */
+class CostasLoop {
+public:
+  // loopBandwidth is BnTs (per symbol).
+  explicit CostasLoop(Modulation mod, float loopBandwidth = 0.005f,
+                      float damping = 0.707f);
+
+  // in == out is fine.
+  void process(const std::complex<float> *in, size_t numSymbols,
+               std::complex<float> *out);
+  void reset();
+
+  double phase() const { return phaseAcc; }    // Radians
+  double frequency() const { return freqAcc; } // Radians per symbol
+  float phaseError() const { return lastError; }
+
+private:
+  float detect(std::complex<float> y) const;
+
+  Modulation mod;
+  std::span<const std::complex<float>> points;
+  LoopGains gains;
+  double phaseAcc = 0.0;
+  double freqAcc = 0.0;
+  float lastError = 0.0f;
+};
@@ -0,0 +1,125 @@
+/*
+ * demapper.h - Symbols back to hard bits or int8 max-log LLRs.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "symbol_mapper.h"
+
+/*
+ *  The inverse of Mapper: one symbol in, BITS_PER_SYMBOL bits out, in the
+ *  order BitStreamReader took them (label MSB first).
+ *
+ *  Soft output is the max-log LLR, positive meaning 0:
+ *
+ *    LLR(b) = (min |y - s|^2 over s with b = 1
+ *            - min |y - s|^2 over s with b = 0) / N0
+ *
+ *  quantized to int8 in steps of LLR_STEP and clipped to +-127 (-128 is
+ *  never produced, so negating a value is always safe). Hard bits are the
+ *  signs, i.e. the bits of the nearest point.
+ *
+ *  BPSK and QPSK are linear in I and Q (Gray coding on each axis), so they
+ *  skip the search. Everything else goes through a kernel templated on the
+ *  order that takes eight symbols at a time in SoA registers and keeps a
+ *  running minimum per bit and bit value across the table: 2^M distances
+ *  and M * 2^M mins per eight symbols, against a table known at compile
+ *  time. Square QAM splits into an I and a Q search over sqrt(2^M) levels
+ *  each (the other axis' distance cancels). The float LLRs are then scaled
+ *  and packed to int8 32 at a time.
+ *
+ *  N0 is per complex symbol (E|n|^2) with unit energy symbols, which is what
+ *  GardnerTimingRecovery hands out. It can be set or tracked from the
+ *  distance to the decisions (estimateNoise()).
+ */
+class Demapper {
+public:
+  static constexpr float LLR_STEP = 0.25f; // LLR units per int8 step
+  static constexpr size_t NOISE_SKIP = 512;
+  static constexpr size_t NOISE_SETTLE = 1024;
+
+  explicit Demapper(Modulation mod, float noiseVariance = 0.1f);
+
+  // bitsPerSymbol() * numSymbols outputs, one bit per byte (0/1).
+  size_t hard(const std::complex<float> *symbols, size_t numSymbols,
+              uint8_t *bits) const;
+  // bitsPerSymbol() * numSymbols LLRs.
+  size_t soft(const std::complex<float> *symbols, size_t numSymbols,
+              int8_t *llrs) const;
+
+  // Folds this batch's mean squared error to the decisions into N0. The
+  // first NOISE_SKIP symbols (the loops pulling in) aren't counted; N0 stays
+  // as constructed until NOISE_SETTLE more have been, their mean seeds it
+  // and an exponential average takes over. High SNR only: at low SNR
+  // decision errors make it read low.
+  void estimateNoise(const std::complex<float> *symbols, size_t numSymbols);
+  void setNoiseVariance(float n0) { noiseVar = n0; }
+  float noiseVariance() const { return noiseVar; }
+
+  size_t bitsPerSymbol() const { return bits; }
+  Modulation modulation() const { return mod; }
+
+private:
+  Modulation mod;
+  size_t bits;
+  std::span<const std::complex<float>> points;
+  float noiseVar;
+  size_t noiseSkipped = 0;
+  size_t noiseCount = 0; // Symbols in noiseSum, up to NOISE_SETTLE
+  double noiseSum = 0.0;
+};
+
+/*
+ *  OQPSK to QPSK. OQPSK delays Q by half a symbol, so at the symbol strobe
+ *  I is at its peak and Q is mid transition. Fed samples at two per symbol
+ *  the way GardnerTimingRecovery with emitMidpoints() hands them out
+ *  (midpoint k, strobe k, midpoint k + 1, ...), this drops the first
+ *  midpoint and pairs the I of each strobe with the Q of the midpoint
+ *  after it, {strobe_k.I, mid_k+1.Q}: ordinary QPSK symbols, ready for the
+ *  Costas loop and Demapper. A half symbol left over at the end of a call
+ *  is kept.
+ *
+ *  A stream that starts on a strobe instead (nothing dropped) takes one
+ *  skipHalfSymbol() after reset() to cancel the drop.
+ */
+class OqpskRealigner {
+public:
+  // numSamples half symbols in, returns the number of symbols written
+  // (at most (numSamples + 1) / 2). in == out is fine.
+  size_t process(const std::complex<float> *in, size_t numSamples,
+                 std::complex<float> *out);
+  void skipHalfSymbol() { skipNext = !skipNext; }
+  void reset() {
+    havePending = false;
+    skipNext = true;
+  }
+
+private:
+  float pendingI = 0.0f;
+  bool havePending = false;
+  bool skipNext = true; // Gardner's first midpoint has no strobe before it
+};
+
+/*
+ *  Hard bits (one per byte) back into bytes, MSB first, for writing the
+ *  same packed format BitStreamReader reads. A partial byte waits for the
+ *  next call.
+ */
+class BitPacker {
+public:
+  // Writes numBits / 8 bytes (give or take the carried partial byte).
+  size_t pack(const uint8_t *bits, size_t numBits, uint8_t *out);
+  size_t pendingBits() const { return count; }
+
+private:
+  uint8_t acc = 0;
+  size_t count = 0;
+};
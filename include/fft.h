@@ -0,0 +1,63 @@
+/*
+ * fft.h - Split radix FFT with cached plans and batched transforms.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+/*
+ *  Complex FFT of a power of two size, split radix decimation in time: an
+ *  m point transform is one of m/2 (even samples) and two of m/4 (samples
+ *  1 and 3 mod 4), put together with w^k and w^3k, which takes fewer
+ *  multiplies than radix 2 or 4. The recursion goes depth first, so the
+ *  small transforms run out of L1 whatever the size.
+ *
+ *  Everything that depends on the size only is worked out once in the plan:
+ *  each level's w_m^k and w_m^3k, k < m/4, laid out next to each other so
+ *  the butterfly loops read them with unit stride (4 at a time with AVX2 or
+ *  NEON), in both directions. A plan is immutable, so one can be shared by
+ *  any number of threads; cached() hands out one per size.
+ *
+ *  Transforms are out of place (in and out must not overlap) and
+ *  unnormalized both ways: inverse(forward(x)) == size() * x. The batched
+ *  calls run count transforms back to back, the i-th one reading
+ *  in + i * inDist and writing out + i * outDist (0: size()), which lets
+ *  OFDM go straight from frequency bins into slots behind cyclic prefixes.
+ */
+class FftPlan {
+public:
+  static constexpr size_t MAX_SIZE = size_t(1) << 20;
+
+  // n must be a power of two, 1 <= n <= MAX_SIZE.
+  explicit FftPlan(size_t n);
+  // The shared plan for n, built on first use (thread safe).
+  static const FftPlan &cached(size_t n);
+  static bool validSize(size_t n) {
+    return n >= 1 && n <= MAX_SIZE && (n & (n - 1)) == 0;
+  }
+
+  size_t size() const { return n; }
+
+  // out[k] = sum_j in[j] e^(-2 pi i jk / n)
+  void forward(const std::complex<float> *in, std::complex<float> *out,
+               size_t count = 1, size_t inDist = 0, size_t outDist = 0) const;
+  // out[j] = sum_k in[k] e^(+2 pi i jk / n)
+  void inverse(const std::complex<float> *in, std::complex<float> *out,
+               size_t count = 1, size_t inDist = 0, size_t outDist = 0) const;
+
+private:
+  template <bool Inverse>
+  void transform(const std::complex<float> *in, size_t stride,
+                 std::complex<float> *out, size_t m) const;
+
+  size_t n;
+  // Level m (m >= 8) starts at offset[log2 m]: m/4 w^k, then m/4 w^3k.
+  std::vector<std::complex<float>> fwdTwiddles, invTwiddles;
+  std::vector<size_t> offset;
+};
@@ -0,0 +1,84 @@
+/*
+ * fir_filter.h - Streaming real-tap FIR over complex samples.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+#include "fft.h"
+
+enum class FirMethod {
+  Auto,       // Overlap-save from FirFilter::FFT_THRESHOLD taps up
+  Direct,     // Time domain, the SIMD kernel below
+  OverlapSave // Frequency domain
+};
+
+/*
+ *  y[n] = sum_k h[k] x[n - k], one output per input, with the last T - 1
+ *  inputs carried between calls so blocks can be any size.
+ *
+ *  The direct kernel runs over taps on the outside and outputs on the
+ *  inside: h[k] is broadcast and multiplied into eight outputs' worth of
+ *  interleaved input at once (two AVX registers, two FMA chains), so there
+ *  are no horizontal sums and no shuffles. Taps are stored reversed so that
+ *  walks forward through memory too.
+ *
+ *  That is T multiply-adds an output; long filters go through the FFT
+ *  instead, overlap-save: each N point transform of T - 1 old and
+ *  L = N - T + 1 new inputs is multiplied by the filter's spectrum
+ *  (computed once, 1/N folded in), transformed back, and its last L
+ *  outputs are the linear convolution (the first T - 1 wrapped around and
+ *  are thrown away). N is the power of two at about 8T, which keeps the
+ *  cost per output near 2 log2 N. Blocks that aren't a whole number of
+ *  segments end on a zero padded segment, or on the direct kernel if the
+ *  remainder is short enough for that to be cheaper, so there is no added
+ *  latency and the output is the direct form's, to float rounding. The
+ *  plan, spectrum and segment buffers are made once and reused by every
+ *  call.
+ *
+ *  setTaps() swaps the taps keeping the history (for adaptive filters):
+ *  only the spectrum is recomputed, one forward FFT, as long as the new
+ *  taps still fit the transform.
+ */
+class FirFilter {
+public:
+  // Where overlap-save overtakes the direct kernel (bench fir/, AVX2+FMA).
+  static constexpr size_t FFT_THRESHOLD = 128;
+
+  explicit FirFilter(std::vector<float> taps,
+                     FirMethod method = FirMethod::Auto);
+
+  // Writes numSamples outputs (out may not alias in). Returns numSamples.
+  size_t filter(const std::complex<float> *in, size_t numSamples,
+                std::complex<float> *out);
+  void reset();
+  // New taps (any length), the input history carried over.
+  void setTaps(std::vector<float> taps);
+
+  const std::vector<float> &taps() const { return coefficients; }
+  size_t delay() const { return (coefficients.size() - 1) / 2; }
+  bool overlapSave() const { return fft != nullptr; }
+  size_t fftSize() const { return fft ? fft->size() : 0; }
+
+private:
+  void plan();
+  void filterDirect(size_t numSamples, std::complex<float> *out);
+  void filterFft(size_t numSamples, std::complex<float> *out);
+
+  FirMethod method;
+  std::vector<float> coefficients;
+  std::vector<float> reversed;           // h[T-1 .. 0]
+  std::vector<std::complex<float>> work; // T-1 history samples + new ones
+
+  // Overlap-save
+  const FftPlan *fft = nullptr;
+  std::vector<std::complex<float>> spectrum; // H[k] / N
+  std::vector<std::complex<float>> bins;     // One segment, frequency domain
+  std::vector<std::complex<float>> segment;  // One segment, time domain
+};
@@ -0,0 +1,143 @@
+/*
+ * frame_sync.h - CCSDS attached sync marker search and PN randomizer.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "symbol_mapper.h"
+
+namespace ccsds {
+constexpr uint64_t ASM = 0x1ACFFC1D; // Attached sync marker, sent MSB first
+constexpr unsigned ASM_BITS = 32;
+} // namespace ccsds
+
+// The phase ambiguities a marker is searched under: what the Costas loop may
+// have locked to, plus spectral inversion (I and Q swapped somewhere).
+enum class Ambiguity {
+  None, // Already resolved (e.g. after the Viterbi decoder)
+  Bpsk, // As sent or inverted
+  Qpsk, // Four rotations, conjugated or not
+};
+
+inline Ambiguity ambiguityFor(Modulation mod) {
+  switch (mod) {
+  case Modulation::BPSK:
+    return Ambiguity::Bpsk;
+  case Modulation::QPSK:
+    return Ambiguity::Qpsk;
+  default:
+    return Ambiguity::None; // Not searched: the marker has to arrive as is
+  }
+}
+
+/*
+ *  Finds frames in a stream of int8 LLRs (Demapper::soft(), positive meaning
+ *  0) and hands them out whole, the ambiguity undone.
+ *
+ *  A frame is periodBits long with the marker markerAt bits in (normally 0:
+ *  marker first). The marker is up to 64 bits (MSB first), by default the
+ *  CCSDS ASM. Under QPSK a rotation shuffles and inverts the two bits of a
+ *  symbol, so each of the eight variants is a different pattern, and frames
+ *  are assumed to start on a symbol (an even bit).
+ *
+ *  Searching: every position is tested against every variant's pattern on
+ *  the hard decisions (the LLR signs, packed 64 per word by movemask):
+ *  one xor and popcount each, a candidate if at most markerBits / 10 bits
+ *  differ. Candidates are ranked by soft correlation, the dot product of
+ *  the LLRs with the pattern's +-1s over their magnitudes, done 32 LLRs a
+ *  step with AVX2. Where the LLRs have no magnitude at all it is the hard
+ *  bits' agreement instead, so a lock never hangs on the soft scale.
+ *
+ *  Locked: only the next expected position is looked at, with the soft
+ *  correlation of the locked variant. A frame whose marker doesn't make
+ *  LOCKED_CORRELATION still goes out (flywheel); MAX_MISSES in a row and
+ *  the search starts again.
+ */
+class FrameSync {
+public:
+  static constexpr float LOCKED_CORRELATION = 0.5f; // ~8 of 32 bits wrong
+  static constexpr unsigned MAX_MISSES = 3;
+
+  FrameSync(size_t periodBits, Ambiguity ambiguity,
+            uint64_t marker = ccsds::ASM, unsigned markerBits = ccsds::ASM_BITS,
+            size_t markerAt = 0, bool keepMarker = false);
+
+  // Writes frames of frameBits() LLRs each to frames, at most maxFrames(n):
+  // what follows the marker, or with keepMarker the whole frame. Returns
+  // how many.
+  size_t process(const int8_t *llrs, size_t n, int8_t *frames);
+  size_t maxFrames(size_t n) const { return (fill + n) / period + 1; }
+  size_t frameBits() const {
+    return keepMarker ? period : period - markerAt - markerBits;
+  }
+  void reset();
+
+  bool locked() const { return lock; }
+  unsigned rotation() const { return variants[current].rotation; } // Degrees
+  bool conjugated() const { return variants[current].conjugated; }
+  size_t framesFound() const { return numFrames; }
+  size_t lockLosses() const { return numLosses; }
+
+private:
+  struct Variant {
+    uint64_t pattern; // Hard bits as received, LSB first
+    uint64_t mask;    // Bits the pattern pins down
+    alignas(32) int8_t signs[64]; // +-1 (0 outside the mask)
+    // Received bit i of a symbol is sent bit src[i], inverted if flip[i].
+    uint8_t src[2];
+    bool flip[2];
+    unsigned rotation;
+    bool conjugated;
+  };
+
+  bool search();
+  float correlation(size_t p, const Variant &v) const;
+  uint64_t window(size_t p) const;
+  void packSigns(size_t from);
+  void undo(int8_t *llrs, size_t n, const Variant &v) const;
+
+  size_t period;
+  unsigned markerBits;
+  size_t markerAt;
+  bool keepMarker;
+  size_t step; // Bits per symbol the ambiguity works on
+  unsigned maxErrors;
+  std::vector<Variant> variants;
+
+  std::vector<int8_t> buf; // Unconsumed LLRs, zero padded
+  std::vector<uint64_t> hard;
+  size_t fill = 0;
+  size_t pos = 0; // Next marker position to search, or the frame's start
+  bool lock = false;
+  bool checked = false; // Marker at pos already confirmed by the search
+  unsigned misses = 0;
+  size_t current = 0;
+  size_t numFrames = 0;
+  size_t numLosses = 0;
+};
+
+/*
+ *  CCSDS pseudo-randomizer: h(x) = x^8 + x^7 + x^5 + x^3 + 1 from all ones
+ *  at the start of every frame body (the bytes after the ASM), xored on.
+ *  The same call randomizes and derandomizes. The sequence is precomputed
+ *  for the whole frame and applied eight bytes at a time, or as sign flips
+ *  on LLRs.
+ */
+class Randomizer {
+public:
+  explicit Randomizer(size_t frameBytes);
+
+  void apply(uint8_t *bytes) const;    // frameBytes bytes
+  void applySoft(int8_t *llrs) const;  // 8 * frameBytes LLRs
+
+private:
+  std::vector<uint8_t> pn;
+  std::vector<int8_t> signs; // +-1 per bit
+};
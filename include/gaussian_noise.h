@@ -0,0 +1,84 @@
+/*
+ * gaussian_noise.h - Vectorized xoshiro256+ and Box-Muller Gaussian noise.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+
+// xoshiro256+ (Blackman and Vigna), seeded through splitmix64. jump() is
+// 2^128 steps, longJump() 2^192. The scalar one: random bits, and where the
+// lanes below start.
+class Xoshiro256 {
+public:
+  explicit Xoshiro256(uint64_t seed);
+
+  uint64_t next() {
+    const uint64_t result = s[0] + s[3];
+    const uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = (s[3] << 45) | (s[3] >> 19);
+    return result;
+  }
+  void jump();
+  void longJump();
+  const uint64_t *words() const { return s; }
+
+private:
+  void apply(const uint64_t *poly);
+
+  uint64_t s[4];
+};
+
+/*
+ *  Standard normal samples fast enough for BER curves (billions of them),
+ *  where std::normal_distribution costs a libm log and sin/cos per pair
+ *  behind a branchy, strictly serial engine.
+ *
+ *  The generator is xoshiro256+ run as LANES independent copies side by side
+ *  (one 64 bit lane of an AVX2 register each). Lane k starts k jumps of
+ *  2^128 steps along from the seed and stream s another s long jumps of
+ *  2^192 on, so lanes and streams never overlap: give every thread its own
+ *  stream and the results don't depend on how the work was split.
+ *
+ *  Every step of the lanes gives 8 32 bit words for u1 and 8 for u2, which
+ *  Box-Muller turns into 16 normals: r = sqrt(-2 ln u1), theta = 2 pi u2,
+ *  r cos(theta) and r sin(theta). log, sin and cos are short polynomials
+ *  (the Cephes single precision ones) evaluated 8 wide, u1 is kept in
+ *  (0, 1] so the log never sees 0. The top 24 bits of each word are used,
+ *  not the weak low ones of xoshiro256+.
+ *
+ *  Normals come out in batches of BATCH; whatever a call doesn't use is kept
+ *  for the next one, so the sequence is the same however it's asked for.
+ */
+class GaussianNoise {
+public:
+  static constexpr size_t LANES = 4;
+  static constexpr size_t BATCH = 16;
+
+  explicit GaussianNoise(uint64_t seed, uint64_t stream = 0);
+
+  // out[i] = sigma * N(0, 1)
+  void generate(float *out, size_t n, float sigma = 1.0f);
+  // x[i] += sigma * (N(0, 1) + j N(0, 1)): sigma is per component, the
+  // noise power 2 sigma^2.
+  void add(std::complex<float> *x, size_t n, float sigma);
+
+private:
+  void refill(float *out, size_t batches); // BATCH normals each
+  // dst[i] (+)= sigma * the next n normals
+  void emit(float *dst, size_t n, float sigma, bool accumulate);
+
+  alignas(32) uint64_t state[4][LANES]; // state[word][lane]
+  alignas(32) float spare[BATCH];
+  size_t numSpare = 0;
+};
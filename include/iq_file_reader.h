@@ -0,0 +1,131 @@
+/*
+ * iq_file_reader.h - Streaming reader for large cf32/cs16/cs8 recordings.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "sample_format.h"
+
+enum class FileAccess {
+  Auto,  // mmap, or pread if the file can't be mapped
+  Mmap,  // mmap or fail
+  Pread, // Chunked pread(2) into our own buffer
+};
+
+/*
+ *  Running DC offset removal, the streaming stand-in for read_iq's
+ *  `sig -= np.mean(sig)`. Each block's mean is folded into an exponential
+ *  average with a time constant of `timeConstant` samples (so the weight
+ *  doesn't depend on how the stream is chunked) and the estimate is
+ *  subtracted. The first block seeds the estimate with its own mean.
+ */
+class DcBlocker {
+public:
+  static constexpr double DEFAULT_TIME_CONSTANT = 1 << 20; // Samples
+
+  explicit DcBlocker(double timeConstant = DEFAULT_TIME_CONSTANT)
+      : tau(timeConstant) {}
+
+  void process(std::complex<float> *data, size_t numSamples);
+  void reset() { primed = false; }
+  std::complex<float> offset() const {
+    return {(float)estimate.real(), (float)estimate.imag()};
+  }
+
+private:
+  double tau;
+  std::complex<double> estimate = 0.0;
+  bool primed = false;
+};
+
+/*
+ *  Hands out windows of a recording by sample offset, always as cf32.
+ *
+ *  The whole file is mmap'd when possible (a 64-bit address space has room
+ *  for any capture) and cf32 windows point straight into the mapping: no
+ *  copy at all. cs16/cs8/cu8 are converted on the fly into a buffer the
+ *  size of the largest window asked for, so memory stays constant however
+ *  big the file is. If mmap isn't possible (or FileAccess::Pread), windows
+ *  are pread(2) into that buffer instead.
+ *
+ *  next() walks the file front to back and keeps the kernel a READAHEAD_BYTES
+ *  step ahead (MADV_WILLNEED / POSIX_FADV_WILLNEED) while dropping what is
+ *  behind us, so a 50 GB capture doesn't end up resident. It's also where
+ *  DC removal happens, as that's a running estimate.
+ *
+ *  fullScale undoes FormatConverter's: integer full scale comes back as
+ *  +-fullScale. cf32 files are taken as they are.
+ *
+ *  A returned window is valid until the next window()/next() call.
+ */
+class IQFileReader {
+public:
+  static constexpr size_t DEFAULT_WINDOW_SAMPLES = 1 << 16;
+  static constexpr size_t READAHEAD_BYTES = 8 << 20; // 8 MiB
+
+  explicit IQFileReader(const std::string &filename);
+  IQFileReader(const std::string &filename, SampleFormat fmt,
+               FileAccess access = FileAccess::Auto, float fullScale = 1.0f);
+  ~IQFileReader();
+
+  IQFileReader(const IQFileReader &) = delete;
+  IQFileReader &operator=(const IQFileReader &) = delete;
+
+  // Random access: up to numSamples samples starting at `offset`.
+  std::span<const std::complex<float>> window(size_t offset,
+                                              size_t numSamples);
+  // Same, converted into the caller's buffer. Returns samples written.
+  size_t read(size_t offset, size_t numSamples, std::complex<float> *out);
+
+  // Sequential: the window at position(), then move past it. Empty at EOF.
+  std::span<const std::complex<float>>
+  next(size_t maxSamples = DEFAULT_WINDOW_SAMPLES);
+  void seek(size_t sample); // Also restarts DC removal
+  size_t position() const { return pos; }
+  bool eof() const { return pos >= totalSamples; }
+
+  // Applies to next() only. cf32 windows stop being zero copy (we can't
+  // write into the mapping).
+  void enableDcRemoval(
+      double timeConstant = DcBlocker::DEFAULT_TIME_CONSTANT);
+  std::complex<float> dcOffset() const { return dc.offset(); }
+
+  bool isOpen() const { return fd >= 0; }
+  bool isMapped() const { return mapping != nullptr; }
+  size_t numSamples() const { return totalSamples; }
+  SampleFormat format() const { return fmt; }
+  const std::string &name() const { return filename; }
+
+private:
+  int preadAll(uint8_t *dst, size_t numBytes, uint64_t fileOffset);
+  void adviseAround(uint64_t windowStart, uint64_t windowEnd);
+
+  std::string filename;
+  SampleFormat fmt;
+  float fullScale;
+  size_t sampleBytes;
+  int fd = -1;
+  uint64_t fileBytes = 0;
+  size_t totalSamples = 0;
+  const uint8_t *mapping = nullptr;
+
+  size_t pos = 0;
+  uint64_t aheadMark = 0;  // Readahead requested up to here (bytes)
+  uint64_t behindMark = 0; // Dropped up to here (bytes)
+
+  bool removeDc = false;
+  DcBlocker dc;
+
+  std::vector<std::complex<float>> converted; // Window buffer
+  std::vector<uint8_t> raw;                   // pread staging, not cf32
+};
@@ -0,0 +1,34 @@
+/*
+ * loop_filter.h - PI loop filter gains for the RX tracking loops.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+/*
+ *  Proportional + integral gains for a second order loop with noise
+ *  bandwidth `bandwidth` (BnTs, cycles per update: per symbol for both of
+ *  our loops), damping `damping` and a detector slope of `detectorGain`
+ *  (error out per unit of phase/timing error in). Standard result, e.g.
+ *  Rice, Digital Communications, appendix C:
+ *
+ *    theta = BnTs / (zeta + 1 / (4 zeta))
+ *    Kp = 4 zeta theta / (1 + 2 zeta theta + theta^2) / Kd
+ *    Ki = 4 theta^2    / (1 + 2 zeta theta + theta^2) / Kd
+ *
+ *  Each update: integrator += Ki * e; correction = integrator + Kp * e.
+ */
+struct LoopGains {
+  double kp;
+  double ki;
+
+  static LoopGains design(double bandwidth, double damping,
+                          double detectorGain = 1.0) {
+    const double theta = bandwidth / (damping + 0.25 / damping);
+    const double denom = 1.0 + 2.0 * damping * theta + theta * theta;
+    return {4.0 * damping * theta / denom / detectorGain,
+            4.0 * theta * theta / denom / detectorGain};
+  }
+};
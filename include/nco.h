@@ -0,0 +1,53 @@
+/*
+ * nco.h - Phase continuous, vectorized numerically controlled oscillator.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+
+/*
+ *  Phase lives in a 64 bit fixed point accumulator (2^64 == 2*pi), so it
+ *  carries exactly across symbols and calls no matter how fc relates to SPS.
+ *
+ *  Samples come from a rotator recurrence: LANES phasors, each multiplied by
+ *  e^{j*LANES*w} per step. That is one complex multiply per sample instead of
+ *  a std::polar. The lane phasors are recomputed from the accumulator every
+ *  RESYNC_SAMPLES so float rounding in the recurrence never builds up.
+ *
+ *  Kernels: AVX2 (+FMA), NEON, or a plain scalar fallback, picked at compile
+ *  time from the target flags.
+ */
+
+class NCO {
+public:
+  static constexpr size_t LANES = 8;
+  static constexpr size_t RESYNC_SAMPLES = 1024;
+
+  NCO(double freq, double sampleRate, double initialPhase = 0.0);
+
+  void setFrequency(double freq, double sampleRate);
+  void setPhase(double radians);
+  double phase() const; // Radians, [0, 2*pi)
+  double frequency() const { return freq; }
+
+  // out[i] = e^{j*phi[i]}
+  void generate(std::complex<float> *out, size_t numSamples);
+  // out[i] = in[i] * e^{j*phi[i]} (in == out is fine)
+  void mix(const std::complex<float> *in, std::complex<float> *out,
+           size_t numSamples);
+
+private:
+  void process(const std::complex<float> *in, std::complex<float> *out,
+               size_t numSamples);
+
+  double freq;
+  uint64_t phaseAcc = 0;
+  uint64_t phaseInc = 0;
+  std::complex<float> laneStep; // e^{j*LANES*w}
+};
@@ -0,0 +1,136 @@
+/*
+ * ofdm.h - OFDM modulator and demodulator over the constellation mappers.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "fft.h"
+#include "symbol_mapper.h"
+
+enum class Subcarrier : uint8_t { Null, Data, Pilot };
+
+struct OfdmSettings {
+  static constexpr size_t AUTO = (size_t)-1;
+
+  size_t fftSize = 0;         // 0: single carrier
+  size_t cyclicPrefix = AUTO; // Samples; AUTO: fftSize / 4
+  size_t guard = AUTO;        // Null bins each side of Nyquist; AUTO: 5/64
+  size_t pilotSpacing = 8;    // A pilot every this many used bins (0: none)
+  std::string map;            // Explicit map, overrides guard and pilots
+
+  bool active() const { return fftSize > 0; }
+};
+
+/*
+ *  Which bin carries what, in FFT order (bin k >= n/2 is frequency k - n).
+ *  From settings.map if given: one character per bin from the most
+ *  negative frequency up, 'd' data, 'p' pilot, '-' null (so DC is the
+ *  middle one). Otherwise DC and Nyquist are null, so are `guard` bins
+ *  either side of Nyquist, and every pilotSpacing-th of the rest (counting
+ *  up from the lowest, starting half a spacing in) is a pilot. 64 bins with
+ *  guard 5 gives 802.11a's 52 used carriers. False on a bad map or one
+ *  without data carriers.
+ */
+bool makeCarrierMap(const OfdmSettings &settings, std::vector<Subcarrier> &map);
+
+/*
+ *  Labels to OFDM symbols: dataCarriers() labels at a time go through the
+ *  constellation mapper onto the data bins in ascending frequency, pilots
+ *  are fixed BPSK (a 127 long PN over the pilot bins, as in 802.11), the
+ *  inverse FFT takes them to fftSize samples and the last cyclicPrefix of
+ *  those are copied in front. Scaled to unit average power per sample.
+ *
+ *  The null and pilot bins of the batch buffer are written once, up front;
+ *  per symbol only the data bins are scattered in, and the batched inverse
+ *  FFT writes straight behind each symbol's prefix in the output. Nothing
+ *  is allocated after construction. Labels that don't make up a whole
+ *  symbol are kept for the next call; flush() pads them out with zeros.
+ */
+class OfdmModulator {
+public:
+  OfdmModulator(const OfdmSettings &settings, Modulation mod);
+
+  size_t dataCarriers() const { return dataBins.size(); }
+  size_t usedCarriers() const { return dataBins.size() + pilotBins.size(); }
+  size_t symbolLength() const { return n + cp; } // Samples per OFDM symbol
+
+  // Takes numLabels labels, writes whole OFDM symbols (at most
+  // maxOutput(numLabels) samples) and returns the number of samples.
+  size_t modulate(const uint8_t *labels, size_t numLabels,
+                  std::complex<float> *out);
+  size_t maxOutput(size_t numLabels) const {
+    return (numLabels + dataCarriers() - 1) / dataCarriers() * symbolLength();
+  }
+  // The last, zero padded symbol if labels are left over (0 or
+  // symbolLength() samples).
+  size_t flush(std::complex<float> *out);
+
+private:
+  static constexpr size_t BATCH = 16; // OFDM symbols per inverse FFT batch
+
+  void modulateWhole(const uint8_t *labels, size_t numSyms,
+                     std::complex<float> *out);
+
+  size_t n, cp;
+  Modulation mod;
+  const FftPlan &fft;
+  float scale; // 1 / sqrt(used carriers)
+  std::vector<uint32_t> dataBins, pilotBins;
+  std::vector<std::complex<float>> points; // BATCH symbols' mapped data
+  std::vector<std::complex<float>> bins;   // BATCH x n frequency domain
+  std::vector<uint8_t> pending;            // Labels short of a symbol
+};
+
+/*
+ *  OFDM symbols back to data points, ready for Demapper. The input is
+ *  expected to start on a symbol (the first prefix sample), as main writes
+ *  it; symbols can be cut anywhere between calls. Each one loses its
+ *  prefix and goes through the batched forward FFT; the channel is
+ *  estimated at the pilots (received / sent), linearly interpolated across
+ *  the data bins in frequency and divided out, which takes care of a fixed
+ *  phase, gain and multipath within the prefix. Without pilots the data
+ *  bins are just scaled back.
+ */
+class OfdmDemodulator {
+public:
+  explicit OfdmDemodulator(const OfdmSettings &settings);
+
+  size_t dataCarriers() const { return dataBins.size(); }
+  size_t symbolLength() const { return n + cp; }
+
+  // Writes dataCarriers() points for every OFDM symbol completed by these
+  // samples (at most maxOutput(numSamps)), returns how many.
+  size_t demodulate(const std::complex<float> *in, size_t numSamps,
+                    std::complex<float> *out);
+  size_t maxOutput(size_t numSamps) const {
+    return (numSamps / symbolLength() + 1) * dataCarriers();
+  }
+
+private:
+  static constexpr size_t BATCH = 16;
+
+  void demodulateWhole(const std::complex<float> *in, size_t numSyms,
+                       std::complex<float> *out);
+
+  size_t n, cp;
+  const FftPlan &fft;
+  float scale; // sqrt(used carriers) / n, undoes the modulator's
+  std::vector<uint32_t> dataBins, pilotBins;
+  std::vector<std::complex<float>> pilotValues;
+  // Data bin j interpolates between pilots left[j] and right[j], weight
+  // frac[j] on the right one.
+  std::vector<uint32_t> left, right;
+  std::vector<float> frac;
+  std::vector<std::complex<float>> bins; // BATCH x n
+  std::vector<std::complex<float>> gains; // Per pilot, one symbol
+  std::vector<std::complex<float>> partial; // Samples short of a symbol
+};
@@ -0,0 +1,77 @@
+/*
+ * output_handler.h - Persistent, buffered IQ sink.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <span>
+#include <string>
+#include <vector>
+
+struct iovec;
+
+/*
+ *  Keeps one file descriptor open for the whole run and stages interleaved
+ *  cf32 samples in a large page-aligned buffer. Each flush is a single
+ *  write(2) of the whole staged block instead of two fwrite calls per sample.
+ */
+
+enum class FlushPolicy {
+  WhenFull,   // Only hit the disk when the staging buffer fills up (default)
+  EveryWrite, // Flush at the end of every writeToFile/writeViews call
+  Sync,       // Like WhenFull, but fdatasync after every flush
+};
+
+class OutputHandler {
+public:
+  static constexpr size_t DEFAULT_BUFFER_BYTES = 4 << 20; // 4 MiB
+  static constexpr size_t BUFFER_ALIGNMENT = 4096;
+  // Views smaller than this (on average) are gathered into the staging
+  // buffer; larger ones go straight to writev(2) without being copied.
+  static constexpr size_t WRITEV_MIN_BYTES = 2048;
+  static constexpr size_t IOV_MAX_BATCH = 1024; // Linux IOV_MAX
+
+  OutputHandler(const std::string &filename,
+                size_t bufferBytes = DEFAULT_BUFFER_BYTES,
+                FlushPolicy policy = FlushPolicy::WhenFull,
+                bool append = true);
+  ~OutputHandler();
+
+  OutputHandler(const OutputHandler &) = delete;
+  OutputHandler &operator=(const OutputHandler &) = delete;
+
+  // All of these return 0 on success and 1 on failure, like writeIQToFile.
+  int writeToFile(const std::vector<std::complex<float>> &iqSamples);
+  int writeToFile(const std::complex<float> *iqSamples, size_t numSamples);
+  // Already packed samples in some other format (see sample_format.h).
+  int writeBytes(const void *data, size_t numBytes);
+  // Write a batch of views (e.g. SymbolTable rows) back to back, in order.
+  int writeViews(const std::span<const std::complex<float>> *views,
+                 size_t numViews);
+  int flush();
+  int close();
+
+  bool isOpen() const { return fd >= 0; }
+  const std::string &name() const { return filename; }
+  size_t bytesWritten() const { return totalBytes; }
+
+private:
+  int stage(const char *data, size_t numBytes);
+  int endOfWrite();
+  int writeAll(const char *data, size_t numBytes);
+  int writevAll(struct iovec *iov, size_t iovCount);
+
+  std::string filename;
+  int fd = -1;
+  FlushPolicy policy;
+
+  char *buffer = nullptr; // Page aligned staging area
+  size_t capacity = 0;    // In bytes
+  size_t used = 0;        // In bytes
+  size_t totalBytes = 0;  // Bytes handed to the kernel so far
+};
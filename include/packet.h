@@ -0,0 +1,128 @@
+/*
+ * packet.h - Length delimited, CRC checked packets over the frame bodies.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/*
+ *  CRC-16/CCITT-FALSE (x^16 + x^12 + x^5 + 1, MSB first, from 0xFFFF) and
+ *  the zlib / Ethernet CRC-32 (0x04C11DB7 reflected, inverted in and out).
+ *  Both slice-by-8: eight 256 entry tables, each the one before it pushed
+ *  one more zero byte along, so eight bytes go in with eight independent
+ *  lookups and no loop carried dependency between them but the last xor.
+ *  Pass the last result back in to go on where it left off.
+ *
+ *  Check values: "123456789" gives 0x29B1 and 0xCBF43926.
+ */
+namespace crc {
+constexpr uint16_t CRC16_INIT = 0xFFFF;
+uint16_t crc16(const uint8_t *data, size_t n, uint16_t crc = CRC16_INIT);
+uint32_t crc32(const uint8_t *data, size_t n, uint32_t crc = 0);
+} // namespace crc
+
+/*
+ *  Packets, all fields MSB first:
+ *
+ *    sync  0xEB90            2 bytes
+ *    len   payload bytes     2 bytes
+ *    hcrc  CRC-16 of the 4   2 bytes
+ *    payload                 len bytes
+ *    crc   CRC-16 or -32 of everything after the sync, 2 or 4 bytes
+ *
+ *  They're written back to back into the frame bodies, across frame
+ *  boundaries, so a payload can be any length up to MAX_PAYLOAD and the
+ *  last one is exactly what was left of the input: nothing is padded but
+ *  the last frame body (zeros, which never look like a sync). The frames
+ *  underneath have found the byte alignment and the phase ambiguity
+ *  already, and main leads the first one in with --preamble symbols so rx
+ *  has locked by its ASM and the first packets aren't lost to start-up.
+ *  The sync word only has to find packet boundaries again after a lost
+ *  frame, and hcrc keeps a sync lookalike in a payload from being taken
+ *  for one (1 in 2^32 for both to pass).
+ */
+namespace packet {
+constexpr uint16_t SYNC = 0xEB90;
+constexpr size_t HEADER_BYTES = 6;
+constexpr size_t MAX_PAYLOAD = 65535;
+constexpr size_t DEFAULT_FRAME_BYTES = 1020; // ASM + 1020: 1 KiB frames
+} // namespace packet
+
+struct PacketSettings {
+  size_t maxPayload = 0;  // Payload bytes per packet; 0: off
+  unsigned crcBits = 32; // 16 or 32
+
+  bool active() const { return maxPayload > 0; }
+  size_t crcBytes() const { return crcBits / 8; }
+};
+
+/*
+ *  TX side. The payload is read straight to where it goes in the packet
+ *  (HEADER_BYTES in) and seal() writes the header in front of it and the
+ *  CRC behind it.
+ */
+class Packetizer {
+public:
+  explicit Packetizer(const PacketSettings &settings) : settings(settings) {}
+
+  // A packet with a full payload.
+  size_t maxPacketBytes() const {
+    return packet::HEADER_BYTES + settings.maxPayload + settings.crcBytes();
+  }
+  // payloadBytes <= maxPayload at packet + HEADER_BYTES; returns the
+  // packet's length.
+  size_t seal(uint8_t *packet, size_t payloadBytes) const;
+
+private:
+  PacketSettings settings;
+};
+
+/*
+ *  RX side, on the bytes the frames carried, in whatever pieces they come.
+ *  Packets are looked for with memchr on the sync's first byte, checked
+ *  header first, and handed out as views of the payload inside the bytes
+ *  passed in: nothing is copied but a packet that straddles two calls,
+ *  which is put together in a buffer of its own.
+ *
+ *  A header that passes its CRC is trusted for the length, so a packet
+ *  that fails the payload CRC is skipped whole rather than searched
+ *  through; anything that isn't a packet (padding, the rest of a lost
+ *  frame) counts as skipped bytes.
+ */
+class Deframer {
+public:
+  explicit Deframer(const PacketSettings &settings) : settings(settings) {}
+
+  // Replaces payloads with the good packets' payloads, in order. They point
+  // into bytes or into the deframer and stay valid until the next call.
+  void process(const uint8_t *bytes, size_t n,
+               std::vector<std::span<const uint8_t>> &payloads);
+
+  size_t packetsFound() const { return numPackets; }
+  size_t payloadBytes() const { return numPayload; }
+  size_t crcFailures() const { return numFailed; }
+  size_t bytesSkipped() const { return numSkipped; }
+
+private:
+  // 0: not a packet, else the whole packet's length. Needs HEADER_BYTES.
+  size_t header(const uint8_t *p) const;
+  // A whole packet of total bytes whose header passed: its payload goes out
+  // if the CRC holds.
+  void accept(const uint8_t *p, size_t total,
+              std::vector<std::span<const uint8_t>> &payloads);
+  // Packets from p + at on; returns where the first unfinished one starts.
+  size_t parse(const uint8_t *p, size_t at, size_t n,
+               std::vector<std::span<const uint8_t>> &payloads);
+
+  PacketSettings settings;
+  std::vector<uint8_t> tail;   // Unfinished packet from the last call on
+  std::vector<uint8_t> joined; // The last straddling packet, whole
+  size_t numPackets = 0, numPayload = 0, numFailed = 0, numSkipped = 0;
+};
@@ -0,0 +1,187 @@
+/*
+ * pipeline.h - Block pipeline: fused in one thread or one thread per stage.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "spsc_ring.h"
+#include "stage_stats.h"
+
+// Pin the calling thread to one CPU. Returns 0 on success, 1 on failure.
+int pinThisThread(int cpu);
+
+enum class StageResult {
+  Ok,    // Pass the block on
+  Done,  // Source only: input is exhausted, this block is empty
+  Error, // Stop everything
+};
+
+/*
+ *  Stages are run in the order they were added on a pool of preallocated
+ *  blocks. The first stage is the source: it fills a block and says Done
+ *  once there is nothing left. Every other stage works on the block in place.
+ *
+ *  Fused: one thread takes a block through every stage in turn. Best for
+ *  small rates where handing blocks between cores costs more than it saves.
+ *
+ *  Threaded: one thread per stage, neighbours linked by SpscRing<Block *>.
+ *  The last stage hands blocks back to the source through a free ring, so
+ *  nothing is allocated in steady state, and a full ring stalls whoever is
+ *  upstream of it (backpressure). A nullptr block marks end of stream.
+ *
+ *  With QPSK_STATS every stage function call is timed and, threaded, the
+ *  ring levels sampled into stage_stats.h; otherwise none of that is there.
+ */
+template <typename Block> class Pipeline {
+public:
+  using StageFn = std::function<StageResult(Block &)>;
+
+  struct Stage {
+    std::string name;
+    StageFn fn;
+    int cpu;     // -1: don't pin
+    int statsId; // stage_stats.h; -1 without QPSK_STATS
+  };
+
+  // blockInit is run once on every block in the pool (allocate buffers).
+  Pipeline(size_t numBlocks, const std::function<void(Block &)> &blockInit)
+      : pool(numBlocks) {
+    for (Block &b : pool)
+      blockInit(b);
+  }
+
+  void addStage(const std::string &name, StageFn fn, int cpu = -1) {
+    stages.push_back({name, std::move(fn), cpu, stats::registerStage(name)});
+  }
+
+  const std::vector<Stage> &getStages() const { return stages; }
+
+  // 0 on success, 1 if any stage reported an error.
+  int runFused() {
+    if (!stages.empty() && stages[0].cpu >= 0)
+      pinThisThread(stages[0].cpu);
+
+    Block &b = pool[0];
+    for (;;) {
+      uint64_t t = stats::stageBegin(stages[0].statsId);
+      StageResult r = stages[0].fn(b);
+      if (r == StageResult::Done)
+        return 0;
+      if (r == StageResult::Error)
+        return fail(stages[0]);
+      stats::stageEnd(stages[0].statsId, t);
+      for (size_t s = 1; s < stages.size(); s++) {
+        t = stats::stageBegin(stages[s].statsId);
+        if (stages[s].fn(b) != StageResult::Ok)
+          return fail(stages[s]);
+        stats::stageEnd(stages[s].statsId, t);
+      }
+    }
+  }
+
+  int runThreaded() {
+    const size_t numStages = stages.size();
+    if (numStages < 2)
+      return runFused();
+
+    // links[0] is the free ring (last stage -> source); links[s] feeds stage s
+    std::vector<std::unique_ptr<SpscRing<Block *>>> links;
+    for (size_t s = 0; s < numStages; s++)
+      links.push_back(std::make_unique<SpscRing<Block *>>(pool.size()));
+    for (Block &b : pool)
+      links[0]->tryPush(&b);
+
+    abort.store(false);
+    std::vector<std::thread> threads;
+    for (size_t s = 0; s < numStages; s++)
+      threads.emplace_back([&, s] { stageLoop(s, links); });
+    for (std::thread &t : threads)
+      t.join();
+
+    ringStats.clear();
+    for (size_t s = 1; s < numStages; s++)
+      ringStats.push_back(
+          {links[s]->producerStalls(), links[s]->consumerStalls()});
+    return failed.load() ? 1 : 0;
+  }
+
+  // After runThreaded(): stalls on the ring *into* stage s (s >= 1).
+  struct RingStats {
+    size_t producerStalls; // Upstream stage found it full (backpressure)
+    size_t consumerStalls; // Stage s found it empty (starved)
+  };
+  const std::vector<RingStats> &getRingStats() const { return ringStats; }
+
+private:
+  void stageLoop(size_t s,
+                 std::vector<std::unique_ptr<SpscRing<Block *>>> &links) {
+    if (stages[s].cpu >= 0)
+      pinThisThread(stages[s].cpu);
+
+    SpscRing<Block *> &in = *links[s];
+    SpscRing<Block *> &out = *links[(s + 1) % links.size()];
+    const bool isSource = (s == 0);
+    const bool isSink = (s + 1 == links.size());
+
+    // An error anywhere stops every stage, asleep on a ring or not.
+    auto stopAll = [&] {
+      abort.store(true);
+      for (auto &link : links)
+        link->wake();
+    };
+
+    for (;;) {
+      Block *b = nullptr;
+      if (!in.pop(b, abort))
+        return;
+      if (!b) { // End of stream, pass it on (not back to the source though)
+        if (!isSink)
+          out.push(nullptr, abort);
+        return;
+      }
+
+      if constexpr (stats::ENABLED)
+        stats::queueLevel(stages[s].statsId, in.size(), in.consumerStalls(),
+                          out.producerStalls());
+      const uint64_t t = stats::stageBegin(stages[s].statsId);
+      StageResult r = stages[s].fn(*b);
+      if (r == StageResult::Error) {
+        fail(stages[s]);
+        stopAll();
+        return;
+      }
+      if (isSource && r == StageResult::Done) {
+        out.push(nullptr, abort);
+        return;
+      }
+      stats::stageEnd(stages[s].statsId, t);
+      if (!out.push(b, abort))
+        return;
+    }
+  }
+
+  int fail(const Stage &stage) {
+    fprintf(stderr, "[ERROR] Pipeline stage '%s' failed.\n",
+            stage.name.c_str());
+    failed.store(true);
+    return 1;
+  }
+
+  std::vector<Block> pool;
+  std::vector<Stage> stages;
+  std::vector<RingStats> ringStats;
+  std::atomic<bool> abort{false};
+  std::atomic<bool> failed{false};
+};
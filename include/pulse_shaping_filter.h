@@ -0,0 +1,105 @@
+/*
+ * pulse_shaping_filter.h - RRC/RC pulse design and polyphase interpolator.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+enum class PulseShape {
+  RootRaisedCosine, // Split between TX and the RX matched filter
+  RaisedCosine,     // Whole Nyquist pulse on one side
+};
+
+enum class Window {
+  Rectangular, // i.e. plain truncation
+  Hamming,
+  Hann,
+  Blackman,
+};
+
+/*
+ *  spanSymbols * sps + 1 taps, centred on the middle tap.
+ *  RRC is scaled so sum(h^2) == sps (unit output power for unit symbols),
+ *  RC so the centre tap is 1 (output hits the symbol exactly at the peak).
+ *  sps doesn't have to be whole (receivers rarely get to pick); the tap
+ *  count is then rounded to an odd number so there still is a middle tap.
+ */
+std::vector<float> designPulse(PulseShape shape, float rollOff, double sps,
+                               size_t spanSymbols,
+                               Window window = Window::Rectangular);
+
+/*
+ *  Goes straight from symbols to shaped samples. Zero stuffing and then
+ *  filtering at the full rate would spend (sps - 1)/sps of the multiplies on
+ *  zeros. Instead the taps are split into sps phases of P = ceil(L / sps)
+ *  taps and every output sample only touches the P most recent symbols:
+ *
+ *    y[n*sps + p] = sum_k h[p + k*sps] * x[n - k],   k = 0 .. P-1
+ *
+ *  The taps are stored k-major with every tap duplicated ({h, h}) so one
+ *  symbol x[n-k] broadcast as {xr, xi, xr, xi, ...} multiplies a whole row
+ *  and lands straight in interleaved output order: no horizontal sums.
+ *  The last P-1 symbols are kept between calls.
+ *
+ *  With decimation D > 1 the output rate is L/D samples per symbol
+ *  (L = samplesPerSymbol), so sample rates that aren't a whole multiple of
+ *  the baud rate come out exact. The pulse is designed with L phases and
+ *  output m uses phase (m*D) mod L of symbol floor(m*D / L): still P taps a
+ *  sample, but consecutive samples no longer share a row, so the taps are
+ *  stored phase-major instead and each sample is its own short dot product.
+ *  That's L * P floats, hence MAX_PHASE_TAPS.
+ */
+class PulseShapingFilter {
+public:
+  static constexpr size_t MAX_PHASE_TAPS = 1 << 24; // Rational mode only
+
+  PulseShapingFilter(float rollOffFactor, size_t samplesPerSymbol,
+                     size_t spanSymbols = 8,
+                     PulseShape shape = PulseShape::RootRaisedCosine,
+                     Window window = Window::Rectangular,
+                     size_t decimation = 1);
+
+  // Writes numSymbols * L / D samples to out (rounded up or down depending
+  // on where we are in the L/D cycle); returns how many.
+  size_t interpolate(const std::complex<float> *symbols, size_t numSymbols,
+                     std::complex<float> *out);
+  // Push zeros through to get the tail of the last symbols out.
+  // Writes (P - 1) symbols worth of samples.
+  size_t flush(std::complex<float> *out);
+  void reset();
+
+  // Room interpolate() needs for numSymbols symbols.
+  size_t maxSamples(size_t numSymbols) const {
+    return numSymbols * ((sps + decim - 1) / decim);
+  }
+
+  const std::vector<float> &taps() const { return filterCoefficients; }
+  size_t samplesPerSymbol() const { return sps; } // L
+  size_t decimation() const { return decim; }     // D
+  size_t tapsPerPhase() const { return numPhaseTaps; }
+  // In samples at L per symbol
+  size_t delay() const { return (filterCoefficients.size() - 1) / 2; }
+
+private:
+  size_t interpolateRational(const std::complex<float> *newest,
+                             size_t numSymbols, std::complex<float> *out);
+
+  std::vector<float> filterCoefficients;
+  size_t sps;
+  size_t decim;
+  size_t numPhaseTaps; // P
+  size_t rowWidth;     // Floats per k-row, 2*sps rounded up to a vector
+
+  std::vector<float> phaseRows;          // P rows of rowWidth floats
+  std::vector<std::complex<float>> work; // P-1 history symbols + new ones
+  std::vector<float> scratch;            // One padded output row
+
+  std::vector<float> phaseTaps; // D > 1: L rows of P taps, newest symbol first
+  size_t phaseAcc = 0;          // D > 1: phase of the next output sample
+};
@@ -0,0 +1,86 @@
+/*
+ * reed_solomon.h - CCSDS Reed-Solomon (255,223) codec with interleaving.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ *  CCSDS 131.0-B: GF(256) over x^8 + x^7 + x^2 + x + 1, generator roots
+ *  alpha^(11 j) for j = 112 .. 143, 16 correctable byte errors per 255
+ *  byte codeword. Symbols on the wire are in Berlekamp's dual basis (what
+ *  CCSDS and Meteor-M2 send); dualBasis = false gives the plain
+ *  conventional basis code.
+ *
+ *  Byte 0 of a codeword is the highest degree coefficient; the 223 data
+ *  bytes come first, the 32 parity bytes after them. With interleaving
+ *  depth I, byte j of the 255 * I byte frame belongs to codeword j % I, so
+ *  the data of all I codewords still comes first.
+ */
+namespace rs {
+constexpr size_t N = 255;
+constexpr size_t K = 223;
+constexpr size_t NUM_PARITY = N - K;
+constexpr unsigned MAX_INTERLEAVE = 8;
+} // namespace rs
+
+/*
+ *  Field arithmetic is log/antilog tables throughout, except for the two
+ *  places that run on every frame:
+ *
+ *  - Encoding is an LFSR whose feedback times the generator is looked up
+ *    whole (256 x 32 byte table), one shift and 32 byte xor per data byte.
+ *  - Syndromes. A clean frame stops right after them (all zero), so they're
+ *    what the throughput on a good link comes down to. Each syndrome is the
+ *    received polynomial evaluated at one root b: Horner over 32 byte
+ *    blocks (A = A * b^32 + block, all lanes multiplied by the same
+ *    constant, so two PSHUFB lookups on the nibbles do 32 multiplies),
+ *    then the lanes folded in half five times (times b^16, b^8, ... b).
+ *
+ *  Anything else goes to Berlekamp-Massey, a Chien search and Forney.
+ */
+class ReedSolomon {
+public:
+  explicit ReedSolomon(bool dualBasis = true);
+
+  // codeword[0 .. K) in, the parity goes to codeword[K .. N).
+  void encode(uint8_t *codeword) const;
+  // Corrects in place. Returns the number of bytes corrected, or -1 when
+  // there were more errors than the code can fix (codeword untouched).
+  int decode(uint8_t *codeword) const;
+
+  // The same for a frame of depth (1 .. MAX_INTERLEAVE) interleaved
+  // codewords. encodeInterleaved() returns 0, or 1 for a bad depth.
+  int encodeInterleaved(uint8_t *frame, unsigned depth) const;
+  // Total bytes corrected, -1 if any codeword failed (the others are still
+  // corrected). corrections, if given, gets decode()'s result for each.
+  int decodeInterleaved(uint8_t *frame, unsigned depth,
+                        int *corrections = nullptr) const;
+
+  bool dualBasis() const { return dual; }
+
+private:
+  void encodeStrided(uint8_t *codeword, size_t stride) const;
+  int decodeStrided(uint8_t *codeword, size_t stride) const;
+  // Syndromes of buf[1 .. N] (buf[0] is a zero pad), log form. Returns
+  // false if they are all zero.
+  bool syndromes(const uint8_t *buf, uint8_t *s) const;
+  // Berlekamp-Massey, Chien, Forney on the conventional codeword cw. Writes
+  // the positions it fixed to where; returns how many, or -1.
+  int correct(const uint8_t *s, uint8_t *cw, uint8_t *where) const;
+
+  bool dual;
+  uint8_t alphaTo[256]; // alpha^i; alphaTo[255] = 0
+  uint8_t indexOf[256]; // log_alpha; indexOf[0] = 255
+  uint8_t toDual[256];
+  uint8_t fromDual[256];
+  alignas(32) uint8_t feedback[256][rs::NUM_PARITY]; // fb * g, LFSR order
+  // Per syndrome, the nibble tables (low 16 | high 16) for multiplying by
+  // b^32, b^16, b^8, b^4, b^2, b.
+  alignas(32) uint8_t mulTables[rs::NUM_PARITY][6][32];
+};
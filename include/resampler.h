@@ -0,0 +1,86 @@
+/*
+ * resampler.h - Arbitrary ratio Farrow resampler, up or down.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ *  Takes samples at one rate to interp / decim times that rate, for any
+ *  ratio: PulseShapingFilter's L/D polyphase bank needs one phase per
+ *  numerator step, which a hardware clock next to an odd baud rate (2.56
+ *  MS/s at 72001 Bd is 2560000/72001) makes millions of. Here the
+ *  symbols are shaped at a small whole number of samples instead and this
+ *  takes them the rest of the way.
+ *
+ *  Rational part: output m sits at input time m * decim / interp, kept as a
+ *  whole index plus frac / interp, in integers, so the rate is exact and
+ *  never drifts however long it runs (same idea as SymbolClock).
+ *
+ *  Fractional part (Farrow): the interpolation kernel is a Kaiser windowed
+ *  sinc, h(t), flat up to `passband` and 80 dB down from 1 - passband
+ *  (both in cycles per sample of the lower of the two rates), so one
+ *  design both interpolates (kills the images) and decimates (filters
+ *  before the aliasing): what folds over lands above the passband. The
+ *  narrower the signal, the wider the transition and the shorter h;
+ *  RRC at K samples a symbol needs (1 + rolloff) / 2K.
+ *
+ *  Each tap's stretch of h over one input sample is cut into PHASES pieces
+ *  and each piece is a cubic in the position u within it, fitted at u = 0,
+ *  1/3, 2/3, 1 (so neighbouring pieces meet). An output is then
+ *
+ *    y = v0 + u (v1 + u (v2 + u v3)),   vp = sum_k b_p[piece][k] x[n + k]
+ *
+ *  and the four sums go in one pass: the taps are stored {b0, b0, b1, b1,
+ *  b2, b2, b3, b3} so one input sample broadcast as {xr, xi, xr, xi, ...}
+ *  feeds all four with one FMA (as PulseShapingFilter's duplicated taps).
+ *
+ *  Output m is aligned with input time m * decim / interp (the first one
+ *  with input 0); there is a lookahead of numTaps() / 2 inputs, which
+ *  flush() pushes out with zeros at the end.
+ */
+class Resampler {
+public:
+  static constexpr size_t PHASES = 32;     // Cubic pieces per input sample
+  static constexpr size_t MAX_TAPS = 4096; // Decimating by up to ~150
+
+  static constexpr double DEFAULT_PASSBAND = 0.4;
+
+  // Output rate = input rate * interp / decim (need not be in lowest terms).
+  // passband < 0.5.
+  Resampler(uint64_t interp, uint64_t decim,
+            double passband = DEFAULT_PASSBAND);
+  // Taps per output for that ratio, without building anything.
+  static size_t tapsFor(uint64_t interp, uint64_t decim,
+                        double passband = DEFAULT_PASSBAND);
+
+  // Writes at most maxOutput(numIn) samples, returns how many.
+  size_t process(const std::complex<float> *in, size_t numIn,
+                 std::complex<float> *out);
+  size_t maxOutput(size_t numIn) const {
+    return (size_t)((unsigned __int128)numIn * interp / decim) + 2;
+  }
+  // Zeros through the lookahead: the outputs up to the last input.
+  size_t flush(std::complex<float> *out);
+  void reset();
+
+  double ratio() const { return (double)interp / (double)decim; }
+  size_t numTaps() const { return 2 * half; }
+
+private:
+  uint64_t interp, decim;
+  uint64_t whole, rem; // decim / interp, decim % interp: the step in inputs
+  size_t half;         // Taps either side of the output time
+  std::vector<float> rows; // PHASES rows of numTaps() x 8 floats
+
+  std::vector<std::complex<float>> work; // Inputs from the next output's on
+  size_t next = 0;   // Index in work of the next output's first tap
+  uint64_t frac = 0; // Its fractional time, frac / interp of an input
+};
@@ -0,0 +1,73 @@
+/*
+ * sample_format.h - cf32 <-> cs16/cs8/cu8 conversion for IQ files.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class SampleFormat {
+  CF32, // Interleaved float I/Q, 8 bytes a sample
+  CS16, // Interleaved int16, 4 bytes (a.k.a. sc16)
+  CS8,  // Interleaved int8, 2 bytes (a.k.a. sc8)
+  CU8,  // Interleaved uint8 offset by 127.5, 2 bytes (RTL-SDR)
+};
+
+// Same formats as read_iq in METEOR-M2/meteor-m2.qmd: a .sc16/.cs16 or
+// .sc8/.cs8 (plus .cu8/.u8) extension picks the format, anything else is
+// cf32. Only the file name's last extension counts.
+SampleFormat formatFromFilename(const std::string &filename);
+size_t bytesPerSample(SampleFormat fmt);
+const char *formatName(SampleFormat fmt);
+
+// The way back, for recordings: numSamples samples of `fmt` at `in` to cf32,
+// undoing FormatConverter's scaling (integer full scale -> +-fullScale).
+// cu8 is centred on 127.5. Same AVX2/NEON/scalar split as the other way.
+void toComplexFloat(SampleFormat fmt, const void *in, size_t numSamples,
+                    std::complex<float> *out, float fullScale = 1.0f);
+
+/*
+ *  Scale, (optionally) dither, round and saturate. `fullScale` is the float
+ *  amplitude that lands on the integer full scale; anything beyond it is
+ *  clipped and counted. Dither is TPDF (sum of two uniforms, +-1 LSB) from a
+ *  seeded xorshift so runs are reproducible.
+ *
+ *  AVX2 and NEON kernels do the float -> int32 -> saturating pack dance
+ *  16 or 32 floats at a time; everything else goes through the scalar loop.
+ *  cf32 is a plain copy (fullScale and dither don't apply).
+ */
+class FormatConverter {
+public:
+  static constexpr size_t CHUNK_SAMPLES = 1024; // Dither scratch size
+
+  FormatConverter(SampleFormat fmt, float fullScale = 1.0f,
+                  bool dither = false, uint64_t seed = 0x5eed);
+
+  // Writes numSamples * bytesPerSample() bytes to out, returns that count.
+  size_t convert(const std::complex<float> *in, size_t numSamples, void *out);
+
+  SampleFormat format() const { return fmt; }
+  size_t bytesPerSample() const { return ::bytesPerSample(fmt); }
+  size_t clippedSamples() const { return clipped / 2; } // I and Q counted
+  size_t clippedValues() const { return clipped; }
+
+private:
+  void addDither(const float *in, float *out, size_t numFloats);
+
+  SampleFormat fmt;
+  float gain;   // Float -> integer LSBs
+  float offset; // Added after the gain (cu8 only)
+  bool dither;
+  size_t clipped = 0;
+
+  static constexpr size_t DITHER_LANES = 8;
+  uint32_t rngState[DITHER_LANES];
+  std::vector<float> scratch;
+};
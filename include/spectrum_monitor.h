@@ -0,0 +1,119 @@
+/*
+ * spectrum_monitor.h - Welch PSD, constellation and eye taps off a pipeline.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <atomic>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "fft.h"
+#include "spsc_ring.h"
+
+struct MonitorSettings {
+  std::string prefix;     // prefix.{psd,const,eye,json}; empty: off
+  size_t fftSize = 1024;  // PSD bins
+  size_t average = 16;    // Welch segments per PSD frame
+  size_t decimation = 16; // Keep one constellation point in this many
+
+  bool active() const { return !prefix.empty(); }
+};
+
+/*
+ *  What tests/view_iq.grc and view_symbols.grc show, without playing the
+ *  capture back in real time: summary files tests/view_monitor.py plots at
+ *  once.
+ *
+ *  feed() is called from a pipeline stage and only copies: a few Welch
+ *  segments from the start of the block, a couple of dozen symbols' worth
+ *  of matched filter output for the eye and every decimation-th symbol. The
+ *  copies go into one of a handful of preallocated chunks handed to a
+ *  worker thread over an SpscRing; if the worker is behind and no chunk is
+ *  free the block is skipped (droppedBlocks()), so the pipeline never waits
+ *  on it. The worker runs the Hann windowed, 50% overlapped segments
+ *  through one batched FFT and averages `average` of them into a PSD frame.
+ *
+ *  prefix.psd   float32 dB frames of fftSize bins, lowest frequency first,
+ *               0 dB = a tone at unit power. Frame after frame: a waterfall.
+ *  prefix.const cf32 constellation points.
+ *  prefix.eye   uint32 histograms, I then Q, EYE_TIME_BINS x EYE_AMP_BINS
+ *               each: two symbol periods by [-EYE_RANGE, EYE_RANGE].
+ *               Free running, so the eye sits at some fixed offset.
+ *  prefix.json  Sample rate, centre frequency, sizes: what to plot it with.
+ */
+class SpectrumMonitor {
+public:
+  static constexpr size_t SEGMENTS_PER_BLOCK = 4;
+  static constexpr size_t EYE_SYMBOLS = 32; // Per block
+  static constexpr size_t EYE_TIME_BINS = 128;
+  static constexpr size_t EYE_AMP_BINS = 128;
+  static constexpr float EYE_RANGE = 2.0f;
+  static constexpr size_t MAX_POINTS = 4096; // Per block
+  static constexpr size_t CHUNKS = 8;        // Blocks in flight to the worker
+
+  // centerFreq only labels the PSD axis; samplesPerSymbol 0: no eye.
+  SpectrumMonitor(const MonitorSettings &settings, double sampleRate,
+                  double centerFreq, double samplesPerSymbol);
+  ~SpectrumMonitor();
+  SpectrumMonitor(const SpectrumMonitor &) = delete;
+  SpectrumMonitor &operator=(const SpectrumMonitor &) = delete;
+
+  bool isOpen() const { return psdFile != nullptr; }
+
+  // Any of the three may be empty (nullptr, 0). eye is matched filter
+  // output at samplesPerSymbol.
+  void feed(const std::complex<float> *samples, size_t numSamps,
+            const std::complex<float> *eye, size_t numEye,
+            const std::complex<float> *symbols, size_t numSyms);
+
+  // Finishes what's queued and writes the eye and the sidecar. 0 on success.
+  int close();
+
+  size_t droppedBlocks() const { return dropped; }
+  size_t psdFrames() const { return frames; }
+
+private:
+  struct Chunk {
+    std::vector<std::complex<float>> psd, eye, points;
+    size_t numPsd = 0, numEye = 0, numPoints = 0;
+    uint64_t eyeStart = 0; // Index of eye[0] in the eye stream
+  };
+
+  void work();
+  void analyze(const Chunk &c);
+  void writeEye();
+  int writeSidecar();
+
+  MonitorSettings settings;
+  double sampleRate, centerFreq, sps;
+  const FftPlan &fft;
+  std::vector<float> window;
+  float windowGain; // (sum w)^2
+
+  std::vector<Chunk> chunks;
+  SpscRing<Chunk *> freeChunks, fullChunks;
+  std::atomic<bool> stop{false};
+  std::thread worker;
+  uint64_t eyeIndex = 0;   // Eye stream samples fed so far
+  uint64_t symbolPhase = 0; // Symbols fed so far, for the decimation
+  size_t dropped = 0;
+
+  // Worker side
+  std::vector<std::complex<float>> segments, spectra;
+  std::vector<double> accum;
+  std::vector<float> frame;
+  size_t accumulated = 0, frames = 0, chunksSeen = 0;
+  std::vector<uint32_t> eyeHist;
+  FILE *psdFile = nullptr, *constFile = nullptr;
+  bool closed = false;
+};
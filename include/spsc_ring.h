@@ -0,0 +1,177 @@
+/*
+ * spsc_ring.h - Bounded lock-free single producer / single consumer ring.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  _mm_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
+/*
+ *  Exactly one thread may push and exactly one thread may pop. head and tail
+ *  are free running counters on their own cache lines; each side also keeps
+ *  a cached copy of the other side's counter so the shared line is only
+ *  touched when the ring looks full (or empty).
+ *
+ *  push()/pop() spin while the ring is full/empty: that is the
+ *  backpressure. Past SPINS_BEFORE_WAIT they go to sleep on the other
+ *  side's doorbell (std::atomic::wait, a futex on Linux) so a stalled stage
+ *  gives its core back; a successful tryPush()/tryPop() rings it, which
+ *  costs a fence and, only while someone is asleep, a notify. They give up
+ *  (return false) once `abort` is set; whoever sets it calls wake().
+ */
+template <typename T> class SpscRing {
+public:
+  static constexpr size_t CACHE_LINE = 64;
+  static constexpr int SPINS_BEFORE_WAIT = 256;
+
+  explicit SpscRing(size_t minCapacity) {
+    size_t cap = 2;
+    while (cap < minCapacity)
+      cap <<= 1;
+    slots.resize(cap);
+    mask = cap - 1;
+  }
+
+  bool tryPush(const T &item) {
+    const size_t t = tail.load(std::memory_order_relaxed);
+    if (t - headCache == slots.size()) {
+      headCache = head.load(std::memory_order_acquire);
+      if (t - headCache == slots.size())
+        return false;
+    }
+    slots[t & mask] = item;
+    tail.store(t + 1, std::memory_order_release);
+    ring(pushed);
+    return true;
+  }
+
+  bool tryPop(T &item) {
+    const size_t h = head.load(std::memory_order_relaxed);
+    if (h == tailCache) {
+      tailCache = tail.load(std::memory_order_acquire);
+      if (h == tailCache)
+        return false;
+    }
+    item = slots[h & mask];
+    head.store(h + 1, std::memory_order_release);
+    ring(popped);
+    return true;
+  }
+
+  bool push(const T &item, const std::atomic<bool> &abort) {
+    for (int spins = 0; !tryPush(item);) {
+      if (abort.load(std::memory_order_relaxed))
+        return false;
+      if (spins == 0)
+        fullWaits.fetch_add(1, std::memory_order_relaxed);
+      if (spins < SPINS_BEFORE_WAIT) {
+        cpuRelax();
+        spins++;
+        continue;
+      }
+      sleep(popped, abort, [&] {
+        return tail.load(std::memory_order_relaxed) -
+                   head.load(std::memory_order_acquire) !=
+               slots.size();
+      });
+    }
+    return true;
+  }
+
+  bool pop(T &item, const std::atomic<bool> &abort) {
+    for (int spins = 0; !tryPop(item);) {
+      if (abort.load(std::memory_order_relaxed))
+        return false;
+      if (spins == 0)
+        emptyWaits.fetch_add(1, std::memory_order_relaxed);
+      if (spins < SPINS_BEFORE_WAIT) {
+        cpuRelax();
+        spins++;
+        continue;
+      }
+      sleep(pushed, abort, [&] {
+        return head.load(std::memory_order_relaxed) !=
+               tail.load(std::memory_order_acquire);
+      });
+    }
+    return true;
+  }
+
+  // Gets push()/pop() out of their sleep to look at `abort` again.
+  void wake() {
+    for (Doorbell *d : {&pushed, &popped}) {
+      d->seq.fetch_add(1, std::memory_order_release);
+      d->seq.notify_all();
+    }
+  }
+
+  size_t capacity() const { return slots.size(); }
+  // Approximate when called from a third thread.
+  size_t size() const {
+    return tail.load(std::memory_order_acquire) -
+           head.load(std::memory_order_acquire);
+  }
+  // How often the producer found the ring full / the consumer found it empty.
+  size_t producerStalls() const { return fullWaits.load(); }
+  size_t consumerStalls() const { return emptyWaits.load(); }
+
+private:
+  // Rung by one side after every move; the other side sleeps on it. asleep
+  // saves the notify (a syscall) while nobody is.
+  struct Doorbell {
+    std::atomic<uint32_t> seq{0};
+    std::atomic<bool> asleep{false};
+  };
+
+  // The fences pair up: either ring() sees asleep, or the sleeper's last
+  // look at ready() sees the move that ring() follows.
+  static void ring(Doorbell &d) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (d.asleep.load(std::memory_order_relaxed)) {
+      d.seq.fetch_add(1, std::memory_order_release);
+      d.seq.notify_one();
+    }
+  }
+
+  template <typename Ready>
+  static void sleep(Doorbell &d, const std::atomic<bool> &abort, Ready ready) {
+    const uint32_t seq = d.seq.load(std::memory_order_acquire);
+    d.asleep.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!ready() && !abort.load(std::memory_order_relaxed))
+      d.seq.wait(seq, std::memory_order_acquire);
+    d.asleep.store(false, std::memory_order_relaxed);
+  }
+
+  std::vector<T> slots;
+  size_t mask;
+
+  alignas(CACHE_LINE) std::atomic<size_t> head{0}; // Written by consumer
+  size_t tailCache = 0;                            // Consumer's view of tail
+  std::atomic<size_t> emptyWaits{0};
+
+  alignas(CACHE_LINE) std::atomic<size_t> tail{0}; // Written by producer
+  size_t headCache = 0;                            // Producer's view of head
+  std::atomic<size_t> fullWaits{0};
+
+  alignas(CACHE_LINE) Doorbell pushed; // The consumer sleeps on this
+  alignas(CACHE_LINE) Doorbell popped; // The producer sleeps on this
+};
@@ -0,0 +1,210 @@
+/*
+ * stage_stats.h - Per-stage counters, latency histograms and a stats socket.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ *  Hot path instrumentation for Pipeline stages, built only with
+ *  -DQPSK_STATS (make STATS=1). Without it every hook below is an empty
+ *  inline function and Reporter does nothing, so the stage loops compile to
+ *  exactly what they were.
+ *
+ *  Each thread that runs a stage gets its own slot of counters (thread
+ *  local, allocated the first time it records anything) and is the only
+ *  writer of it: plain relaxed load + store, no locked instructions and no
+ *  shared cache lines in the stage loops. The reporter thread sums the slots
+ *  every interval and prints a [STATUS] table to stderr; with a socket path
+ *  it also answers every connection on that UNIX socket with a JSON snapshot
+ *  of the running totals (e.g. `socat - UNIX-CONNECT:/tmp/qpsk.sock`).
+ *
+ *  Per stage: blocks and items (samples, symbols, bytes: whatever the stage
+ *  counts with items()), time spent inside the stage function, a latency
+ *  histogram of it, and in threaded runs how full the ring into the stage
+ *  was when a block came off it, how often the stage found that ring empty
+ *  (underruns) and how often it found the ring out full (overruns).
+ */
+namespace stats {
+
+constexpr size_t MAX_STAGES = 16;
+
+#if defined(QPSK_STATS)
+constexpr bool ENABLED = true;
+
+/*
+ *  HDR style log-linear buckets over nanoseconds: values below 32 get a
+ *  bucket each, above that every power of two is split into 16 linear
+ *  buckets, so any value is known to within 1/16 (6.25%) from 1 ns up to
+ *  the full 64 bit range in 1024 buckets.
+ */
+namespace histogram {
+constexpr unsigned SUB_BITS = 4;
+constexpr size_t SUB_BUCKETS = size_t(1) << SUB_BITS;
+constexpr size_t BUCKETS = 64 * SUB_BUCKETS;
+
+inline size_t bucketOf(uint64_t v) {
+  if (v < 2 * SUB_BUCKETS)
+    return (size_t)v;
+  const unsigned shift = 63 - __builtin_clzll(v) - SUB_BITS;
+  return (shift + 1) * SUB_BUCKETS + (size_t)((v >> shift) - SUB_BUCKETS);
+}
+// The largest value that lands in bucket i.
+inline uint64_t upperBound(size_t i) {
+  if (i < 2 * SUB_BUCKETS)
+    return i;
+  const unsigned shift = (unsigned)(i / SUB_BUCKETS) - 1;
+  const uint64_t base = (uint64_t)(i % SUB_BUCKETS + SUB_BUCKETS) << shift;
+  return base + ((uint64_t(1) << shift) - 1);
+}
+} // namespace histogram
+
+// Written by one thread only, read by the reporter at any time.
+class Counter {
+public:
+  void add(uint64_t n) {
+    v.store(v.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+  }
+  void raise(uint64_t n) { // v = max(v, n)
+    if (n > v.load(std::memory_order_relaxed))
+      v.store(n, std::memory_order_relaxed);
+  }
+  void set(uint64_t n) { v.store(n, std::memory_order_relaxed); }
+  uint64_t get() const { return v.load(std::memory_order_relaxed); }
+
+private:
+  std::atomic<uint64_t> v{0};
+};
+
+struct StageCounters {
+  Counter blocks, items;
+  Counter busyNs, maxNs;
+  Counter fillSum, fillMax, fillSamples; // Ring into the stage, in blocks
+  Counter underruns, overruns;           // Copies of the rings' wait counts
+  Counter latency[histogram::BUCKETS];
+};
+
+struct alignas(64) ThreadSlot {
+  StageCounters stages[MAX_STAGES];
+};
+
+// The calling thread's slot (allocated on first use).
+ThreadSlot &threadSlot();
+// Stage the calling thread is running, for items().
+extern thread_local int currentStage;
+
+// A stage's index in the tables by name; -1 once MAX_STAGES are taken.
+int registerStage(const std::string &name);
+
+inline uint64_t now() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// *** === Hooks: Pipeline calls these around every stage function === ***
+inline uint64_t stageBegin(int stage) {
+  currentStage = stage;
+  return now();
+}
+
+inline void stageEnd(int stage, uint64_t begin) {
+  if (stage < 0)
+    return;
+  const uint64_t ns = now() - begin;
+  StageCounters &c = threadSlot().stages[stage];
+  c.blocks.add(1);
+  c.busyNs.add(ns);
+  c.maxNs.raise(ns);
+  c.latency[histogram::bucketOf(ns)].add(1);
+}
+
+// Threaded runs: the ring into the stage right after a pop, and the running
+// empty/full wait counts of the rings in and out of it.
+inline void queueLevel(int stage, size_t fill, size_t underruns,
+                       size_t overruns) {
+  if (stage < 0)
+    return;
+  StageCounters &c = threadSlot().stages[stage];
+  c.fillSum.add(fill);
+  c.fillMax.raise(fill);
+  c.fillSamples.add(1);
+  c.underruns.set(underruns);
+  c.overruns.set(overruns);
+}
+
+// Called from inside a stage function: n more items through this stage.
+inline void items(size_t n) {
+  if (currentStage >= 0)
+    threadSlot().stages[currentStage].items.add(n);
+}
+
+/*
+ *  Sums every thread's slot each `interval` seconds and prints what
+ *  happened since the last time (rates, busy share, p50/p99/max latency,
+ *  ring fill, under/overruns) to stderr; serves the running totals as JSON
+ *  on socketPath if given. The destructor prints the totals for the whole
+ *  run. Inactive (no thread, no output) with interval 0 and no socket.
+ */
+class Reporter {
+public:
+  Reporter(double interval, const std::string &socketPath);
+  ~Reporter();
+  Reporter(const Reporter &) = delete;
+  Reporter &operator=(const Reporter &) = delete;
+
+  bool active() const { return interval > 0.0 || listenFd >= 0; }
+
+private:
+  struct StageTotals {
+    std::string name;
+    uint64_t blocks = 0, items = 0, busyNs = 0, maxNs = 0;
+    uint64_t fillSum = 0, fillMax = 0, fillSamples = 0;
+    uint64_t underruns = 0, overruns = 0;
+    std::vector<uint64_t> latency;
+  };
+
+  std::vector<StageTotals> collect() const;
+  void printSummary(const std::vector<StageTotals> &now,
+                    const std::vector<StageTotals> &before, double secs,
+                    const char *what) const;
+  std::string snapshotJson(const std::vector<StageTotals> &totals) const;
+  void run();
+  void serve();
+
+  double interval;
+  std::string socketPath;
+  int listenFd = -1;
+  std::atomic<bool> stop{false};
+  std::thread thread;
+  std::chrono::steady_clock::time_point start;
+};
+
+#else
+constexpr bool ENABLED = false;
+
+inline int registerStage(const std::string &) { return -1; }
+inline uint64_t stageBegin(int) { return 0; }
+inline void stageEnd(int, uint64_t) {}
+inline void queueLevel(int, size_t, size_t, size_t) {}
+inline void items(size_t) {}
+
+class Reporter {
+public:
+  Reporter(double, const std::string &) {}
+  bool active() const { return false; }
+};
+#endif
+
+} // namespace stats
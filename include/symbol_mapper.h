@@ -0,0 +1,226 @@
+/*
+ * symbol_mapper.h - Compile time constellation tables and symbol mappers.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <array>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+/*
+ *  Every constellation is a family templated on bits per symbol whose
+ *  points() builds the label -> point table at compile time (Gray coded,
+ *  unit average energy). Mapper<Family, Bits> then is nothing but a masked
+ *  table lookup: no branches, no trig, no runtime M.
+ *
+ *  Pick one at runtime with parseModulation() + withMapper(), which hands
+ *  the matching Mapper instantiation to a generic lambda so the loop inside
+ *  it gets compiled once per order.
+ */
+
+namespace constellation {
+// std::sin/std::cos are not constexpr (yet), so a small Taylor series it is.
+constexpr double PI = 3.141592653589793;
+
+constexpr double sinTaylor(double x) {
+  // Reduce to [-pi, pi] first, the series is only good close to 0.
+  while (x > PI)
+    x -= 2 * PI;
+  while (x < -PI)
+    x += 2 * PI;
+  double term = x, sum = x;
+  for (int n = 1; n < 20; n++) {
+    term *= -x * x / ((2 * n) * (2 * n + 1));
+    sum += term;
+  }
+  return sum;
+}
+constexpr double cosTaylor(double x) { return sinTaylor(x + PI / 2); }
+
+constexpr double sqrtNewton(double x) {
+  double r = x > 1 ? x : 1;
+  for (int i = 0; i < 64; i++)
+    r = 0.5 * (r + x / r);
+  return r;
+}
+
+constexpr size_t gray(size_t n) { return n ^ (n >> 1); }
+constexpr size_t invGray(size_t g) {
+  size_t n = g;
+  while (g >>= 1)
+    n ^= g;
+  return n;
+}
+
+template <size_t N>
+constexpr void normalize(std::array<std::complex<float>, N> &pts) {
+  double energy = 0;
+  for (const auto &p : pts)
+    energy += (double)p.real() * p.real() + (double)p.imag() * p.imag();
+  float scale = (float)(1.0 / sqrtNewton(energy / N));
+  for (auto &p : pts)
+    p = {p.real() * scale, p.imag() * scale};
+}
+} // namespace constellation
+
+// M-PSK, Gray coded around the circle. QPSK keeps the 45 degree offset main
+// has always used; BPSK sits on the real axis; higher orders start at pi/M.
+template <size_t Bits> struct PSK {
+  static_assert(Bits >= 1 && Bits <= 8, "PSK order out of range");
+  static constexpr size_t N = size_t(1) << Bits;
+
+  static constexpr std::array<std::complex<float>, N> points() {
+    using namespace constellation;
+    const double offset = (Bits == 1) ? 0.0 : PI / N;
+    std::array<std::complex<float>, N> pts{};
+    for (size_t label = 0; label < N; label++) {
+      double theta = offset + 2 * PI * invGray(label) / N;
+      pts[label] = {(float)cosTaylor(theta), (float)sinTaylor(theta)};
+    }
+    return pts;
+  }
+};
+
+// Square QAM: top Bits/2 bits pick the I level, the rest the Q level, each
+// Gray coded along its axis.
+template <size_t Bits> struct QAM {
+  static_assert(Bits >= 2 && Bits % 2 == 0 && Bits <= 8,
+                "Only square QAM (4, 16, 64, 256)");
+  static constexpr size_t N = size_t(1) << Bits;
+
+  static constexpr std::array<std::complex<float>, N> points() {
+    using namespace constellation;
+    constexpr size_t halfBits = Bits / 2;
+    constexpr size_t L = size_t(1) << halfBits; // Levels per axis
+    std::array<std::complex<float>, N> pts{};
+    for (size_t label = 0; label < N; label++) {
+      size_t iBits = label >> halfBits, qBits = label & (L - 1);
+      float i = 2.0f * invGray(iBits) - (L - 1);
+      float q = 2.0f * invGray(qBits) - (L - 1);
+      pts[label] = {i, q};
+    }
+    normalize(pts);
+    return pts;
+  }
+};
+
+// DVB-S2 style 16APSK: 4 + 12 rings, labels as in EN 302 307 (quasi Gray).
+template <size_t Bits> struct APSK {
+  static_assert(Bits == 4, "Only 16APSK for now");
+  static constexpr size_t N = 16;
+  static constexpr double RING_RATIO = 2.85; // gamma for rate 2/3
+
+  static constexpr std::array<std::complex<float>, N> points() {
+    using namespace constellation;
+    // (outer ring?, angle in units of pi/12) per label
+    constexpr int layout[N][2] = {{1, 3},  {1, -3}, {1, 9},  {1, -9},
+                                  {1, 1},  {1, -1}, {1, 11}, {1, -11},
+                                  {1, 5},  {1, -5}, {1, 7},  {1, -7},
+                                  {0, 3},  {0, -3}, {0, 9},  {0, -9}};
+    std::array<std::complex<float>, N> pts{};
+    for (size_t label = 0; label < N; label++) {
+      double r = layout[label][0] ? RING_RATIO : 1.0;
+      double theta = layout[label][1] * PI / 12;
+      pts[label] = {(float)(r * cosTaylor(theta)),
+                    (float)(r * sinTaylor(theta))};
+    }
+    normalize(pts);
+    return pts;
+  }
+};
+
+template <template <size_t> class Constellation, size_t BitsPerSymbol>
+class Mapper {
+public:
+  static constexpr size_t BITS_PER_SYMBOL = BitsPerSymbol;
+  static constexpr size_t NUM_POINTS = size_t(1) << BitsPerSymbol;
+  static constexpr size_t MASK = NUM_POINTS - 1;
+  static constexpr std::array<std::complex<float>, NUM_POINTS> table =
+      Constellation<BitsPerSymbol>::points();
+
+  static std::complex<float> mapBitsToSymbol(unsigned bits) {
+    return table[bits & MASK];
+  }
+
+  static void map(const uint8_t *labels, size_t numSymbols,
+                  std::complex<float> *out) {
+    for (size_t i = 0; i < numSymbols; i++)
+      out[i] = table[labels[i] & MASK];
+  }
+};
+
+using BPSKMapper = Mapper<PSK, 1>;
+using QPSKSymbolMapper = Mapper<PSK, 2>;
+using PSK8Mapper = Mapper<PSK, 3>;
+using APSK16Mapper = Mapper<APSK, 4>;
+using QAM16Mapper = Mapper<QAM, 4>;
+using QAM64Mapper = Mapper<QAM, 6>;
+
+// *** === Runtime selection === ***
+enum class Modulation { BPSK, QPSK, PSK8, APSK16, QAM16, QAM64 };
+
+inline bool parseModulation(const std::string &name, Modulation &mod) {
+  // clang-format off
+  if      (name == "bpsk")   mod = Modulation::BPSK;
+  else if (name == "qpsk")   mod = Modulation::QPSK;
+  else if (name == "8psk")   mod = Modulation::PSK8;
+  else if (name == "16apsk") mod = Modulation::APSK16;
+  else if (name == "16qam")  mod = Modulation::QAM16;
+  else if (name == "64qam")  mod = Modulation::QAM64;
+  else return false;
+  // clang-format on
+  return true;
+}
+
+inline const char *modulationName(Modulation mod) {
+  switch (mod) {
+  case Modulation::BPSK:
+    return "bpsk";
+  case Modulation::PSK8:
+    return "8psk";
+  case Modulation::APSK16:
+    return "16apsk";
+  case Modulation::QAM16:
+    return "16qam";
+  case Modulation::QAM64:
+    return "64qam";
+  case Modulation::QPSK:
+  default:
+    return "qpsk";
+  }
+}
+
+template <typename Fn> decltype(auto) withMapper(Modulation mod, Fn &&fn) {
+  switch (mod) {
+  case Modulation::BPSK:
+    return fn(BPSKMapper{});
+  case Modulation::PSK8:
+    return fn(PSK8Mapper{});
+  case Modulation::APSK16:
+    return fn(APSK16Mapper{});
+  case Modulation::QAM16:
+    return fn(QAM16Mapper{});
+  case Modulation::QAM64:
+    return fn(QAM64Mapper{});
+  case Modulation::QPSK:
+  default:
+    return fn(QPSKSymbolMapper{});
+  }
+}
+
+inline size_t bitsPerSymbol(Modulation mod) {
+  return withMapper(mod, [](auto m) { return decltype(m)::BITS_PER_SYMBOL; });
+}
+
+inline std::span<const std::complex<float>> constellationPoints(Modulation mod) {
+  return withMapper(mod, [](auto m) {
+    return std::span<const std::complex<float>>(decltype(m)::table);
+  });
+}
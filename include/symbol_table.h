@@ -0,0 +1,52 @@
+/*
+ * symbol_table.h - Precomputed symbol waveforms in one contiguous buffer.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <span>
+
+/*
+ *  Shape: (numSymbols, samplesPerSymbol), row major. Every row starts on a
+ *  cache line so handing rows to the sink (or SIMD code) never straddles a
+ *  line at the start, and there is no vector-of-vectors pointer chasing.
+ *  Rows are handed out as spans; nothing is copied on emission.
+ */
+
+class SymbolTable {
+public:
+  static constexpr size_t ALIGNMENT = 64; // Bytes, one cache line
+
+  SymbolTable(size_t numSymbols, size_t samplesPerSymbol);
+
+  std::span<std::complex<float>> row(size_t s) {
+    return {buffer.get() + s * stride, sps};
+  }
+  std::span<const std::complex<float>> row(size_t s) const {
+    return {buffer.get() + s * stride, sps};
+  }
+  std::span<const std::complex<float>> operator[](size_t s) const {
+    return row(s);
+  }
+
+  size_t size() const { return numSymbols; }
+  size_t samplesPerSymbol() const { return sps; }
+  size_t rowStride() const { return stride; } // In samples, >= sps
+
+private:
+  struct FreeDeleter {
+    void operator()(std::complex<float> *p) const { free(p); }
+  };
+
+  size_t numSymbols;
+  size_t sps;
+  size_t stride;
+  std::unique_ptr<std::complex<float>[], FreeDeleter> buffer;
+};
@@ -0,0 +1,83 @@
+/*
+ * timing_recovery.h - Gardner timing recovery, polyphase interpolator.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+#include "loop_filter.h"
+
+/*
+ *  Matched filter output in, one sample per symbol out.
+ *
+ *  The loop runs on a fractional strobe position: every symbol it advances
+ *  by the current period (nominally sps samples) and reads y_k there and
+ *  y_{k-1/2} half a period earlier through an 8 tap windowed sinc
+ *  interpolator. The interpolator is a bank of NUM_PHASES + 1 filters (mu in
+ *  steps of 1/NUM_PHASES, both ends included), so a sample costs a table
+ *  lookup and one 8 tap dot product, no trig. Rows are stored with every tap
+ *  duplicated, like PulseShapingFilter's, so interleaved samples multiply
+ *  straight in: two AVX multiplies and a horizontal add.
+ *
+ *  Gardner's detector, e = Re{(y_{k-1} - y_k) * conj(y_{k-1/2})}, needs no
+ *  carrier lock, which is why timing goes first. It's divided by a running
+ *  power estimate so the loop bandwidth doesn't depend on the input level,
+ *  and the symbols are scaled by the same estimate on the way out (unit
+ *  average energy, what the Costas loop and demapper expect) once it has
+ *  averaged a few hundred symbols; until then they go out as they are.
+ *
+ *  The strobe position, loop state and the samples the next strobe still
+ *  needs are kept between calls, so blocks can be cut anywhere.
+ */
+class GardnerTimingRecovery {
+public:
+  static constexpr size_t NUM_PHASES = 128;
+  static constexpr size_t INTERP_TAPS = 8;
+
+  // loopBandwidth is BnTs (per symbol); maxDeviation bounds the period to
+  // sps * (1 +- maxDeviation).
+  explicit GardnerTimingRecovery(double sps, float loopBandwidth = 0.01f,
+                                 float damping = 0.707f,
+                                 float maxDeviation = 0.01f);
+
+  // Writes up to maxSymbols(numSamples) symbols, returns how many.
+  size_t process(const std::complex<float> *in, size_t numSamples,
+                 std::complex<float> *symbols);
+  void reset();
+
+  size_t maxSymbols(size_t numSamples) const {
+    size_t n = (size_t)(numSamples / (nominal * (1.0 - maxDev))) + 2;
+    return midpoints ? 2 * n : n;
+  }
+  // OQPSK: output the midpoint before every symbol as well, ahead of it
+  // (mid_k, y_k, mid_k+1, y_k+1, ...: what OqpskRealigner wants), same
+  // scaling, and take Q's timing error at the midpoints.
+  void emitMidpoints(bool on) { midpoints = on; }
+  double period() const { return nominal * (1.0 + correction); } // Samples
+  float timingError() const { return lastError; }
+
+private:
+  std::complex<float> interpolate(double position) const;
+
+  double nominal;
+  double maxDev;
+  LoopGains gains;
+  std::vector<float> bank; // (NUM_PHASES + 1) rows of 2 * INTERP_TAPS
+
+  std::vector<std::complex<float>> work; // Carried samples + new block
+  double strobe;                         // Next strobe, index into work
+  double integrator = 0.0;
+  double correction = 0.0;
+  std::complex<float> prevSymbol = 0.0f;
+  std::complex<float> prevMid = 0.0f; // OQPSK's Q symbol before this one
+  float power = 0.0f;
+  size_t strobes = 0; // Counted up to POWER_WARMUP
+  float lastError = 0.0f;
+  bool midpoints = false;
+};
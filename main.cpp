@@ -12,153 +12,550 @@
 #include <cstdio>
 #include <format>
 #include <iostream>
+#include <optional>
+#include <span>
 #include <string>
+#include <thread>
+#include <unistd.h>
 #include <vector>
 
-#define PI 3.14159265359f
-#define SPS ceil((float)config::SAMP_RATE / config::BAUD_RATE)
+#include "bit_stream_reader.h"
+#include "channel_model.h"
+#include "config.h"
+#include "convolutional_code.h"
+#include "frame_sync.h"
+#include "nco.h"
+#include "ofdm.h"
+#include "output_handler.h"
+#include "packet.h"
+#include "pipeline.h"
+#include "pulse_shaping_filter.h"
+#include "reed_solomon.h"
+#include "resampler.h"
+#include "sample_format.h"
+#include "spectrum_monitor.h"
+#include "stage_stats.h"
+#include "symbol_mapper.h"
+#include "symbol_table.h"
+
 /*
  *  Write iq signals into a binary file in complex float 32 format.
+ *  Everything that used to be a compile time constant is in Config now
+ *  (see config.h), e.g. ./main --baud-rate 2400 --samp-rate 2.56M.
  */
 
-// clang-format off
-namespace config{
-constexpr size_t       M                  =                                2;
-constexpr size_t       numTxSym           =                              300;
-constexpr size_t       numSymbols         =              0x0001 << config::M;
-constexpr float        fc                 =                          2440.0f; // Carrier frequency
-constexpr unsigned int SAMP_RATE          =                        1'000'000;
-constexpr unsigned int BAUD_RATE          =                              940;
-constexpr float        dt                 =      (float) 1/config::SAMP_RATE;
-constexpr unsigned int BIT_RATE           =            M * config::BAUD_RATE;
-// constexpr unsigned int samplesPerSymbol=                              SPS;
-
-// compile time functions
-constexpr float        RAD2DEG(float radians)         { return (float) radians * 180 / PI; }
-constexpr float        DEG2RAD(float degrees)         { return (float) degrees * PI / 180; }
-constexpr size_t       fVEC_SIZE(std::vector<std::complex<float>> vec){ return (size_t) 2 * vec.size() * sizeof(float); }
-}
-// clang-format on
+// A block of symbols on its way through the TX pipeline.
+struct TxBlock {
+  std::vector<uint8_t> symIdx;
+  std::vector<std::complex<float>> symVals;
+  std::vector<std::complex<float>> oversampled; // RRC output (--oversample)
+  std::vector<std::span<const std::complex<float>>> iqViews;
+  std::vector<std::complex<float>> iqBlock;
+  std::vector<uint8_t> packed; // iqBlock in the output format (not cf32)
+  size_t numSyms = 0;
+  size_t numSamps = 0;
+};
+constexpr size_t PIPELINE_DEPTH = 8; // Blocks in flight
 
 // *** === Prototypes === ***
 int writeIQToFile(const std::string &filename,
-                  const std::vector<std::complex<float>> &iq_data);
-void mapSymToIQ(std::vector<std::vector<std::complex<float>>> &symbolMap,
-                const std::vector<std::complex<float>> &symbols);
+                  std::span<const std::complex<float>> iq_data);
+void mapSymToIQ(SymbolTable &symbolMap,
+                const std::vector<std::complex<float>> &symbols,
+                const Config &cfg, float carrierFreq);
 int iqGenerator(const std::vector<std::complex<float>> &symbols,
-                const std::vector<std::vector<std::complex<float>>> &symbolMap);
+                const SymbolTable &symbolMap);
 // *** ===            === ***
 
-int main(void) {
-  std::vector<std::complex<float>> symbols(config::numSymbols);
-  float d_angleStep = (float)360 / (config::numSymbols);
-  float d_initAngle = 45;
-
-  // Just put all the constellation in one cirle for now...
-  for (int e = 0; e < symbols.size();
-       e++) { // .size() returns number of elements; .capacity() allocated size.
-    symbols[e] =
-        std::polar(1.0f, config::DEG2RAD(d_initAngle + e * d_angleStep));
+int main(int argc, char *argv[]) {
+  Config cfg;
+  for (int a = 1; a < argc; a++) {
+    Config::ParseResult r = cfg.parseArg(argc, argv, a);
+    if (r == Config::ParseResult::Error)
+      return 1;
+    if (r == Config::ParseResult::Unknown) {
+      fprintf(stderr, "Usage: %s [options] < bits\n", argv[0]);
+      Config::usage(stderr);
+      return 1;
+    }
   }
+  if (cfg.finalize() != 0)
+    return 1;
+  const int verbosity = cfg.verbosity;
+  if (verbosity >= 1)
+    cfg.print(stdout);
+
+  // The constellation itself is a compile time table (see symbol_mapper.h);
+  // the label of a symbol is its index in there.
+  std::span<const std::complex<float>> points = constellationPoints(cfg.mod);
+  std::vector<std::complex<float>> symbols(points.begin(), points.end());
 
   for (std::complex<float> sym : symbols) {
     printf("%02.2f + 1j*%02.2f  \t<==>  \t", sym.real(), sym.imag());
     printf("(r, theta) = (%.2f, %.2f)\n", std::abs(sym),
-           config::RAD2DEG(std::arg(sym)));
+           RAD2DEG(std::arg(sym)));
   }
 
-  // Initialize our symbolMap vector of vectors with zeros
-  // Shape of array: (numSymbols, samplesPerSymbol)
-  std::vector<std::vector<std::complex<float>>> symbolMap(
-      config::numSymbols,                     // =4
-      std::vector<std::complex<float>>(SPS)); // =1064
-
-  mapSymToIQ(symbolMap, symbols);
-
-  // Main loop
-  char byteInput = 97;
-  size_t bitsAccum = 0;
-  size_t rxBit, idx = 0x00; // For now let's just say the bit value of the
-  // symbol is its index in the symbols vector. Keep this an explicit decision
-  // with idx.
-  std::vector<std::complex<float>> iqSym(SPS);
-
-  while (std::cin.get(byteInput)) {
-    bool dataBit = byteInput & 0x01;
-    // Accumulate bits until you get to the size you want,
-    // then get the index of the sym and proceed with the processing...
-    rxBit = ((rxBit << 1) ^ dataBit) & ((0x1 << config::M) - 1);
-    bitsAccum++;
-    if (bitsAccum == config::M) {
-      idx = rxBit;
-      std::cout << "Read a bit! It's " << idx << std::endl;
-      iqSym = symbolMap[idx];
-      bitsAccum = 0;
-      rxBit = 0;
-      idx = 0;
-      writeIQToFile("./data/qpsk.iq", iqSym);
+  // Initialize our symbolMap table with zeros
+  // Shape of array: (numSymbols, ceil(samplesPerSymbol)), one contiguous
+  // block. With a fractional sps, symbols take floor or ceil(sps) samples
+  // (see SymbolClock) so each one uses a prefix of its row.
+  const size_t maxSps = cfg.sps.ceil();
+  SymbolTable symbolMap(symbols.size(), // =4 for QPSK
+                        maxSps);        // =1064
+
+  // The carrier can only be baked into the table if every symbol starts at
+  // the same carrier phase, i.e. a whole number of cycles per symbol (and a
+  // whole number of samples). Otherwise the table stays at baseband and the
+  // NCO carries the phase across symbol boundaries.
+  const bool carrierInTable = cfg.carrierInTable;
+  mapSymToIQ(symbolMap, symbols, cfg,
+             carrierInTable ? (float)cfg.carrierFreq : 0.0f);
+  NCO carrier(cfg.carrierFreq, cfg.sampleRate);
+  // sps = num/den exactly: design at num samples a symbol, keep every den-th.
+  // With --oversample K (or when num is too big for that): K samples a
+  // symbol, then the resampler takes them to num/den.
+  const size_t oversample = cfg.shaped ? cfg.oversample : 0;
+  PulseShapingFilter rrcFilter(
+      cfg.rollOff, oversample ? oversample : cfg.sps.num, cfg.spanSymbols,
+      PulseShape::RootRaisedCosine, Window::Rectangular,
+      oversample ? 1 : cfg.sps.den);
+  Resampler resampler(oversample ? cfg.sps.num : 1,
+                      oversample ? cfg.sps.den * oversample : 1,
+                      oversample ? cfg.resamplerPassband
+                                 : Resampler::DEFAULT_PASSBAND);
+  SymbolClock symbolClock(cfg.sps);
+  // --ofdm: the labels go onto subcarriers instead (no table, no RRC).
+  const bool ofdm = cfg.ofdm.active();
+  OfdmSettings standIn; // Single carrier: a small one, never run
+  standIn.fftSize = 64;
+  OfdmModulator ofdmMod(ofdm ? cfg.ofdm : standIn, cfg.mod);
+
+  // Main loop, as a pipeline: read -> modulate -> [channel] -> write.
+  // For now let's just say the bit value of the symbol is its index in the
+  // symbols vector. Keep this an explicit decision with symIdx.
+  // Framing (--frame) and the convolutional code (--conv) put a bit stage
+  // between the reader and the symbol labels: the reader hands out bytes
+  // (frame bodies) or single bits, and whatever comes out of the frames and
+  // the encoder is regrouped into symbols.
+  const bool framed = cfg.frameBytes > 0;
+  const bool coded = cfg.convolutional;
+  const bool bitStage = framed || coded;
+  BitStreamReader bitReader(STDIN_FILENO,
+                            framed  ? 8
+                            : coded ? 1
+                                    : cfg.bitsPerSymbol,
+                            cfg.inMode, cfg.inOrder);
+  ConvEncoder encoder(cfg.invertG2);
+  ReedSolomon rs;
+  Randomizer randomizer(cfg.frameBytes);
+  // Big enough to take the filter tail in one go. OFDM: whole OFDM symbols'
+  // worth of labels (the few carried over never make up another one).
+  const size_t symsPerBlock =
+      ofdm ? ofdmMod.dataCarriers() *
+                 std::max<size_t>(1, (1 << 16) / ofdmMod.symbolLength())
+           : std::max<size_t>(rrcFilter.tapsPerPhase() - 1,
+                              std::max<size_t>(1, (1 << 16) / maxSps));
+  const size_t blockSamps =
+      ofdm         ? ofdmMod.maxOutput(symsPerBlock)
+      : oversample ? resampler.maxOutput(symsPerBlock * oversample)
+                   : symsPerBlock * maxSps;
+  FormatConverter converter(formatFromFilename(cfg.outFile), cfg.fullScale,
+                            cfg.dither);
+  const bool packing = converter.format() != SampleFormat::CF32;
+  // Impairments (--esn0, --cfo, ...) on the rendered block, before it's
+  // converted. A drifting clock can hand back a few more samples than went
+  // in, hence the room.
+  const bool impaired = cfg.channel.active();
+  // Es is per subcarrier symbol with OFDM: n / used samples' worth of
+  // unit power, the prefix not counted.
+  ChannelModel channel(cfg.channel, cfg.sampleRate,
+                       ofdm ? (double)cfg.ofdm.fftSize / ofdmMod.usedCarriers()
+                            : cfg.sps.value());
+  const size_t blockRoom = channel.maxOutput(blockSamps);
+  // Rows of symbolMap go out as views when the carrier is in the table (and
+  // nothing has to be repacked); every other mode renders into the block.
+  const bool shaped = cfg.shaped && !ofdm;
+  const bool monitoring = cfg.monitor.active();
+  const bool useViews = carrierInTable && !shaped && !packing && !impaired &&
+                        !ofdm && !monitoring;
+
+  // One sink for the whole run; the file stays open until we return.
+  OutputHandler iqOut(cfg.outFile);
+  if (!iqOut.isOpen())
+    return 1;
+  if (verbosity >= 1)
+    printf("[NOTE] Writing %s samples to %s\n", formatName(converter.format()),
+           cfg.outFile.c_str());
+
+  // What goes out (after the channel): its PSD, and the mapped points when
+  // there are any. No eye, the pulses are still on the carrier here.
+  std::optional<SpectrumMonitor> monitor;
+  if (monitoring) {
+    monitor.emplace(cfg.monitor, cfg.sampleRate, 0.0, 0.0);
+    if (!monitor->isOpen())
+      return 1;
+  }
+
+  Pipeline<TxBlock> tx(PIPELINE_DEPTH, [&](TxBlock &b) {
+    b.symIdx.resize(symsPerBlock);
+    b.symVals.resize(shaped ? symsPerBlock : 0);
+    b.oversampled.resize(shaped && oversample ? symsPerBlock * oversample : 0);
+    b.iqViews.resize(symsPerBlock);
+    b.iqBlock.resize(useViews ? 0 : blockRoom);
+    b.packed.resize(packing ? blockRoom * converter.bytesPerSample() : 0);
+  });
+
+  // --pin: stage s on CPU s (wrapping around if we are short on cores).
+  const unsigned numCpus = std::max(1u, std::thread::hardware_concurrency());
+  auto cpuFor = [&](int s) { return cfg.pinCpus ? (int)(s % numCpus) : -1; };
+
+  // Channel bits that haven't made up a whole symbol yet, and room for a
+  // block's worth of new ones plus a frame (and the encoder flush).
+  const size_t M = cfg.bitsPerSymbol;
+  const size_t frameBits = framed ? 8 * (ccsds::ASM_BITS / 8 + cfg.frameBytes)
+                                  : 0;
+  const size_t bodyData =
+      cfg.rsDepth > 0 ? rs::K * cfg.rsDepth : cfg.frameBytes;
+  std::vector<uint8_t> frame(framed ? frameBits / 8 : 0);
+  std::vector<uint8_t> dataBits(bitStage ? symsPerBlock * M + frameBits : 0);
+  std::vector<uint8_t> chanBits(
+      bitStage ? symsPerBlock * M + 2 * frameBits + 2 * M + 16 : 0);
+  size_t numChan = 0;
+  bool flushed = false;
+  // readSymbols() can come back short without being at the end (it only
+  // blocks while it has nothing to hand back), so keep at it until 0.
+  auto readFully = [&](uint8_t *out, size_t want) -> size_t {
+    size_t n = 0;
+    for (size_t got = 1; n < want && got > 0; n += got)
+      got = bitReader.readSymbols(out + n, want - n);
+    return n;
+  };
+  // --packet: the frame bodies are cut from a stream of packets instead.
+  // A body's worth is sealed at a time, each payload read straight into
+  // place; the last packet is as long as what's left of the input.
+  Packetizer packetizer(cfg.packet);
+  std::vector<uint8_t> packets;
+  size_t packetsAt = 0; // Sent up to here
+  bool inputDone = false;
+  auto readPackets = [&](uint8_t *out, size_t want) -> size_t {
+    size_t n = 0;
+    while (n < want) {
+      if (packetsAt == packets.size()) {
+        packets.clear();
+        packetsAt = 0;
+        while (packets.size() < want && !inputDone) {
+          const size_t at = packets.size();
+          packets.resize(at + packetizer.maxPacketBytes());
+          uint8_t *payload = &packets[at + packet::HEADER_BYTES];
+          const size_t got = readFully(payload, cfg.packet.maxPayload);
+          inputDone = got < cfg.packet.maxPayload;
+          packets.resize(got > 0 ? at + packetizer.seal(&packets[at], got)
+                                 : at);
+        }
+        if (packets.empty())
+          break;
+      }
+      const size_t take = std::min(want - n, packets.size() - packetsAt);
+      std::copy(packets.begin() + packetsAt,
+                packets.begin() + packetsAt + take, out + n);
+      packetsAt += take;
+      n += take;
+    }
+    return n;
+  };
+  // One frame (or a block's worth of bits) off stdin; 0 at the end. A short
+  // last frame body is filled with zeros.
+  auto nextBits = [&](size_t want) -> size_t {
+    if (!framed)
+      return bitReader.readSymbols(dataBits.data(), want);
+    uint8_t *body = frame.data() + ccsds::ASM_BITS / 8;
+    const size_t n = cfg.packet.active() ? readPackets(body, bodyData)
+                                         : readFully(body, bodyData);
+    if (n == 0)
+      return 0;
+    std::fill(body + n, body + cfg.frameBytes, 0);
+    if (cfg.rsDepth > 0)
+      rs.encodeInterleaved(body, cfg.rsDepth);
+    if (cfg.randomize)
+      randomizer.apply(body);
+    for (unsigned k = 0; k < ccsds::ASM_BITS / 8; k++)
+      frame[k] = (uint8_t)(ccsds::ASM >> (ccsds::ASM_BITS - 8 - 8 * k));
+    for (size_t k = 0; k < frameBits; k++)
+      dataBits[k] = (frame[k / 8] >> (7 - k % 8)) & 1;
+    return frameBits;
+  };
+  // --preamble: framed output starts with symbol 0 and its opposite in turn
+  // (a tone at half the symbol rate), for rx's carrier and timing loops to
+  // pull in on before the first ASM goes by.
+  size_t preambleLeft = framed ? cfg.preambleSymbols : 0;
+  uint8_t opposite = 0;
+  for (size_t k = 1; k < points.size(); k++)
+    if (std::norm(points[k] + points[0]) <
+        std::norm(points[opposite] + points[0]))
+      opposite = (uint8_t)k;
+  auto readBits = [&](uint8_t *symIdx) -> size_t {
+    if (preambleLeft > 0) {
+      const size_t n = std::min(preambleLeft, symsPerBlock);
+      for (size_t k = 0; k < n; k++, preambleLeft--)
+        symIdx[k] = preambleLeft % 2 ? opposite : 0;
+      return n;
+    }
+    const size_t blockBits = symsPerBlock * M;
+    while (numChan < blockBits && !flushed) {
+      const size_t want = (blockBits - numChan + 1) / (coded ? 2 : 1);
+      size_t n = nextBits(want);
+      if (n > 0 && coded) {
+        numChan += encoder.encode(dataBits.data(), n, &chanBits[numChan]);
+        continue;
+      }
+      if (n > 0) {
+        std::copy(dataBits.begin(), dataBits.begin() + n,
+                  chanBits.begin() + numChan);
+        numChan += n;
+        continue;
+      }
+      if (coded)
+        numChan += encoder.flush(&chanBits[numChan]);
+      while (numChan % M != 0) // Pad the last symbol out with zeros
+        chanBits[numChan++] = 0;
+      flushed = true;
+    }
+    const size_t numSyms = std::min(numChan / M, symsPerBlock);
+    for (size_t k = 0; k < numSyms; k++) {
+      uint8_t label = 0;
+      for (size_t j = 0; j < M; j++)
+        label = (uint8_t)((label << 1) | chanBits[k * M + j]);
+      symIdx[k] = label;
+    }
+    std::copy(chanBits.begin() + numSyms * M, chanBits.begin() + numChan,
+              chanBits.begin());
+    numChan -= numSyms * M;
+    return numSyms;
+  };
+
+  size_t numTxSym = 0;
+  tx.addStage(
+      "read",
+      [&](TxBlock &b) {
+        b.numSyms = bitStage ? readBits(b.symIdx.data())
+                             : bitReader.readSymbols(b.symIdx.data(),
+                                                     symsPerBlock);
+        if (b.numSyms == 0)
+          return StageResult::Done;
+        if (verbosity >= 2)
+          for (size_t k = 0; k < b.numSyms; k++)
+            printf("Read a symbol! It's %d\n", b.symIdx[k]);
+        numTxSym += b.numSyms;
+        stats::items(b.numSyms);
+        return StageResult::Ok;
+      },
+      cpuFor(0));
+
+  tx.addStage(
+      "modulate",
+      [&](TxBlock &b) {
+        if (ofdm) {
+          b.numSamps =
+              ofdmMod.modulate(b.symIdx.data(), b.numSyms, b.iqBlock.data());
+          carrier.mix(b.iqBlock.data(), b.iqBlock.data(), b.numSamps);
+          stats::items(b.numSamps);
+          return StageResult::Ok;
+        }
+        if (shaped) {
+          // symbols -> polyphase RRC -> carrier, straight into iqBlock.
+          // Dispatch once per block; the lookup loop is the specialized one.
+          withMapper(cfg.mod, [&](auto mapper) {
+            mapper.map(b.symIdx.data(), b.numSyms, b.symVals.data());
+          });
+          if (oversample) {
+            const size_t n = rrcFilter.interpolate(
+                b.symVals.data(), b.numSyms, b.oversampled.data());
+            b.numSamps =
+                resampler.process(b.oversampled.data(), n, b.iqBlock.data());
+          } else {
+            b.numSamps = rrcFilter.interpolate(b.symVals.data(), b.numSyms,
+                                               b.iqBlock.data());
+          }
+          carrier.mix(b.iqBlock.data(), b.iqBlock.data(), b.numSamps);
+          stats::items(b.numSamps);
+          return StageResult::Ok;
+        }
+
+        b.numSamps = 0;
+        for (size_t k = 0; k < b.numSyms; k++) {
+          b.iqViews[k] = symbolMap[b.symIdx[k]].first(symbolClock.next());
+          b.numSamps += b.iqViews[k].size();
+        }
+        stats::items(b.numSamps);
+        if (useViews)
+          return StageResult::Ok;
+        size_t pos = 0;
+        for (size_t k = 0; k < b.numSyms; k++) {
+          const size_t len = b.iqViews[k].size();
+          if (carrierInTable)
+            std::copy(b.iqViews[k].begin(), b.iqViews[k].end(),
+                      b.iqBlock.begin() + pos);
+          else
+            carrier.mix(b.iqViews[k].data(), b.iqBlock.data() + pos, len);
+          pos += len;
+        }
+        return StageResult::Ok;
+      },
+      cpuFor(1));
+
+  if (impaired)
+    tx.addStage(
+        "channel",
+        [&](TxBlock &b) {
+          b.numSamps =
+              channel.process(b.iqBlock.data(), b.numSamps, b.iqBlock.data());
+          stats::items(b.numSamps);
+          return StageResult::Ok;
+        },
+        cpuFor(2));
+
+  // Stages after modulate and the optional channel stage.
+  const int nextCpu = impaired ? 3 : 2;
+  // Only copies a little of each block; shares the CPU of the stage before.
+  if (monitoring)
+    tx.addStage(
+        "monitor",
+        [&](TxBlock &b) {
+          monitor->feed(b.iqBlock.data(), b.numSamps, nullptr, 0,
+                        b.symVals.data(), shaped ? b.numSyms : 0);
+          stats::items(b.numSamps);
+          return StageResult::Ok;
+        },
+        cpuFor(nextCpu - 1));
+
+  if (packing)
+    tx.addStage(
+        "convert",
+        [&](TxBlock &b) {
+          converter.convert(b.iqBlock.data(), b.numSamps, b.packed.data());
+          stats::items(b.numSamps);
+          return StageResult::Ok;
+        },
+        cpuFor(nextCpu));
+
+  tx.addStage(
+      "write",
+      [&](TxBlock &b) {
+        int ret;
+        if (useViews)
+          ret = iqOut.writeViews(b.iqViews.data(), b.numSyms);
+        else if (packing)
+          ret = iqOut.writeBytes(b.packed.data(),
+                                 b.numSamps * converter.bytesPerSample());
+        else
+          ret = iqOut.writeToFile(b.iqBlock.data(), b.numSamps);
+        stats::items(b.numSamps);
+        return (ret == 0) ? StageResult::Ok : StageResult::Error;
+      },
+      cpuFor(packing ? nextCpu + 1 : nextCpu));
+
+  // Prints its totals when it goes out of scope, after everything below.
+  stats::Reporter reporter(cfg.statsInterval, cfg.statsSocket);
+  if ((cfg.threaded ? tx.runThreaded() : tx.runFused()) != 0)
+    return 1;
+
+  if (shaped || ofdm) {
+    // Let the last symbols ring out of the filter (or pad out the last OFDM
+    // symbol).
+    std::vector<std::complex<float>> tail(blockRoom);
+    size_t numSamps = ofdm ? ofdmMod.flush(tail.data())
+                           : rrcFilter.flush(tail.data());
+    if (shaped && oversample) {
+      std::vector<std::complex<float>> ringing(tail.begin(),
+                                               tail.begin() + numSamps);
+      numSamps = resampler.process(ringing.data(), ringing.size(), tail.data());
+      numSamps += resampler.flush(tail.data() + numSamps);
     }
+    carrier.mix(tail.data(), tail.data(), numSamps);
+    if (impaired)
+      numSamps = channel.process(tail.data(), numSamps, tail.data());
+    if (monitor)
+      monitor->feed(tail.data(), numSamps, nullptr, 0, nullptr, 0);
+    std::vector<uint8_t> packedTail(numSamps * converter.bytesPerSample());
+    converter.convert(tail.data(), numSamps, packedTail.data());
+    if (iqOut.writeBytes(packedTail.data(), packedTail.size()) != 0)
+      return 1;
   }
 
-  return 0;
+  if (monitor && monitor->close() != 0)
+    return 1;
+
+  if (converter.clippedSamples() > 0)
+    fprintf(stderr,
+            "[WARNING] %zu samples clipped converting to %s. "
+            "Try a larger --full-scale.\n",
+            converter.clippedSamples(), formatName(converter.format()));
+
+  if (verbosity >= 1 && cfg.threaded) {
+    const auto &stats = tx.getRingStats();
+    for (size_t s = 0; s < stats.size(); s++)
+      printf("[STATUS] %-8s <- %-8s: %zu backpressure stalls, %zu starved\n",
+             tx.getStages()[s + 1].name.c_str(),
+             tx.getStages()[s].name.c_str(), stats[s].producerStalls,
+             stats[s].consumerStalls);
+  }
+  if (verbosity >= 1 && monitor)
+    printf("[STATUS] Monitor: %zu PSD frames, %zu blocks skipped\n",
+           monitor->psdFrames(), monitor->droppedBlocks());
+  if (verbosity >= 1)
+    printf("[STATUS] %zu symbols from %zu input bytes (%zu bits dropped).\n",
+           numTxSym, bitReader.bytesRead(), bitReader.danglingBits());
+
+  return iqOut.close();
 }
 
 int writeIQToFile(const std::string &filename,
-                  const std::vector<std::complex<float>> &iq_data) {
-  FILE *fd;
-
-  fd = fopen(filename.c_str(), "a+b"); // We want to accumulate a large binary
-  if (!fd) {
-    fprintf(stderr, "%s could not be opened!", filename.c_str());
+                  std::span<const std::complex<float>> iq_data) {
+  /*
+   * One shot dump of a whole vector (debug maps etc.). Anything that writes
+   * repeatedly should hold on to its own OutputHandler instead.
+   */
+  const size_t numBytes = fVEC_SIZE(iq_data);
+  OutputHandler out(filename, numBytes);
+  if (!out.isOpen())
     return 1;
-  }
 
-  // Write to file
-  size_t written_bytes = 0;
-  for (const std::complex<float> &samp : iq_data) {
-    float i = samp.real();
-    float q = samp.imag();
-    fwrite(&i, sizeof(float), 1, fd);
-    fwrite(&q, sizeof(float), 1, fd);
-    // Writing to a cf32 format means spending 4 bytes (32 bits) on I and 4
-    // bytes on Q So we spend 8 bytes per sample
-    written_bytes += 2 * sizeof(float);
-  }
+  if (out.writeToFile(iq_data.data(), iq_data.size()) != 0 ||
+      out.close() != 0)
+    return 1;
 
-  if (written_bytes != config::fVEC_SIZE(iq_data)) {
+  if (out.bytesWritten() != numBytes) {
     fprintf(stderr,
             "Not all samples written to file %s. (Only %zu / %zu written.)\n",
-            filename.c_str(), written_bytes, config::fVEC_SIZE(iq_data));
+            filename.c_str(), out.bytesWritten(), numBytes);
     return 1;
   }
-  printf("%d bytes written.\n", (int)config::fVEC_SIZE(iq_data));
-
-  fclose(fd);
+  printf("%d bytes written.\n", (int)numBytes);
 
   return 0;
 }
 
-void mapSymToIQ(std::vector<std::vector<std::complex<float>>> &symbolMap,
-                const std::vector<std::complex<float>> &symbols) {
+void mapSymToIQ(SymbolTable &symbolMap,
+                const std::vector<std::complex<float>> &symbols,
+                const Config &cfg, float carrierFreq) {
   /*
-   * One time only, make a symbol to IQ map with SPS
-   * samples of each symbol.
+   * One time only, make a symbol to IQ map with ceil(sps)
+   * samples of each symbol. carrierFreq = 0 gives baseband rows.
    */
 
-  printf("[NOTE] Requested baud rate: %d for a samplerate of: %d\n"
-         "Can only do baud rate : % .3f.\n ",
-         config::BAUD_RATE, config::SAMP_RATE, (float)config::SAMP_RATE / SPS);
+  printf("[NOTE] Requested baud rate: %g for a samplerate of: %g\n"
+         "Symbols take %llu/%llu samples each, on average.\n",
+         cfg.baudRate, cfg.sampleRate, (unsigned long long)cfg.sps.num,
+         (unsigned long long)cfg.sps.den);
 
   float mag = 1;
-  float phi = config::DEG2RAD(0);
+  float phi = DEG2RAD(0);
 
   // Step 1: Make a template sine wave to manipulate
-  std::vector<std::complex<float>> sineTemplate(SPS);
-
-  for (int i = 0; i < SPS; i++) {
-    sineTemplate[i] =
-        std::polar(mag, (float)2 * PI * config::fc * i * config::dt + phi);
-  }
+  std::vector<std::complex<float>> sineTemplate(symbolMap.samplesPerSymbol());
+  NCO templateNCO(carrierFreq, cfg.sampleRate, phi);
+  templateNCO.generate(sineTemplate.data(), sineTemplate.size());
 
   assert(symbolMap.size() == symbols.size() &&
          "[DEBUG] The number of symbols is not equal to the number of IQ maps. "
@@ -167,7 +564,7 @@ void mapSymToIQ(std::vector<std::vector<std::complex<float>>> &symbolMap,
   printf("[DEBUG] Good. The number of symbols you have is equal to the number "
          "of IQ maps you have to make.\n\n");
 
-  for (int s = 0; s < config::numSymbols; s++) {
+  for (size_t s = 0; s < symbols.size(); s++) {
     mag = std::abs(symbols[s]);
     phi = std::arg(symbols[s]);
     // Transform the values in the vector symbolMap[s] with the values in
@@ -186,22 +583,21 @@ void mapSymToIQ(std::vector<std::vector<std::complex<float>>> &symbolMap,
     // std::transform(input_vector.begin(), input_vector.end(),
     // output_vector.begin(), lambda_func_to_apply);
     std::transform(sineTemplate.begin(), sineTemplate.end(),
-                   symbolMap[s].begin(), lambda_ScaleAndShift);
+                   symbolMap.row(s).begin(), lambda_ScaleAndShift);
 
     // This is a horrible way of doing string formatting, I'll be using C++20
     // instead (it has std::format) std::ostringstream outputFilename;
     // outputFilename << "./data/sine_sym_" << s << ".iq";
     // TEST: Using GNU Radio to see if the signals form the right constellation
     std::string outputFilename = std::format("./data/{}-ary_Map/sine_{:02d}.iq",
-                                             (int)pow(2, config::M), s);
+                                             symbols.size(), s);
     printf("Writing output to file: %s\n", outputFilename.c_str());
     writeIQToFile(outputFilename, symbolMap[s]); // Just for testing
   }
 }
 
-int iqGenerator(
-    const std::vector<std::complex<float>> &symbols,
-    const std::vector<std::vector<std::complex<float>>> &symbolMap) {
+int iqGenerator(const std::vector<std::complex<float>> &symbols,
+                const SymbolTable &symbolMap) {
   /*
    * Will use the sample rate and baud rate from the config to determine how
    * many samples each symbol would need to be represented in IQ.
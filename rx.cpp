@@ -0,0 +1,506 @@
+/*
+ * rx.cpp - Demodulate a recording back to symbols: the receive side of main.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <optional>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "config.h"
+#include "convolutional_code.h"
+#include "costas_loop.h"
+#include "demapper.h"
+#include "fir_filter.h"
+#include "frame_sync.h"
+#include "iq_file_reader.h"
+#include "nco.h"
+#include "ofdm.h"
+#include "output_handler.h"
+#include "packet.h"
+#include "pipeline.h"
+#include "pulse_shaping_filter.h"
+#include "reed_solomon.h"
+#include "resampler.h"
+#include "spectrum_monitor.h"
+#include "stage_stats.h"
+#include "timing_recovery.h"
+
+/*
+ *  The chain from METEOR-M2/meteor-m2.qmd, block by block:
+ *
+ *    file -> DC removal -> carrier down to 0 Hz
+ *         [-> Farrow decimator to K samples a symbol, --oversample K]
+ *         -> RRC matched filter
+ *         -> Gardner timing recovery -> Costas loop -> symbols (cf32)
+ *         [-> PSD / constellation / eye summary files on the side, --monitor]
+ *         [-> demapper -> hard bits (packed) or int8 LLRs, --demap]
+ *         [-> Viterbi on the LLRs before packing, --conv with --demap hard]
+ *         [-> ASM sync -> PN -> RS(255,223), --frame / --rs, frame bodies]
+ *         [-> CRC checked packets, --packet, their payloads]
+ *
+ *  Same settings as main (--mod, --carrier, --samp-rate, --baud-rate,
+ *  --rolloff, --span, --full-scale ...), so `./rx` with main's arguments
+ *  undoes `./main` (with --demap hard, all the way back to the bytes, give
+ *  or take the Costas loop's M-fold phase ambiguity). Every block keeps its
+ *  state between pipeline blocks.
+ */
+
+// A block of samples on its way through the RX pipeline.
+struct RxBlock {
+  std::vector<std::complex<float>> samples;
+  std::vector<std::complex<float>> decimated; // --oversample
+  std::vector<std::complex<float>> filtered;
+  std::vector<std::complex<float>> symbols;
+  std::vector<int8_t> llrs;   // Coded bits on their way to the Viterbi
+  std::vector<int8_t> synced; // Coded frames, ambiguity undone (--frame)
+  std::vector<int8_t> frames; // Frame bodies as LLRs (--frame)
+  std::vector<uint8_t> bits;  // Hard bits, one per byte
+  std::vector<uint8_t> bytes; // What goes to disk when demapping
+  size_t numSamps = 0;
+  size_t numFiltered = 0; // numSamps, or fewer after the decimator
+  size_t numSyms = 0;
+  size_t numBytes = 0;
+};
+constexpr size_t PIPELINE_DEPTH = 8;  // Blocks in flight
+constexpr size_t BLOCK_SAMPS = 1 << 16;
+// The coded ASM from its seventh bit on: by then the encoder holds nothing
+// but marker bits, so these 52 don't depend on what came before. The frames
+// still start at the marker's first bit, 12 coded bits earlier.
+constexpr unsigned CODED_MARKER_SKIP = 2 * (conv::K - 1);
+constexpr unsigned CODED_MARKER_BITS = 2 * ccsds::ASM_BITS - CODED_MARKER_SKIP;
+
+uint64_t codedMarker(bool invertG2) {
+  uint8_t bits[ccsds::ASM_BITS], coded[2 * ccsds::ASM_BITS];
+  for (unsigned k = 0; k < ccsds::ASM_BITS; k++)
+    bits[k] = (ccsds::ASM >> (ccsds::ASM_BITS - 1 - k)) & 1;
+  ConvEncoder(invertG2).encode(bits, ccsds::ASM_BITS, coded);
+  uint64_t marker = 0;
+  for (unsigned k = CODED_MARKER_SKIP; k < 2 * ccsds::ASM_BITS; k++)
+    marker = (marker << 1) | coded[k];
+  return marker;
+}
+
+int main(int argc, char *argv[]) {
+  Config cfg;
+  cfg.outFile = "./data/symbols.iq";
+  for (int a = 1; a < argc; a++) {
+    Config::ParseResult r = cfg.parseArg(argc, argv, a);
+    if (r == Config::ParseResult::Error)
+      return 1;
+    if (r == Config::ParseResult::Unknown) {
+      fprintf(stderr, "Usage: %s -i recording [options]\n", argv[0]);
+      Config::usage(stderr);
+      return 1;
+    }
+  }
+  cfg.shaped = true; // The matched filter and Gardner want RRC pulses
+  if (cfg.finalize() != 0)
+    return 1;
+  if (cfg.verbosity >= 1)
+    cfg.print(stdout);
+
+  IQFileReader reader(cfg.inFile, formatFromFilename(cfg.inFile),
+                      FileAccess::Auto, cfg.fullScale);
+  if (!reader.isOpen())
+    return 1;
+  // An OFDM band spans DC unless the carrier is 0 (the null DC bin), and the
+  // blocker's notch would sit on whichever carriers are there.
+  if (!cfg.ofdm.active() || cfg.carrierFreq == 0.0)
+    reader.enableDcRemoval();
+  OutputHandler symOut(cfg.outFile);
+  if (!symOut.isOpen())
+    return 1;
+
+  // --oversample K: down to K samples a symbol right after the carrier, so
+  // the matched filter and the loops run at K instead of samp-rate / baud.
+  const bool ofdm = cfg.ofdm.active();
+  const bool decimating = !ofdm && cfg.oversample > 0;
+  Resampler decimator(decimating ? cfg.sps.den * cfg.oversample : 1,
+                      decimating ? cfg.sps.num : 1,
+                      decimating ? cfg.resamplerPassband
+                                 : Resampler::DEFAULT_PASSBAND);
+  const double sps = decimating ? (double)cfg.oversample : cfg.sps.value();
+  NCO downconverter(-cfg.carrierFreq, cfg.sampleRate);
+  // Unit gain at the symbol peak: main's RRC has sum(h^2) == sps.
+  std::vector<float> taps = designPulse(PulseShape::RootRaisedCosine,
+                                        cfg.rollOff, sps, cfg.spanSymbols);
+  for (float &tap : taps)
+    tap /= (float)sps;
+  FirFilter matchedFilter(std::move(taps));
+  GardnerTimingRecovery timing(sps, cfg.timingBw);
+  CostasLoop costas(cfg.mod, cfg.carrierBw);
+  // --ofdm (above): CP removal, FFT and pilot equalization instead of the
+  // matched filter and the two loops; the data points go on to the same
+  // demapper.
+  OfdmSettings standIn; // Single carrier: a small one, never run
+  standIn.fftSize = 64;
+  OfdmDemodulator ofdmDemod(ofdm ? cfg.ofdm : standIn);
+  // The baseband PSD, the matched filter output for the eye and the
+  // recovered symbols; OFDM has no eye to speak of.
+  std::optional<SpectrumMonitor> monitor;
+  if (cfg.monitor.active()) {
+    monitor.emplace(cfg.monitor, cfg.sampleRate, cfg.carrierFreq,
+                    ofdm ? 0.0 : sps);
+    if (!monitor->isOpen())
+      return 1;
+  }
+  Demapper demapper(cfg.mod);
+  BitPacker packer;
+  const bool demap = cfg.rxOutput != RxOutput::Symbols;
+  // Soft output stays coded (LLRs for an outside decoder); hard output is
+  // decoded here.
+  const bool decode = cfg.convolutional && cfg.rxOutput == RxOutput::HardBits;
+  ViterbiDecoder viterbi(ViterbiDecoder::DEFAULT_TRACEBACK, cfg.invertG2);
+
+  // Framing. With the code on, the marker is found twice: coded, before the
+  // Viterbi decoder, which settles the phase ambiguity (soft output stops
+  // there, with the coded frames), then decoded, which finds the frames.
+  const bool framed = demap && cfg.frameBytes > 0;
+  const bool coded = framed && cfg.convolutional;
+  const size_t frameBits = 8 * (ccsds::ASM_BITS / 8 + cfg.frameBytes);
+  const size_t bodyBits = 8 * cfg.frameBytes;
+  FrameSync codedSync(2 * frameBits, ambiguityFor(cfg.mod),
+                      codedMarker(cfg.invertG2), CODED_MARKER_BITS,
+                      CODED_MARKER_SKIP, true);
+  FrameSync frameSync(frameBits,
+                      coded ? Ambiguity::None : ambiguityFor(cfg.mod));
+  Randomizer randomizer(cfg.frameBytes);
+  ReedSolomon rs;
+  size_t rsCorrected = 0, rsFailed = 0;
+  // Frame bodies (LLRs) to what gets written: derandomized LLRs, or bytes
+  // after RS decoding (data only). Returns the number of bytes.
+  auto finishFrames = [&](int8_t *bodies, size_t numFrames, uint8_t *out) {
+    size_t numBytes = 0;
+    for (size_t f = 0; f < numFrames; f++) {
+      int8_t *body = bodies + f * bodyBits;
+      if (cfg.rxOutput == RxOutput::SoftBits) {
+        if (cfg.randomize)
+          randomizer.applySoft(body);
+        std::copy(body, body + bodyBits, out + numBytes);
+        numBytes += bodyBits;
+        continue;
+      }
+      uint8_t *bytes = out + numBytes;
+      for (size_t k = 0; k < cfg.frameBytes; k++) {
+        uint8_t byte = 0;
+        for (unsigned j = 0; j < 8; j++)
+          byte = (uint8_t)((byte << 1) | (body[8 * k + j] < 0));
+        bytes[k] = byte;
+      }
+      if (cfg.randomize)
+        randomizer.apply(bytes);
+      if (cfg.rsDepth == 0) {
+        numBytes += cfg.frameBytes;
+        continue;
+      }
+      int corrections[rs::MAX_INTERLEAVE];
+      rs.decodeInterleaved(bytes, cfg.rsDepth, corrections);
+      for (unsigned i = 0; i < cfg.rsDepth; i++) {
+        if (corrections[i] < 0)
+          rsFailed++;
+        else
+          rsCorrected += corrections[i];
+      }
+      numBytes += rs::K * cfg.rsDepth;
+    }
+    return numBytes;
+  };
+
+  // Packets out of the frame data: checked in the write stage, which is
+  // done with the payloads (views into the block) before the next call.
+  const bool packetized = framed && cfg.packet.active() &&
+                          cfg.rxOutput == RxOutput::HardBits;
+  if (cfg.packet.active() && !packetized)
+    fprintf(stderr, "[WARNING] Packets are only checked with --frame and "
+                    "--demap hard; writing what comes out as it is.\n");
+  Deframer deframer(cfg.packet);
+  std::vector<std::span<const uint8_t>> payloads;
+  auto writeData = [&](const uint8_t *bytes, size_t n) {
+    if (!packetized)
+      return symOut.writeBytes(bytes, n);
+    deframer.process(bytes, n, payloads);
+    int ret = 0;
+    for (std::span<const uint8_t> p : payloads)
+      ret |= symOut.writeBytes(p.data(), p.size());
+    return ret;
+  };
+
+  Pipeline<RxBlock> rx(PIPELINE_DEPTH, [&](RxBlock &b) {
+    b.samples.resize(BLOCK_SAMPS);
+    b.decimated.resize(decimating ? decimator.maxOutput(BLOCK_SAMPS) : 0);
+    b.filtered.resize(ofdm ? 0 : BLOCK_SAMPS);
+    b.symbols.resize(ofdm ? ofdmDemod.maxOutput(BLOCK_SAMPS)
+                          : timing.maxSymbols(BLOCK_SAMPS));
+    if (demap) {
+      b.bits.resize(b.symbols.size() * cfg.bitsPerSymbol);
+      b.bytes.resize(b.bits.size());
+    }
+    if (decode) {
+      b.llrs.resize(b.bits.size());
+      // decode() can release up to one traceback's worth more than it's fed
+      b.bits.resize(b.bits.size() + ViterbiDecoder::DEFAULT_TRACEBACK + 1);
+    }
+    if (framed) {
+      // A block can finish off a frame started in the last one, hence the
+      // slack of a couple of frames everywhere.
+      const size_t numLlrs = b.symbols.size() * cfg.bitsPerSymbol;
+      const size_t syncedCap = (numLlrs / (2 * frameBits) + 3) * 2 * frameBits;
+      const size_t bitsCap =
+          coded ? syncedCap / 2 + ViterbiDecoder::DEFAULT_TRACEBACK + 1
+                : numLlrs;
+      const size_t maxFrames = bitsCap / frameBits + 3;
+      b.synced.resize(coded ? syncedCap : 0);
+      b.llrs.resize(std::max(numLlrs, bitsCap));
+      b.bits.resize(bitsCap);
+      b.frames.resize(maxFrames * bodyBits);
+      b.bytes.resize(std::max(maxFrames * bodyBits, syncedCap));
+    }
+  });
+
+  const unsigned numCpus = std::max(1u, std::thread::hardware_concurrency());
+  auto cpuFor = [&](int s) { return cfg.pinCpus ? (int)(s % numCpus) : -1; };
+
+  size_t numSamps = 0, numSyms = 0;
+  // Zeros after the recording, through the decimator's lookahead and the
+  // matched filter's delay, so the last few symbols still come out.
+  const size_t tailSamps =
+      ofdm ? 0
+           : std::min<size_t>(
+                 BLOCK_SAMPS,
+                 (decimating ? decimator.numTaps() / 2 : 0) +
+                     (size_t)std::ceil((cfg.spanSymbols / 2.0 + 1.0) *
+                                       cfg.sps.value()));
+  bool flushed = tailSamps == 0;
+  rx.addStage(
+      "read",
+      [&](RxBlock &b) {
+        auto w = reader.next(BLOCK_SAMPS);
+        if (w.empty() && !flushed) {
+          flushed = true;
+          b.numSamps = tailSamps;
+          std::fill(b.samples.begin(), b.samples.begin() + b.numSamps,
+                    std::complex<float>(0.0f, 0.0f));
+          return StageResult::Ok;
+        }
+        if (w.empty())
+          return StageResult::Done;
+        std::copy(w.begin(), w.end(), b.samples.begin());
+        b.numSamps = w.size();
+        numSamps += b.numSamps;
+        stats::items(b.numSamps);
+        return StageResult::Ok;
+      },
+      cpuFor(0));
+
+  if (ofdm)
+    rx.addStage(
+        "ofdm",
+        [&](RxBlock &b) {
+          downconverter.mix(b.samples.data(), b.samples.data(), b.numSamps);
+          b.numSyms = ofdmDemod.demodulate(b.samples.data(), b.numSamps,
+                                           b.symbols.data());
+          numSyms += b.numSyms;
+          stats::items(b.numSyms);
+          return StageResult::Ok;
+        },
+        cpuFor(1));
+
+  if (!ofdm) {
+    rx.addStage(
+        "filter",
+        [&](RxBlock &b) {
+          downconverter.mix(b.samples.data(), b.samples.data(), b.numSamps);
+          const std::complex<float> *in = b.samples.data();
+          b.numFiltered = b.numSamps;
+          if (decimating) {
+            b.numFiltered = decimator.process(in, b.numSamps,
+                                              b.decimated.data());
+            in = b.decimated.data();
+          }
+          matchedFilter.filter(in, b.numFiltered, b.filtered.data());
+          stats::items(b.numSamps);
+          return StageResult::Ok;
+        },
+        cpuFor(1));
+
+    rx.addStage(
+        "sync",
+        [&](RxBlock &b) {
+          b.numSyms =
+              timing.process(b.filtered.data(), b.numFiltered,
+                             b.symbols.data());
+          costas.process(b.symbols.data(), b.numSyms, b.symbols.data());
+          numSyms += b.numSyms;
+          stats::items(b.numSyms);
+          return StageResult::Ok;
+        },
+        cpuFor(2));
+  }
+
+  // Only copies a little of each block; shares the CPU of the stage before.
+  if (monitor)
+    rx.addStage(
+        "monitor",
+        [&](RxBlock &b) {
+          monitor->feed(b.samples.data(), b.numSamps,
+                        ofdm ? nullptr : b.filtered.data(), b.numFiltered,
+                        b.symbols.data(), b.numSyms);
+          stats::items(b.numSyms);
+          return StageResult::Ok;
+        },
+        cpuFor(ofdm ? 1 : 2));
+
+  if (demap)
+    rx.addStage(
+        "demap",
+        [&](RxBlock &b) {
+          stats::items(b.numSyms);
+          if (framed) {
+            demapper.estimateNoise(b.symbols.data(), b.numSyms);
+            b.numBytes =
+                demapper.soft(b.symbols.data(), b.numSyms, b.llrs.data());
+            return StageResult::Ok;
+          }
+          if (cfg.rxOutput == RxOutput::SoftBits) {
+            demapper.estimateNoise(b.symbols.data(), b.numSyms);
+            b.numBytes = demapper.soft(
+                b.symbols.data(), b.numSyms,
+                reinterpret_cast<int8_t *>(b.bytes.data()));
+            return StageResult::Ok;
+          }
+          size_t numBits;
+          if (decode) {
+            demapper.estimateNoise(b.symbols.data(), b.numSyms);
+            size_t numLlrs =
+                demapper.soft(b.symbols.data(), b.numSyms, b.llrs.data());
+            numBits = viterbi.decode(b.llrs.data(), numLlrs, b.bits.data());
+          } else {
+            numBits =
+                demapper.hard(b.symbols.data(), b.numSyms, b.bits.data());
+          }
+          b.numBytes = packer.pack(b.bits.data(), numBits, b.bytes.data());
+          return StageResult::Ok;
+        },
+        cpuFor(3));
+
+  // numBytes arrives as the number of LLRs in llrs.
+  if (framed)
+    rx.addStage(
+        "frame",
+        [&](RxBlock &b) {
+          const int8_t *llrs = b.llrs.data();
+          size_t numLlrs = b.numBytes;
+          if (coded) {
+            size_t n = codedSync.process(llrs, numLlrs, b.synced.data());
+            if (cfg.rxOutput == RxOutput::SoftBits) {
+              b.numBytes = n * codedSync.frameBits();
+              std::copy(b.synced.begin(), b.synced.begin() + b.numBytes,
+                        reinterpret_cast<int8_t *>(b.bytes.data()));
+              return StageResult::Ok;
+            }
+            size_t numBits = viterbi.decode(
+                b.synced.data(), n * codedSync.frameBits(), b.bits.data());
+            for (size_t k = 0; k < numBits; k++)
+              b.llrs[k] = b.bits[k] ? -127 : 127;
+            numLlrs = numBits;
+          }
+          size_t n = frameSync.process(llrs, numLlrs, b.frames.data());
+          b.numBytes = finishFrames(b.frames.data(), n, b.bytes.data());
+          stats::items(b.numBytes);
+          return StageResult::Ok;
+        },
+        cpuFor(4));
+
+  rx.addStage(
+      "write",
+      [&](RxBlock &b) {
+        int ret = demap ? writeData(b.bytes.data(), b.numBytes)
+                        : symOut.writeToFile(b.symbols.data(), b.numSyms);
+        stats::items(demap ? b.numBytes : b.numSyms);
+        return (ret == 0) ? StageResult::Ok : StageResult::Error;
+      },
+      cpuFor(framed ? 5 : demap ? 4 : 3));
+
+  // Prints its totals when it goes out of scope, after the status lines.
+  stats::Reporter reporter(cfg.statsInterval, cfg.statsSocket);
+  auto start = std::chrono::steady_clock::now();
+  if ((cfg.threaded ? rx.runThreaded() : rx.runFused()) != 0)
+    return 1;
+  double secs = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+
+  // The last traceback's worth. A partial byte left after it is the
+  // encoder's flush bits, not data, and is dropped.
+  if (decode && !framed) {
+    std::vector<uint8_t> tailBits(viterbi.pending());
+    size_t numBits = viterbi.flush(tailBits.data());
+    std::vector<uint8_t> tailBytes(numBits / 8 + 1);
+    size_t n = packer.pack(tailBits.data(), numBits, tailBytes.data());
+    if (symOut.writeBytes(tailBytes.data(), n) != 0)
+      return 1;
+  }
+
+  // Likewise the frames still inside the decoder.
+  if (coded && cfg.rxOutput == RxOutput::HardBits) {
+    std::vector<uint8_t> tailBits(viterbi.pending());
+    size_t numBits = viterbi.flush(tailBits.data());
+    std::vector<int8_t> tailLlrs(numBits);
+    for (size_t k = 0; k < numBits; k++)
+      tailLlrs[k] = tailBits[k] ? -127 : 127;
+    std::vector<int8_t> bodies(frameSync.maxFrames(numBits) * bodyBits);
+    size_t n = frameSync.process(tailLlrs.data(), numBits, bodies.data());
+    std::vector<uint8_t> tailBytes(n * bodyBits);
+    size_t numBytes = finishFrames(bodies.data(), n, tailBytes.data());
+    if (writeData(tailBytes.data(), numBytes) != 0)
+      return 1;
+  }
+
+  if (monitor && monitor->close() != 0)
+    return 1;
+
+  if (cfg.verbosity >= 1) {
+    printf("[STATUS] %zu samples -> %zu symbols in %.3f s (%.1fx real "
+           "time)\n",
+           numSamps, numSyms, secs,
+           secs > 0 ? numSamps / cfg.sampleRate / secs : 0.0);
+    if (!ofdm)
+      printf("[STATUS] Symbol period %.4f samples (nominal %.4f), residual "
+             "carrier %+.2f Hz\n",
+             timing.period(), sps,
+             costas.frequency() * cfg.baudRate / (2 * constellation::PI));
+    if (framed) {
+      // The ambiguity is settled by the first sync, the count by the last.
+      const FrameSync &sync = coded ? codedSync : frameSync;
+      const FrameSync &last = coded && !decode ? codedSync : frameSync;
+      printf("[STATUS] %zu frames, lost lock %zu times, phase %u%s\n",
+             last.framesFound(), sync.lockLosses(), sync.rotation(),
+             sync.conjugated() ? " conjugated" : "");
+      if (cfg.rsDepth > 0)
+        printf("[STATUS] RS: %zu bytes corrected, %zu codewords failed\n",
+               rsCorrected, rsFailed);
+      if (packetized)
+        printf("[STATUS] %zu packets (%zu bytes), %zu failed the CRC, %zu "
+               "bytes skipped\n",
+               deframer.packetsFound(), deframer.payloadBytes(),
+               deframer.crcFailures(), deframer.bytesSkipped());
+    }
+    if (monitor)
+      printf("[STATUS] Monitor: %zu PSD frames, %zu blocks skipped\n",
+             monitor->psdFrames(), monitor->droppedBlocks());
+    if (cfg.rxOutput == RxOutput::SoftBits)
+      printf("[STATUS] N0 %.4g (Es/N0 %.1f dB)\n", demapper.noiseVariance(),
+             -10.0 * std::log10(demapper.noiseVariance()));
+  }
+  return symOut.close();
+}
@@ -0,0 +1,149 @@
+/*
+ * bit_pattern.cpp - Deterministic test bit patterns (constant, alternating, PRBS).
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "bit_pattern.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+struct PatternInfo {
+  Pattern pattern;
+  const char *name;
+  unsigned degree, tap; // LFSR x^degree + x^tap + 1 (0 for non-PRBS)
+};
+
+constexpr PatternInfo PATTERNS[] = {
+    {Pattern::Zeros, "zeros", 0, 0},     {Pattern::Ones, "ones", 0, 0},
+    {Pattern::Alternating, "alt", 0, 0}, {Pattern::PRBS7, "prbs7", 7, 6},
+    {Pattern::PRBS15, "prbs15", 15, 14}, {Pattern::PRBS23, "prbs23", 23, 18},
+    {Pattern::PRBS31, "prbs31", 31, 28},
+};
+
+const PatternInfo &info(Pattern pattern) {
+  for (const PatternInfo &p : PATTERNS)
+    if (p.pattern == pattern)
+      return p;
+  return PATTERNS[0];
+}
+
+// Periods shorter than this get repeated so each memcpy moves a decent chunk.
+constexpr size_t MIN_TABLE_BYTES = 4096;
+// Render the period of anything up to this degree into a table.
+constexpr unsigned MAX_TABLE_DEGREE = 15;
+} // namespace
+
+bool parsePattern(const std::string &name, Pattern &pattern) {
+  for (const PatternInfo &p : PATTERNS)
+    if (name == p.name) {
+      pattern = p.pattern;
+      return true;
+    }
+  return false;
+}
+
+const char *patternName(Pattern pattern) { return info(pattern).name; }
+
+PatternGenerator::PatternGenerator(Pattern pattern) : pat(pattern) {
+  const PatternInfo &pi = info(pattern);
+  degree = pi.degree;
+  tap = pi.tap;
+  stepBits = (tap / 8) * 8;
+  reset();
+
+  // The bit sequence repeats every 2^n - 1 bits, so the byte sequence
+  // repeats every 2^n - 1 bytes (8 periods of bits).
+  std::vector<uint8_t> unit;
+  switch (pattern) {
+  case Pattern::Zeros:
+    unit.assign(1, 0x00);
+    break;
+  case Pattern::Ones:
+    unit.assign(1, 0xff);
+    break;
+  case Pattern::Alternating:
+    unit.assign(1, 0xaa);
+    break;
+  default:
+    if (degree > MAX_TABLE_DEGREE)
+      return;
+    unit.resize((size_t(1) << degree) - 1);
+    for (uint8_t &byte : unit) {
+      byte = 0;
+      for (int b = 0; b < 8; b++) {
+        uint64_t bit = ((history >> (tap - 1)) ^ (history >> (degree - 1)));
+        bit &= 1;
+        history = (history << 1) | bit;
+        byte = uint8_t((byte << 1) | bit);
+      }
+    }
+    reset();
+  }
+
+  const size_t repeats = (MIN_TABLE_BYTES + unit.size() - 1) / unit.size();
+  period.reserve(repeats * unit.size());
+  for (size_t r = 0; r < repeats; r++)
+    period.insert(period.end(), unit.begin(), unit.end());
+}
+
+void PatternGenerator::reset() {
+  history = (degree > 0) ? (uint64_t(1) << degree) - 1 : 0;
+  periodPos = 0;
+}
+
+uint64_t PatternGenerator::periodBits() const {
+  switch (pat) {
+  case Pattern::Zeros:
+  case Pattern::Ones:
+    return 1;
+  case Pattern::Alternating:
+    return 2;
+  default:
+    return (uint64_t(1) << degree) - 1;
+  }
+}
+
+void PatternGenerator::fill(uint8_t *out, size_t numBytes) {
+  if (period.empty()) {
+    stepBytes(out, numBytes);
+    return;
+  }
+  while (numBytes > 0) {
+    size_t n = std::min(numBytes, period.size() - periodPos);
+    memcpy(out, period.data() + periodPos, n);
+    out += n;
+    numBytes -= n;
+    periodPos += n;
+    if (periodPos == period.size())
+      periodPos = 0;
+  }
+}
+
+// With history bit j = s[t-1-j], the next w bits are
+//   s[t+m] = s[t+m-tap] ^ s[t+m-degree],  m = 0..w-1
+// and for w <= tap every one of them is already in history. Putting s[t+m]
+// at bit w-1-m makes the word come out oldest bit first (MSB first).
+void PatternGenerator::stepBytes(uint8_t *out, size_t numBytes) {
+  const unsigned w = stepBits;
+  const size_t wBytes = w / 8;
+  const uint64_t mask = (uint64_t(1) << w) - 1;
+  uint64_t h = history;
+
+  size_t i = 0;
+  for (; i + wBytes <= numBytes; i += wBytes) {
+    uint64_t word = ((h >> (tap - w)) ^ (h >> (degree - w))) & mask;
+    h = (h << w) | word;
+    for (size_t b = 0; b < wBytes; b++)
+      out[i + b] = uint8_t(word >> (w - 8 * (b + 1)));
+  }
+  for (; i < numBytes; i++) { // Tail: a byte at a time (8 <= tap always)
+    uint64_t byte = ((h >> (tap - 8)) ^ (h >> (degree - 8))) & 0xff;
+    h = (h << 8) | byte;
+    out[i] = uint8_t(byte);
+  }
+  history = h;
+}
@@ -0,0 +1,117 @@
+/*
+ * bit_stream_reader.cpp - Block based bits -> M-bit symbol index front end.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "bit_stream_reader.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+
+namespace {
+// Byte bit-reversal so LSB-first input can share the MSB-first path.
+constexpr std::array<uint8_t, 256> REVERSE_BITS = [] {
+  std::array<uint8_t, 256> table{};
+  for (int b = 0; b < 256; b++) {
+    uint8_t r = 0;
+    for (int i = 0; i < 8; i++)
+      r |= ((b >> i) & 0x01) << (7 - i);
+    table[b] = r;
+  }
+  return table;
+}();
+
+// Gather bit 0 of eight consecutive bytes into one byte, first byte in the
+// MSB. The multiply shifts every byte's bit 0 into the top byte at a unique
+// position. Assumes a little endian load.
+inline uint8_t gatherBit0(const uint8_t *bytes) {
+  uint64_t x;
+  memcpy(&x, bytes, sizeof(x));
+  return (uint8_t)(((x & 0x0101010101010101ULL) * 0x8040201008040201ULL) >>
+                   56);
+}
+} // namespace
+
+BitStreamReader::BitStreamReader(int fd, size_t bitsPerSymbol, InputMode mode,
+                                 BitOrder order, size_t chunkBytes)
+    : fd(fd), M(bitsPerSymbol), mode(mode), order(order) {
+  assert(M >= 1 && M <= 8 && "[DEBUG] Symbol indices are stored as uint8_t.");
+  symMask = (0x1ULL << M) - 1;
+
+  // Ring size must be a power of two for the index masking to work.
+  size_t size = 4096;
+  while (size < chunkBytes)
+    size <<= 1;
+  ring.resize(size);
+  ringMask = size - 1;
+}
+
+size_t BitStreamReader::refill() {
+  if (inputDone)
+    return 0;
+
+  // Read as much as fits in the contiguous free region after tail.
+  size_t start = tail & ringMask;
+  size_t len = std::min(ring.size() - available(), ring.size() - start);
+  if (len == 0)
+    return 0;
+
+  for (;;) {
+    ssize_t n = ::read(fd, ring.data() + start, len);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n < 0)
+      fprintf(stderr, "Error reading input bitstream! (%s)\n",
+              strerror(errno));
+    if (n <= 0) {
+      inputDone = true;
+      return 0;
+    }
+    tail += n;
+    totalBytes += n;
+    return n;
+  }
+}
+
+size_t BitStreamReader::readSymbols(uint8_t *symbols, size_t maxSymbols) {
+  size_t n = 0;
+
+  while (n < maxSymbols) {
+    // Top up the accumulator. Only block on read(2) while we have nothing to
+    // hand back yet, so slow producers (emitter) don't stall the output.
+    while (accBits <= 56) {
+      if (head == tail && (n > 0 || refill() == 0))
+        break;
+
+      if (mode == InputMode::Packed) {
+        uint8_t b = ring[head++ & ringMask];
+        acc = (acc << 8) | (order == BitOrder::LsbFirst ? REVERSE_BITS[b] : b);
+        accBits += 8;
+      } else if (available() >= 8 && (head & ringMask) + 8 <= ring.size()) {
+        acc = (acc << 8) | gatherBit0(&ring[head & ringMask]);
+        head += 8;
+        accBits += 8;
+      } else {
+        acc = (acc << 1) | (ring[head++ & ringMask] & 0x01);
+        accBits += 1;
+      }
+    }
+
+    if (accBits < M)
+      break; // Out of input (or nothing buffered and we already have some)
+
+    while (accBits >= M && n < maxSymbols) {
+      accBits -= M;
+      symbols[n++] = (uint8_t)((acc >> accBits) & symMask);
+    }
+  }
+
+  return n;
+}
@@ -0,0 +1,178 @@
+/*
+ * channel_model.cpp - AWGN, carrier offset, clock drift and multipath.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "channel_model.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+constexpr double PI = 3.141592653589793;
+
+// y[i] (+)= g * x[i]
+void scaleAdd(const std::complex<float> *x, std::complex<float> g,
+              std::complex<float> *y, size_t n, bool accumulate) {
+  const float gr = g.real(), gi = g.imag();
+  const float *src = reinterpret_cast<const float *>(x);
+  float *dst = reinterpret_cast<float *>(y);
+  size_t i = 0;
+#if defined(__AVX2__)
+  const __m256 vr = _mm256_set1_ps(gr), vi = _mm256_set1_ps(gi);
+  for (; i + 4 <= n; i += 4) {
+    __m256 a = _mm256_loadu_ps(src + 2 * i);
+    __m256 aSwap = _mm256_permute_ps(a, 0xB1); // xi, xr
+#if defined(__FMA__)
+    __m256 p = _mm256_fmaddsub_ps(a, vr, _mm256_mul_ps(aSwap, vi));
+#else
+    __m256 p = _mm256_addsub_ps(_mm256_mul_ps(a, vr), _mm256_mul_ps(aSwap, vi));
+#endif
+    if (accumulate)
+      p = _mm256_add_ps(p, _mm256_loadu_ps(dst + 2 * i));
+    _mm256_storeu_ps(dst + 2 * i, p);
+  }
+#elif defined(__ARM_NEON)
+  for (; i + 4 <= n; i += 4) {
+    float32x4x2_t a = vld2q_f32(src + 2 * i), p;
+    p.val[0] = vmlsq_n_f32(vmulq_n_f32(a.val[0], gr), a.val[1], gi);
+    p.val[1] = vmlaq_n_f32(vmulq_n_f32(a.val[0], gi), a.val[1], gr);
+    if (accumulate) {
+      float32x4x2_t acc = vld2q_f32(dst + 2 * i);
+      p.val[0] = vaddq_f32(p.val[0], acc.val[0]);
+      p.val[1] = vaddq_f32(p.val[1], acc.val[1]);
+    }
+    vst2q_f32(dst + 2 * i, p);
+  }
+#endif
+  for (; i < n; i++) {
+    const float xr = src[2 * i], xi = src[2 * i + 1];
+    const float pr = xr * gr - xi * gi, pi = xr * gi + xi * gr;
+    dst[2 * i] = accumulate ? dst[2 * i] + pr : pr;
+    dst[2 * i + 1] = accumulate ? dst[2 * i + 1] + pi : pi;
+  }
+}
+} // namespace
+
+bool parseMultipath(const std::string &text, std::vector<ChannelPath> &paths) {
+  paths.clear();
+  const char *p = text.c_str();
+  while (*p) {
+    char *end;
+    const long delay = strtol(p, &end, 10);
+    if (end == p || delay < 0 || *end != ':')
+      return false;
+    p = end + 1;
+    const double mag = strtod(p, &end);
+    if (end == p)
+      return false;
+    p = end;
+    double degrees = 0.0;
+    if (*p == '@') {
+      degrees = strtod(++p, &end);
+      if (end == p)
+        return false;
+      p = end;
+    }
+    paths.push_back({(size_t)delay,
+                     std::polar((float)mag, (float)(degrees * PI / 180.0))});
+    if (*p == ',')
+      p++;
+    else if (*p)
+      return false;
+  }
+  return !paths.empty();
+}
+
+ChannelModel::ChannelModel(const ChannelSettings &settings, double sampleRate,
+                           double samplesPerSymbol)
+    : paths(settings.paths), drifting(settings.clockPpm != 0.0),
+      step(1.0 / (1.0 + settings.clockPpm * 1e-6)), when(1.0),
+      rotating(settings.freqOffset != 0.0 || settings.phaseOffset != 0.0f),
+      rotator(settings.freqOffset, sampleRate,
+              settings.phaseOffset * PI / 180.0),
+      sigma(0.0f), noise(settings.seed) {
+  double power = 0.0;
+  for (const ChannelPath &p : paths) {
+    power += std::norm(p.gain);
+    maxDelay = std::max(maxDelay, p.delay);
+  }
+  if (!paths.empty() && power > 0.0) {
+    const float scale = (float)(1.0 / std::sqrt(power));
+    for (ChannelPath &p : paths)
+      p.gain *= scale;
+  }
+  history.assign(maxDelay, 0.0f);
+  // The interpolator starts one (zero) sample in, on the first input.
+  faded.assign(drifting ? 1 : 0, 0.0f);
+
+  if (std::isfinite(settings.esN0)) {
+    const double n0 = samplesPerSymbol / std::pow(10.0, settings.esN0 / 10.0);
+    sigma = (float)std::sqrt(n0 / 2.0);
+  }
+}
+
+void ChannelModel::fade(const std::complex<float> *in, size_t n,
+                        std::complex<float> *out) {
+  if (paths.empty()) {
+    if (out != in)
+      std::copy(in, in + n, out);
+    return;
+  }
+  history.resize(maxDelay + n);
+  std::copy(in, in + n, history.begin() + maxDelay);
+  for (size_t k = 0; k < paths.size(); k++)
+    scaleAdd(history.data() + maxDelay - paths[k].delay, paths[k].gain, out,
+             n, k > 0);
+  history.erase(history.begin(), history.end() - maxDelay);
+}
+
+// Cubic Lagrange through faded[i - 1 .. i + 2] at i + mu, for every output
+// position with all four there.
+size_t ChannelModel::resample(std::complex<float> *out) {
+  size_t m = 0;
+  for (;; when += step) {
+    const size_t i = (size_t)when;
+    if (i + 2 >= faded.size())
+      break;
+    const float mu = (float)(when - (double)i);
+    const float c0 = -mu * (mu - 1.0f) * (mu - 2.0f) / 6.0f;
+    const float c1 = (mu + 1.0f) * (mu - 1.0f) * (mu - 2.0f) / 2.0f;
+    const float c2 = -(mu + 1.0f) * mu * (mu - 2.0f) / 2.0f;
+    const float c3 = (mu + 1.0f) * mu * (mu - 1.0f) / 6.0f;
+    out[m++] = c0 * faded[i - 1] + c1 * faded[i] + c2 * faded[i + 1] +
+               c3 * faded[i + 2];
+  }
+  // Keep from the sample before the next position on.
+  const size_t drop = (size_t)when - 1;
+  faded.erase(faded.begin(), faded.begin() + drop);
+  when -= (double)drop;
+  return m;
+}
+
+size_t ChannelModel::process(const std::complex<float> *in, size_t n,
+                             std::complex<float> *out) {
+  size_t m = n;
+  if (drifting) {
+    const size_t carried = faded.size();
+    faded.resize(carried + n);
+    fade(in, n, faded.data() + carried);
+    m = resample(out);
+  } else {
+    fade(in, n, out);
+  }
+  if (rotating)
+    rotator.mix(out, out, m);
+  if (sigma > 0.0f)
+    noise.add(out, m, sigma);
+  return m;
+}
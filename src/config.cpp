@@ -0,0 +1,590 @@
+/*
+ * config.cpp - Runtime configuration: CLI, INI or JSON, validated once.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "config.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <sstream>
+#include <thread>
+
+#include "pulse_shaping_filter.h"
+#include "reed_solomon.h"
+#include "resampler.h"
+#include "stage_stats.h"
+
+namespace {
+bool parseBool(const std::string &text, bool &value) {
+  if (text == "true" || text == "1" || text == "yes" || text == "on")
+    value = true;
+  else if (text == "false" || text == "0" || text == "no" || text == "off")
+    value = false;
+  else
+    return false;
+  return true;
+}
+
+bool parseSize(const std::string &text, size_t &value) {
+  double v;
+  if (!parseAmount(text, v) || v != std::floor(v))
+    return false;
+  value = (size_t)v;
+  return true;
+}
+
+bool parseFloat(const std::string &text, float &value) {
+  double v;
+  if (!parseAmount(text, v))
+    return false;
+  value = (float)v;
+  return true;
+}
+
+// Negative carriers are fine (they just sit below DC).
+bool parseFrequency(const std::string &text, double &value) {
+  if (!text.empty() && text[0] == '-') {
+    if (!parseAmount(text.substr(1), value))
+      return false;
+    value = -value;
+    return true;
+  }
+  return parseAmount(text, value);
+}
+
+bool parseSignedFloat(const std::string &text, float &value) {
+  double v;
+  if (!parseFrequency(text, v))
+    return false;
+  value = (float)v;
+  return true;
+}
+
+struct Option {
+  const char *name;
+  const char *arg; // nullptr: a flag, "true" when given on the command line
+  const char *help;
+  bool (*apply)(Config &cfg, const std::string &value);
+};
+
+// clang-format off
+const Option OPTIONS[] = {
+  {"mod", "name", "bpsk|qpsk|8psk|16apsk|16qam|64qam",
+   [](Config &c, const std::string &v) { return parseModulation(v, c.mod); }},
+  {"carrier", "Hz", "Carrier frequency (may be negative)",
+   [](Config &c, const std::string &v) { return parseFrequency(v, c.carrierFreq); }},
+  {"samp-rate", "S/s", "Output sample rate",
+   [](Config &c, const std::string &v) { return parseAmount(v, c.sampleRate); }},
+  {"baud-rate", "Bd", "Symbol rate",
+   [](Config &c, const std::string &v) { return parseAmount(v, c.baudRate); }},
+  {"rect", nullptr, "Rectangular pulses instead of RRC",
+   [](Config &c, const std::string &v) {
+     bool rect = !c.shaped;
+     bool ok = parseBool(v, rect);
+     c.shaped = !rect;
+     return ok; }},
+  {"rolloff", "beta", "RRC roll-off factor",
+   [](Config &c, const std::string &v) { return parseFloat(v, c.rollOff); }},
+  {"span", "symbols", "RRC length",
+   [](Config &c, const std::string &v) { return parseSize(v, c.spanSymbols); }},
+  {"oversample", "sps", "RRC at this many samples/symbol, resampled to samp-rate",
+   [](Config &c, const std::string &v) { return parseSize(v, c.oversample); }},
+  {"conv", "code", "none|ccsds|ccsds-noninverted: r=1/2 K=7 code",
+   [](Config &c, const std::string &v) {
+     if      (v == "none")              c.convolutional = false;
+     else if (v == "ccsds")             c.convolutional = c.invertG2 = true;
+     else if (v == "ccsds-noninverted") c.convolutional = true, c.invertG2 = false;
+     else return false;
+     return true; }},
+  {"frame", "bytes", "CCSDS frames: ASM + this many bytes (0: off)",
+   [](Config &c, const std::string &v) { return parseSize(v, c.frameBytes); }},
+  {"rs", "depth", "RS(255,223) at interleave depth 1..8 (0: off)",
+   [](Config &c, const std::string &v) {
+     size_t d;
+     if (!parseSize(v, d) || d > rs::MAX_INTERLEAVE)
+       return false;
+     c.rsDepth = (unsigned)d;
+     return true; }},
+  {"no-pn", nullptr, "Frames without the CCSDS PN randomizer",
+   [](Config &c, const std::string &v) {
+     bool off = !c.randomize;
+     bool ok = parseBool(v, off);
+     c.randomize = !off;
+     return ok; }},
+  {"preamble", "syms", "Lead-in ahead of the first frame (default 256)",
+   [](Config &c, const std::string &v) { return parseSize(v, c.preambleSymbols); }},
+  {"packet", "bytes", "Packets of up to this many bytes in the frames (0: off)",
+   [](Config &c, const std::string &v) { return parseSize(v, c.packet.maxPayload); }},
+  {"crc", "bits", "Packet CRC: 16 or 32 (default 32)",
+   [](Config &c, const std::string &v) {
+     size_t bits;
+     if (!parseSize(v, bits) || (bits != 16 && bits != 32))
+       return false;
+     c.packet.crcBits = (unsigned)bits;
+     return true; }},
+  {"esn0", "dB", "Channel: AWGN at this Es/N0 (main)",
+   [](Config &c, const std::string &v) { return parseSignedFloat(v, c.channel.esN0); }},
+  {"cfo", "Hz", "Channel: carrier frequency offset",
+   [](Config &c, const std::string &v) { return parseFrequency(v, c.channel.freqOffset); }},
+  {"phase-offset", "deg", "Channel: carrier phase offset",
+   [](Config &c, const std::string &v) { return parseSignedFloat(v, c.channel.phaseOffset); }},
+  {"clock-ppm", "ppm", "Channel: receiver sample clock offset",
+   [](Config &c, const std::string &v) { return parseFrequency(v, c.channel.clockPpm); }},
+  {"multipath", "paths", "Channel: delay:gain[@deg],... (delays in samples)",
+   [](Config &c, const std::string &v) { return parseMultipath(v, c.channel.paths); }},
+  {"seed", "n", "Noise seed (main's channel, ber)",
+   [](Config &c, const std::string &v) {
+     size_t seed;
+     bool ok = parseSize(v, seed);
+     c.channel.seed = ok ? seed : c.channel.seed;
+     return ok; }},
+  {"ofdm", "fft", "OFDM with this many subcarriers (power of two, 0: off)",
+   [](Config &c, const std::string &v) { return parseSize(v, c.ofdm.fftSize); }},
+  {"cp", "samples", "OFDM cyclic prefix (default fft / 4)",
+   [](Config &c, const std::string &v) { return parseSize(v, c.ofdm.cyclicPrefix); }},
+  {"guard", "bins", "OFDM null bins each side of Nyquist (default 5/64 fft)",
+   [](Config &c, const std::string &v) { return parseSize(v, c.ofdm.guard); }},
+  {"pilot-spacing", "n", "OFDM pilot every n used carriers (0: none)",
+   [](Config &c, const std::string &v) { return parseSize(v, c.ofdm.pilotSpacing); }},
+  {"carrier-map", "map", "OFDM bins low to high: d data, p pilot, - null",
+   [](Config &c, const std::string &v) { c.ofdm.map = v; return !v.empty(); }},
+  {"bit-per-byte", nullptr, "Input is one bit per byte (old emitter format)",
+   [](Config &c, const std::string &v) {
+     bool on = c.inMode == InputMode::BitPerByte;
+     bool ok = parseBool(v, on);
+     c.inMode = on ? InputMode::BitPerByte : InputMode::Packed;
+     return ok; }},
+  {"lsb-first", nullptr, "Input bytes go out LSB first",
+   [](Config &c, const std::string &v) {
+     bool on = c.inOrder == BitOrder::LsbFirst;
+     bool ok = parseBool(v, on);
+     c.inOrder = on ? BitOrder::LsbFirst : BitOrder::MsbFirst;
+     return ok; }},
+  {"input", "file", "Recording to demodulate (-i, rx); format by extension",
+   [](Config &c, const std::string &v) { c.inFile = v; return !v.empty(); }},
+  {"output", "file", "Output file (-o); .cs16/.cs8/.cu8 pick the format",
+   [](Config &c, const std::string &v) { c.outFile = v; return !v.empty(); }},
+  {"full-scale", "amp", "Amplitude that maps to integer full scale",
+   [](Config &c, const std::string &v) { return parseFloat(v, c.fullScale); }},
+  {"dither", nullptr, "TPDF dither before integer conversion",
+   [](Config &c, const std::string &v) { return parseBool(v, c.dither); }},
+  {"timing-bw", "BnT", "Timing loop bandwidth per symbol (rx)",
+   [](Config &c, const std::string &v) { return parseFloat(v, c.timingBw); }},
+  {"carrier-bw", "BnT", "Carrier loop bandwidth per symbol (rx)",
+   [](Config &c, const std::string &v) { return parseFloat(v, c.carrierBw); }},
+  {"demap", "mode", "symbols|hard|soft: what rx writes",
+   [](Config &c, const std::string &v) {
+     if      (v == "symbols") c.rxOutput = RxOutput::Symbols;
+     else if (v == "hard")    c.rxOutput = RxOutput::HardBits;
+     else if (v == "soft")    c.rxOutput = RxOutput::SoftBits;
+     else return false;
+     return true; }},
+  {"fused", nullptr, "Run every stage in one thread",
+   [](Config &c, const std::string &v) {
+     bool fused = !c.threaded;
+     bool ok = parseBool(v, fused);
+     c.threaded = !fused;
+     return ok; }},
+  {"threaded", nullptr, "One thread per stage",
+   [](Config &c, const std::string &v) { return parseBool(v, c.threaded); }},
+  {"pin", nullptr, "Pin stage threads to CPUs",
+   [](Config &c, const std::string &v) { return parseBool(v, c.pinCpus); }},
+  {"monitor", "prefix", "Write prefix.{psd,const,eye,json} for view_monitor.py",
+   [](Config &c, const std::string &v) { c.monitor.prefix = v; return !v.empty(); }},
+  {"monitor-fft", "n", "Monitor PSD bins (power of two, default 1024)",
+   [](Config &c, const std::string &v) { return parseSize(v, c.monitor.fftSize); }},
+  {"monitor-avg", "n", "Welch segments averaged per PSD frame (default 16)",
+   [](Config &c, const std::string &v) { return parseSize(v, c.monitor.average); }},
+  {"monitor-decim", "n", "Keep one constellation point in n (default 16)",
+   [](Config &c, const std::string &v) { return parseSize(v, c.monitor.decimation); }},
+  {"stats", "seconds", "Stage stats to stderr this often (STATS=1 builds)",
+   [](Config &c, const std::string &v) { return parseAmount(v, c.statsInterval); }},
+  {"stats-socket", "path", "Serve stage stats as JSON on this UNIX socket",
+   [](Config &c, const std::string &v) { c.statsSocket = v; return !v.empty(); }},
+  {"verbose", "level", "0: quiet, 1: notes (-v), 2: per symbol (-vv)",
+   [](Config &c, const std::string &v) {
+     size_t n = 0;
+     bool ok = parseSize(v, n);
+     c.verbosity = ok ? (int)n : c.verbosity;
+     return ok; }},
+};
+// clang-format on
+
+const Option *findOption(const std::string &name) {
+  for (const Option &opt : OPTIONS)
+    if (name == opt.name)
+      return &opt;
+  return nullptr;
+}
+
+std::string trim(const std::string &s) {
+  size_t b = s.find_first_not_of(" \t\r\n");
+  if (b == std::string::npos)
+    return "";
+  size_t e = s.find_last_not_of(" \t\r\n");
+  return s.substr(b, e - b + 1);
+}
+
+std::string unquote(const std::string &s) {
+  if (s.size() >= 2 && (s.front() == '"' || s.front() == '\'') &&
+      s.back() == s.front())
+    return s.substr(1, s.size() - 2);
+  return s;
+}
+
+// `key = value` lines; '#' and ';' start comments, [sections] are ignored.
+int loadIni(Config &cfg, const std::string &path, std::istream &in) {
+  std::string line;
+  for (int lineNo = 1; std::getline(in, line); lineNo++) {
+    line = trim(line);
+    if (line.empty() || line[0] == '#' || line[0] == ';' || line[0] == '[')
+      continue;
+    size_t eq = line.find('=');
+    if (eq == std::string::npos) {
+      fprintf(stderr, "[ERROR] %s:%d: expected key = value\n", path.c_str(),
+              lineNo);
+      return 1;
+    }
+    if (cfg.set(trim(line.substr(0, eq)), unquote(trim(line.substr(eq + 1)))))
+      return 1;
+  }
+  return 0;
+}
+
+// One flat object: {"key": "string" | number | true | false, ...}
+int loadJson(Config &cfg, const std::string &path, const std::string &text) {
+  size_t pos = 0;
+  auto fail = [&](const char *what) {
+    fprintf(stderr, "[ERROR] %s: %s at offset %zu\n", path.c_str(), what, pos);
+    return 1;
+  };
+  auto skipSpace = [&] {
+    while (pos < text.size() && isspace((unsigned char)text[pos]))
+      pos++;
+  };
+  auto readString = [&](std::string &out) {
+    out.clear();
+    for (pos++; pos < text.size() && text[pos] != '"'; pos++) {
+      if (text[pos] == '\\' && pos + 1 < text.size())
+        pos++;
+      out += text[pos];
+    }
+    if (pos == text.size())
+      return false;
+    pos++;
+    return true;
+  };
+
+  skipSpace();
+  if (pos == text.size() || text[pos] != '{')
+    return fail("expected '{'");
+  pos++;
+  for (;;) {
+    skipSpace();
+    if (pos < text.size() && text[pos] == '}')
+      return 0;
+    std::string key, value;
+    if (pos == text.size() || text[pos] != '"' || !readString(key))
+      return fail("expected a quoted key");
+    skipSpace();
+    if (pos == text.size() || text[pos] != ':')
+      return fail("expected ':'");
+    pos++;
+    skipSpace();
+    if (pos < text.size() && text[pos] == '"') {
+      if (!readString(value))
+        return fail("unterminated string");
+    } else if (pos < text.size() && (text[pos] == '{' || text[pos] == '[')) {
+      return fail("nested values aren't supported");
+    } else {
+      size_t end = text.find_first_of(",} \t\r\n", pos);
+      value = text.substr(pos, end - pos);
+      pos = (end == std::string::npos) ? text.size() : end;
+    }
+    if (cfg.set(key, value))
+      return 1;
+    skipSpace();
+    if (pos < text.size() && text[pos] == ',')
+      pos++;
+    else if (pos == text.size() || text[pos] != '}')
+      return fail("expected ',' or '}'");
+  }
+}
+
+constexpr size_t MAX_PATH_DELAY = 4096; // Samples
+
+// Rates down to 1 mHz, so num/den stays exact for anything sensible.
+constexpr double RATE_RESOLUTION = 1000.0;
+
+bool toMilliHz(double rate, uint64_t &out) {
+  double scaled = rate * RATE_RESOLUTION;
+  out = (uint64_t)std::llround(scaled);
+  return std::abs(scaled - (double)out) < 1e-6 * std::max(1.0, scaled);
+}
+} // namespace
+
+bool parseAmount(const std::string &text, double &value) {
+  char *end = nullptr;
+  errno = 0;
+  value = strtod(text.c_str(), &end);
+  if (end == text.c_str() || errno != 0 || !(value >= 0))
+    return false;
+  switch (*end) {
+  case 'k':
+    value *= 1e3, end++;
+    break;
+  case 'M':
+    value *= 1e6, end++;
+    break;
+  case 'G':
+    value *= 1e9, end++;
+    break;
+  }
+  return *end == '\0';
+}
+
+int Config::set(const std::string &key, const std::string &value) {
+  const Option *opt = findOption(key);
+  if (!opt) {
+    fprintf(stderr, "[ERROR] Unknown setting '%s'.\n", key.c_str());
+    return 1;
+  }
+  if (!opt->apply(*this, value)) {
+    fprintf(stderr, "[ERROR] Bad value '%s' for %s.\n", value.c_str(),
+            key.c_str());
+    return 1;
+  }
+  return 0;
+}
+
+int Config::load(const std::string &path) {
+  std::ifstream in(path);
+  if (!in) {
+    fprintf(stderr, "[ERROR] Could not open config %s (%s)\n", path.c_str(),
+            strerror(errno));
+    return 1;
+  }
+  const bool json =
+      path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+  if (!json)
+    return loadIni(*this, path, in);
+  std::stringstream text;
+  text << in.rdbuf();
+  return loadJson(*this, path, text.str());
+}
+
+Config::ParseResult Config::parseArg(int argc, char *argv[], int &a) {
+  std::string arg = argv[a];
+  if (arg == "-v" || arg == "-vv") {
+    verbosity += (int)arg.size() - 1;
+    return ParseResult::Ok;
+  }
+  if (arg == "-o")
+    arg = "--output";
+  else if (arg == "-i")
+    arg = "--input";
+  if (arg.compare(0, 2, "--") != 0)
+    return ParseResult::Unknown;
+
+  std::string key = arg.substr(2), value;
+  size_t eq = key.find('=');
+  const bool inlineValue = eq != std::string::npos;
+  if (inlineValue) {
+    value = key.substr(eq + 1);
+    key.resize(eq);
+  }
+
+  const bool isConfig = key == "config";
+  const Option *opt = findOption(key);
+  if (!opt && !isConfig)
+    return ParseResult::Unknown;
+
+  if (!inlineValue) {
+    if (opt && !opt->arg) {
+      value = "true";
+    } else if (a + 1 < argc) {
+      value = argv[++a];
+    } else {
+      fprintf(stderr, "[ERROR] %s needs a value.\n", arg.c_str());
+      return ParseResult::Error;
+    }
+  }
+  int err = isConfig ? load(value) : set(key, value);
+  return err ? ParseResult::Error : ParseResult::Ok;
+}
+
+int Config::finalize() {
+  auto fail = [](const char *what) {
+    fprintf(stderr, "[ERROR] Config: %s\n", what);
+    return 1;
+  };
+
+  bitsPerSymbol = ::bitsPerSymbol(mod);
+  numSymbols = size_t(1) << bitsPerSymbol;
+
+  uint64_t fs, baud;
+  if (!(sampleRate > 0) || !(baudRate > 0))
+    return fail("samp-rate and baud-rate must be positive.");
+  if (!toMilliHz(sampleRate, fs) || !toMilliHz(baudRate, baud))
+    return fail("samp-rate and baud-rate must be whole multiples of 1 mHz.");
+  uint64_t g = std::gcd(fs, baud);
+  sps = {fs / g, baud / g};
+
+  const size_t minSps = shaped ? 2 : 1;
+  if (sps.value() < minSps) {
+    fprintf(stderr,
+            "[ERROR] Config: need at least %zu samples per symbol, "
+            "samp-rate / baud-rate is %.3f.\n",
+            minSps, sps.value());
+    return 1;
+  }
+  if (std::abs(carrierFreq) > sampleRate / 2)
+    return fail("carrier must be within +-samp-rate / 2.");
+  if (shaped) {
+    if (!(rollOff >= 0.0f && rollOff <= 1.0f))
+      return fail("rolloff must be between 0 and 1.");
+    if (spanSymbols < 1)
+      return fail("span must be at least one symbol.");
+    // A fractional sps needs one filter phase per numerator step; past
+    // that, shape at a few samples a symbol and resample.
+    if (oversample == 0 && !sps.integer() &&
+        sps.num * (spanSymbols + 1) > PulseShapingFilter::MAX_PHASE_TAPS)
+      oversample = std::min<size_t>(4, sps.floor());
+    if (oversample > 0 && (oversample < 2 || oversample > sps.value()))
+      return fail("oversample must be from 2 up to samp-rate / baud-rate.");
+    resamplerPassband = (1.0 + rollOff) / (2.0 * oversample);
+    // rx's decimator is the longer one.
+    if (oversample > 0 && Resampler::tapsFor(oversample, sps.ceil(),
+                                             resamplerPassband) >
+                              Resampler::MAX_TAPS)
+      return fail("oversample is too low for this samp-rate / baud-rate.");
+  }
+  if (rsDepth > 0) {
+    if (frameBytes == 0)
+      frameBytes = rs::N * rsDepth;
+    if (frameBytes != rs::N * rsDepth)
+      return fail("with rs, frame must be 255 x the interleave depth.");
+  }
+  if (packet.active()) {
+    if (packet.maxPayload > packet::MAX_PAYLOAD)
+      return fail("packet payloads are limited to 65535 bytes.");
+    if (frameBytes == 0)
+      frameBytes = packet::DEFAULT_FRAME_BYTES;
+  }
+  if (std::abs(channel.clockPpm) >= 1e5)
+    return fail("clock-ppm must be within +-100000.");
+  if (std::abs(channel.freqOffset) > sampleRate / 2)
+    return fail("cfo must be within +-samp-rate / 2.");
+  for (const ChannelPath &p : channel.paths)
+    if (p.delay > MAX_PATH_DELAY)
+      return fail("multipath delays are limited to 4096 samples.");
+  if (ofdm.active()) {
+    std::vector<Subcarrier> map;
+    if (!FftPlan::validSize(ofdm.fftSize) || ofdm.fftSize < 4)
+      return fail("ofdm must be a power of two from 4 up.");
+    if (!makeCarrierMap(ofdm, map))
+      return fail("carrier-map must have one of d, p or - per bin and some "
+                  "d; guard must leave some carriers.");
+    if (ofdm.cyclicPrefix != OfdmSettings::AUTO &&
+        ofdm.cyclicPrefix > ofdm.fftSize)
+      return fail("cp can't be longer than the FFT.");
+  }
+  if (monitor.active() &&
+      (!FftPlan::validSize(monitor.fftSize) || monitor.fftSize < 16))
+    return fail("monitor-fft must be a power of two from 16 up.");
+  if (monitor.average == 0 || monitor.decimation == 0)
+    return fail("monitor-avg and monitor-decim must be at least 1.");
+  if (!(fullScale > 0.0f))
+    return fail("full-scale must be positive.");
+  if (!(timingBw > 0.0f && timingBw < 0.5f) ||
+      !(carrierBw > 0.0f && carrierBw < 0.5f))
+    return fail("timing-bw and carrier-bw must be between 0 and 0.5.");
+
+  if (!stats::ENABLED && (statsInterval > 0.0 || !statsSocket.empty()))
+    fprintf(stderr, "[WARNING] Built without QPSK_STATS (make STATS=1), "
+                    "--stats and --stats-socket do nothing.\n");
+
+  const double occupied = baudRate * (1.0 + (shaped ? rollOff : 1.0)) / 2.0;
+  if (!ofdm.active() && std::abs(carrierFreq) + occupied > sampleRate / 2)
+    fprintf(stderr, "[WARNING] The signal (%g Hz either side of %g Hz) "
+                    "doesn't fit below Nyquist and will alias.\n",
+            occupied, carrierFreq);
+
+  const double cyclesPerSym = carrierFreq / baudRate;
+  carrierInTable = sps.integer() &&
+                   std::abs(cyclesPerSym - std::round(cyclesPerSym)) < 1e-6;
+
+  if (threaded && std::thread::hardware_concurrency() <= 1)
+    threaded = false;
+  return 0;
+}
+
+void Config::print(FILE *f) const {
+  fprintf(f, "[NOTE] %s at %g Bd, %g S/s: %llu/%llu = %.4f samples/symbol\n",
+          modulationName(mod), baudRate, sampleRate,
+          (unsigned long long)sps.num, (unsigned long long)sps.den,
+          sps.value());
+  fprintf(f, "[NOTE] %s pulses, carrier %g Hz (%s)\n",
+          shaped ? "RRC" : "Rectangular", carrierFreq,
+          (carrierInTable && !shaped) ? "in the symbol table" : "NCO");
+  if (shaped)
+    fprintf(f, "[NOTE] Roll-off %.3g over %zu symbols\n", rollOff,
+            spanSymbols);
+  if (shaped && oversample > 0 && !ofdm.active())
+    fprintf(f, "[NOTE] RRC at %zu samples/symbol, Farrow resampled by "
+               "%.6g\n",
+            oversample, sps.value() / oversample);
+  if (convolutional)
+    fprintf(f, "[NOTE] r=1/2 K=7 convolutional code (G2 %sinverted)\n",
+            invertG2 ? "" : "not ");
+  if (frameBytes > 0)
+    fprintf(f, "[NOTE] Frames: ASM + %zu bytes%s, RS depth %u, %zu symbol "
+               "preamble\n",
+            frameBytes, randomize ? " PN randomized" : "", rsDepth,
+            preambleSymbols);
+  if (packet.active())
+    fprintf(f, "[NOTE] Packets: up to %zu payload bytes, CRC-%u\n",
+            packet.maxPayload, packet.crcBits);
+  if (ofdm.active()) {
+    std::vector<Subcarrier> map;
+    makeCarrierMap(ofdm, map);
+    fprintf(f, "[NOTE] OFDM: %zu bins of %g Hz, %zu sample prefix, %zu data "
+               "and %zu pilot carriers\n",
+            ofdm.fftSize, sampleRate / ofdm.fftSize,
+            ofdm.cyclicPrefix == OfdmSettings::AUTO ? ofdm.fftSize / 4
+                                                    : ofdm.cyclicPrefix,
+            (size_t)std::count(map.begin(), map.end(), Subcarrier::Data),
+            (size_t)std::count(map.begin(), map.end(), Subcarrier::Pilot));
+  }
+  if (channel.active())
+    fprintf(f, "[NOTE] Channel: Es/N0 %g dB, %g Hz, %g deg, %g ppm, %zu "
+               "paths, seed %llu\n",
+            channel.esN0, channel.freqOffset, channel.phaseOffset,
+            channel.clockPpm, std::max<size_t>(1, channel.paths.size()),
+            (unsigned long long)channel.seed);
+  if (monitor.active())
+    fprintf(f, "[NOTE] Monitor: %s.*, %zu bin PSD over %zu segments, 1 in "
+               "%zu points\n",
+            monitor.prefix.c_str(), monitor.fftSize, monitor.average,
+            monitor.decimation);
+}
+
+void Config::usage(FILE *f) {
+  fprintf(f, "  --config file.{ini,json}   Settings file, same keys as below\n"
+             "  -v, -vv                    More chatter\n");
+  for (const Option &opt : OPTIONS) {
+    std::string flag = std::string("--") + opt.name;
+    if (opt.arg)
+      flag += std::string(" ") + opt.arg;
+    fprintf(f, "  %-26s %s\n", flag.c_str(), opt.help);
+  }
+}
@@ -0,0 +1,221 @@
+/*
+ * convolutional_code.cpp - CCSDS r=1/2 K=7 convolutional encoder and Viterbi.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "convolutional_code.h"
+
+#include <algorithm>
+#include <bit>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+using namespace conv;
+
+namespace {
+constexpr unsigned HALF = NUM_STATES / 2;
+
+unsigned parity(unsigned v) { return (unsigned)std::popcount(v) & 1; }
+
+int16_t saturate(int v) {
+  return (int16_t)std::clamp(v, -32768, 32767);
+}
+} // namespace
+
+// *** === Encoder === ***
+ConvEncoder::ConvEncoder(bool invertG2) {
+  for (unsigned w = 0; w < 2 * NUM_STATES; w++)
+    outputs[w] = (uint8_t)((parity(w & POLY_A) << 1) |
+                           (parity(w & POLY_B) ^ (invertG2 ? 1 : 0)));
+}
+
+size_t ConvEncoder::encode(const uint8_t *bits, size_t numBits,
+                           uint8_t *out) {
+  unsigned s = state;
+  for (size_t i = 0; i < numBits; i++) {
+    const unsigned w = (s << 1) | (bits[i] & 1);
+    out[2 * i] = outputs[w] >> 1;
+    out[2 * i + 1] = outputs[w] & 1;
+    s = w & (NUM_STATES - 1);
+  }
+  state = s;
+  return 2 * numBits;
+}
+
+size_t ConvEncoder::flush(uint8_t *out) {
+  const uint8_t zeros[K - 1] = {};
+  return encode(zeros, K - 1, out);
+}
+
+// *** === Decoder === ***
+ViterbiDecoder::ViterbiDecoder(size_t tracebackDepth, bool invertG2,
+                               ViterbiKernel kernel)
+    : depth(std::max<size_t>(tracebackDepth, 1)) {
+#if defined(__AVX2__)
+  scalar = (kernel == ViterbiKernel::Scalar);
+#else
+  scalar = true;
+#endif
+  // Butterfly i: states i and i + 32 into 2i and 2i + 1. Window 2i (from
+  // state i, input 0) produces the pair below; the other three branches
+  // flip both bits, i.e. negate the metric.
+  for (unsigned i = 0; i < HALF; i++) {
+    unsigned w = 2 * i;
+    signA[i] = parity(w & POLY_A) ? -1 : 1;
+    signB[i] = (parity(w & POLY_B) ^ (invertG2 ? 1 : 0)) ? -1 : 1;
+  }
+  reset();
+}
+
+void ViterbiDecoder::reset() {
+  std::fill(metrics, metrics + NUM_STATES, 0); // Could be anywhere
+  decisions.clear();
+  sinceRenorm = 0;
+  holding = false;
+}
+
+void ViterbiDecoder::stepsScalar(const int8_t *llrs, size_t numSteps,
+                                 uint64_t *dec) {
+  for (size_t t = 0; t < numSteps; t++) {
+    const int l0 = llrs[2 * t], l1 = llrs[2 * t + 1];
+    int16_t next[NUM_STATES];
+    uint64_t d = 0;
+    for (unsigned i = 0; i < HALF; i++) {
+      const int g = signA[i] * l0 + signB[i] * l1;
+      const int16_t a = metrics[i], b = metrics[i + HALF];
+      const int16_t p0 = saturate(a + g), q0 = saturate(b - g);
+      const int16_t p1 = saturate(a - g), q1 = saturate(b + g);
+      next[2 * i] = std::max(p0, q0);
+      next[2 * i + 1] = std::max(p1, q1);
+      d |= (uint64_t)(q0 > p0) << (2 * i);
+      d |= (uint64_t)(q1 > p1) << (2 * i + 1);
+    }
+    std::copy(next, next + NUM_STATES, metrics);
+    dec[t] = d;
+
+    if (++sinceRenorm == RENORM_STEPS) {
+      const int16_t base = metrics[0];
+      for (int16_t &m : metrics)
+        m = saturate(m - base);
+      sinceRenorm = 0;
+    }
+  }
+}
+
+void ViterbiDecoder::steps(const int8_t *llrs, size_t numSteps) {
+  const size_t first = decisions.size();
+  decisions.resize(first + numSteps);
+  uint64_t *dec = decisions.data() + first;
+#if defined(__AVX2__)
+  if (scalar)
+    return stepsScalar(llrs, numSteps, dec);
+
+  // The metrics live in registers for the whole batch; going through
+  // memory every step costs more than the ACS itself.
+  __m256i m[4], sa[2], sb[2];
+  for (unsigned r = 0; r < 4; r++)
+    m[r] = _mm256_load_si256(reinterpret_cast<const __m256i *>(metrics) + r);
+  for (unsigned h = 0; h < 2; h++) {
+    sa[h] = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(signA + 16 * h));
+    sb[h] = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(signB + 16 * h));
+  }
+
+  for (size_t t = 0; t < numSteps; t++) {
+    const __m256i L0 = _mm256_set1_epi16(llrs[2 * t]);
+    const __m256i L1 = _mm256_set1_epi16(llrs[2 * t + 1]);
+    __m256i next[4];
+    uint64_t d = 0;
+    for (unsigned h = 0; h < 2; h++) { // Butterflies 16h .. 16h + 15
+      const __m256i g = _mm256_adds_epi16(_mm256_sign_epi16(L0, sa[h]),
+                                          _mm256_sign_epi16(L1, sb[h]));
+      const __m256i a = m[h], b = m[2 + h];
+      const __m256i p0 = _mm256_adds_epi16(a, g), q0 = _mm256_subs_epi16(b, g);
+      const __m256i p1 = _mm256_subs_epi16(a, g), q1 = _mm256_adds_epi16(b, g);
+      const __m256i n0 = _mm256_max_epi16(p0, q0);
+      const __m256i n1 = _mm256_max_epi16(p1, q1);
+      const __m256i d0 = _mm256_cmpgt_epi16(q0, p0);
+      const __m256i d1 = _mm256_cmpgt_epi16(q1, p1);
+
+      // Interleave to state order 2i, 2i + 1. unpack works per 128 bit
+      // lane, so lo = {0..7 | 16..23} and hi = {8..15 | 24..31}.
+      const __m256i lo = _mm256_unpacklo_epi16(n0, n1);
+      const __m256i hi = _mm256_unpackhi_epi16(n0, n1);
+      next[2 * h] = _mm256_permute2x128_si256(lo, hi, 0x20);
+      next[2 * h + 1] = _mm256_permute2x128_si256(lo, hi, 0x31);
+
+      // packs (per lane again) gives {dlo.0, dhi.0, dlo.1, dhi.1}: states
+      // 0..31 in order, one byte each.
+      const __m256i dm = _mm256_packs_epi16(_mm256_unpacklo_epi16(d0, d1),
+                                            _mm256_unpackhi_epi16(d0, d1));
+      d |= (uint64_t)(uint32_t)_mm256_movemask_epi8(dm) << (32 * h);
+    }
+    for (unsigned r = 0; r < 4; r++)
+      m[r] = next[r];
+    dec[t] = d;
+
+    if (++sinceRenorm == RENORM_STEPS) {
+      const __m256i base =
+          _mm256_broadcastw_epi16(_mm256_castsi256_si128(m[0]));
+      for (unsigned r = 0; r < 4; r++)
+        m[r] = _mm256_subs_epi16(m[r], base);
+      sinceRenorm = 0;
+    }
+  }
+  for (unsigned r = 0; r < 4; r++)
+    _mm256_store_si256(reinterpret_cast<__m256i *>(metrics) + r, m[r]);
+#else
+  stepsScalar(llrs, numSteps, dec);
+#endif
+}
+
+unsigned ViterbiDecoder::bestState() const {
+  return (unsigned)(std::max_element(metrics, metrics + NUM_STATES) -
+                    metrics);
+}
+
+// Walk the whole decision history back from `state` and write the oldest
+// numOut bits, then forget them.
+size_t ViterbiDecoder::traceback(unsigned state, size_t numOut, uint8_t *out) {
+  for (size_t t = decisions.size(); t-- > 0;) {
+    if (t < numOut)
+      out[t] = state & 1;
+    const unsigned d = (decisions[t] >> state) & 1;
+    state = (state >> 1) | (d << (K - 2));
+  }
+  decisions.erase(decisions.begin(), decisions.begin() + numOut);
+  return numOut;
+}
+
+size_t ViterbiDecoder::decode(const int8_t *llrs, size_t numLlrs,
+                              uint8_t *out) {
+  size_t i = 0;
+  if (holding && numLlrs > 0) {
+    const int8_t pair[2] = {heldLlr, llrs[0]};
+    steps(pair, 1);
+    holding = false;
+    i = 1;
+  }
+  const size_t numSteps = (numLlrs - i) / 2;
+  steps(llrs + i, numSteps);
+  i += 2 * numSteps;
+  if (i < numLlrs) {
+    heldLlr = llrs[i];
+    holding = true;
+  }
+
+  if (decisions.size() <= depth)
+    return 0;
+  return traceback(bestState(), decisions.size() - depth, out);
+}
+
+size_t ViterbiDecoder::flush(uint8_t *out, bool terminated) {
+  size_t n = traceback(terminated ? 0 : bestState(), decisions.size(), out);
+  reset();
+  return n;
+}
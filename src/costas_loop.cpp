@@ -0,0 +1,67 @@
+/*
+ * costas_loop.cpp - Decision directed carrier phase/frequency recovery.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "costas_loop.h"
+
+#include <cmath>
+#include <limits>
+
+namespace {
+constexpr double TWO_PI = 2.0 * constellation::PI;
+
+float sign(float v) { return (v < 0.0f) ? -1.0f : 1.0f; }
+} // namespace
+
+CostasLoop::CostasLoop(Modulation mod, float loopBandwidth, float damping)
+    : mod(mod), points(constellationPoints(mod)),
+      gains(LoopGains::design(loopBandwidth, damping)) {}
+
+void CostasLoop::reset() {
+  phaseAcc = freqAcc = 0.0;
+  lastError = 0.0f;
+}
+
+float CostasLoop::detect(std::complex<float> y) const {
+  switch (mod) {
+  case Modulation::BPSK:
+    return sign(y.real()) * y.imag();
+  case Modulation::QPSK: // Points at 45 degrees, |d| = 1
+    return (sign(y.real()) * y.imag() - sign(y.imag()) * y.real()) *
+           (float)(1.0 / std::sqrt(2.0));
+  default: {
+    std::complex<float> d = points[0];
+    float best = std::numeric_limits<float>::max();
+    for (std::complex<float> p : points) {
+      float dist = std::norm(y - p);
+      if (dist < best) {
+        best = dist;
+        d = p;
+      }
+    }
+    // Im{y conj(d)} is |d|^2 per radian; outer points pull harder, so
+    // divide that back out.
+    return (y.imag() * d.real() - y.real() * d.imag()) / std::norm(d);
+  }
+  }
+}
+
+void CostasLoop::process(const std::complex<float> *in, size_t numSymbols,
+                         std::complex<float> *out) {
+  for (size_t k = 0; k < numSymbols; k++) {
+    const std::complex<float> rot((float)std::cos(phaseAcc),
+                                  (float)-std::sin(phaseAcc));
+    const std::complex<float> y = in[k] * rot;
+    const float e = detect(y);
+    lastError = e;
+    out[k] = y;
+
+    freqAcc += gains.ki * e;
+    phaseAcc += freqAcc + gains.kp * e;
+    if (phaseAcc >= TWO_PI || phaseAcc < 0.0)
+      phaseAcc -= TWO_PI * std::floor(phaseAcc / TWO_PI);
+  }
+}
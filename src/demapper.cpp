@@ -0,0 +1,330 @@
+/*
+ * demapper.cpp - Symbols back to hard bits or int8 max-log LLRs.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "demapper.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+constexpr size_t BATCH = 8;         // Symbols per kernel step
+constexpr size_t CHUNK = 32 * BATCH; // Symbols per staging buffer
+constexpr size_t MAX_BITS = 8;
+
+// out[i] = clamp(round(llr[i]), -127, 127)
+void quantize(const float *llr, size_t n, int8_t *out) {
+  size_t i = 0;
+#if defined(__AVX2__)
+  const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+  const __m256 lo = _mm256_set1_ps(-127.0f), hi = _mm256_set1_ps(127.0f);
+  auto load = [&](size_t j) {
+    __m256 v = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(llr + j), lo), hi);
+    return _mm256_cvtps_epi32(v); // Round to nearest even
+  };
+  for (; i + 32 <= n; i += 32) {
+    __m256i a = load(i), b = load(i + 8), c = load(i + 16), d = load(i + 24);
+    // The packs work per 128 bit lane; the permute undoes that.
+    __m256i q = _mm256_packs_epi16(_mm256_packs_epi32(a, b),
+                                   _mm256_packs_epi32(c, d));
+    q = _mm256_permutevar8x32_epi32(q, order);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), q);
+  }
+#elif defined(__ARM_NEON)
+  auto load = [&](size_t j) {
+    float32x4_t v = vminq_f32(vmaxq_f32(vld1q_f32(llr + j), vdupq_n_f32(-127)),
+                              vdupq_n_f32(127));
+    return vqmovn_s32(vcvtnq_s32_f32(v));
+  };
+  for (; i + 16 <= n; i += 16) {
+    int16x8_t lo = vcombine_s16(load(i), load(i + 4));
+    int16x8_t hi = vcombine_s16(load(i + 8), load(i + 12));
+    vst1q_s8(out + i, vcombine_s8(vqmovn_s16(lo), vqmovn_s16(hi)));
+  }
+#endif
+  for (; i < n; i++)
+    out[i] = (int8_t)std::clamp(std::nearbyint(llr[i]), -127.0f, 127.0f);
+}
+
+void signs(const float *llr, size_t n, uint8_t *out) {
+  for (size_t i = 0; i < n; i++)
+    out[i] = llr[i] < 0.0f;
+}
+
+#if defined(__AVX2__)
+// Eight interleaved symbols -> r0..r7, i0..i7
+void loadSoA(const std::complex<float> *y, __m256 &re, __m256 &im) {
+  const float *f = reinterpret_cast<const float *>(y);
+  __m256 a = _mm256_loadu_ps(f), b = _mm256_loadu_ps(f + 8);
+  re = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+  im = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+  re = _mm256_castpd_ps(
+      _mm256_permute4x64_pd(_mm256_castps_pd(re), _MM_SHUFFLE(3, 1, 2, 0)));
+  im = _mm256_castpd_ps(
+      _mm256_permute4x64_pd(_mm256_castps_pd(im), _MM_SHUFFLE(3, 1, 2, 0)));
+}
+
+// scale * (min1 - min0) for bits [first, first + count) of eight symbols,
+// back into symbol major order.
+void storeLlrs(const __m256 *min0, const __m256 *min1, size_t count,
+               size_t first, size_t bitsPerSym, float scale, float *llr) {
+  float rows[MAX_BITS][BATCH];
+  const __m256 s = _mm256_set1_ps(scale);
+  for (size_t j = 0; j < count; j++)
+    _mm256_storeu_ps(rows[j],
+                     _mm256_mul_ps(_mm256_sub_ps(min1[j], min0[j]), s));
+  for (size_t t = 0; t < BATCH; t++)
+    for (size_t j = 0; j < count; j++)
+      llr[t * bitsPerSym + first + j] = rows[j][t];
+}
+#endif
+
+template <typename Map> struct SquareQam : std::false_type {};
+template <size_t Bits>
+struct SquareQam<Mapper<QAM, Bits>> : std::true_type {};
+
+// Square QAM separates: the I bits only depend on I, since the Q term of
+// the distance is the same on both sides of the difference and cancels.
+// So each axis is a search over sqrt(M) levels instead of M points.
+template <typename Map>
+void axisLlrs(const std::complex<float> *y, size_t n, float scale,
+              float *llr) {
+  constexpr size_t M = Map::BITS_PER_SYMBOL, HALF = M / 2;
+  constexpr size_t L = size_t(1) << HALF;
+  constexpr auto &table = Map::table;
+  size_t k = 0;
+#if defined(__AVX2__)
+  const __m256 inf = _mm256_set1_ps(std::numeric_limits<float>::max());
+  for (; k + BATCH <= n; k += BATCH) {
+    __m256 axis[2];
+    loadSoA(y + k, axis[0], axis[1]);
+    for (size_t a = 0; a < 2; a++) {
+      __m256 min0[HALF], min1[HALF];
+      for (size_t j = 0; j < HALF; j++)
+        min0[j] = min1[j] = inf;
+      for (size_t v = 0; v < L; v++) {
+        const float level =
+            (a == 0) ? table[v << HALF].real() : table[v].imag();
+        __m256 e = _mm256_sub_ps(axis[a], _mm256_set1_ps(level));
+        __m256 d = _mm256_mul_ps(e, e);
+        for (size_t j = 0; j < HALF; j++) {
+          if ((v >> (HALF - 1 - j)) & 1)
+            min1[j] = _mm256_min_ps(min1[j], d);
+          else
+            min0[j] = _mm256_min_ps(min0[j], d);
+        }
+      }
+      storeLlrs(min0, min1, HALF, a * HALF, M, scale, llr + k * M);
+    }
+  }
+#endif
+  for (; k < n; k++) {
+    const float axis[2] = {y[k].real(), y[k].imag()};
+    for (size_t a = 0; a < 2; a++) {
+      float min0[HALF], min1[HALF];
+      std::fill(min0, min0 + HALF, std::numeric_limits<float>::max());
+      std::fill(min1, min1 + HALF, std::numeric_limits<float>::max());
+      for (size_t v = 0; v < L; v++) {
+        // I levels sit in the top label bits, Q levels in the bottom ones.
+        const float level =
+            (a == 0) ? table[v << HALF].real() : table[v].imag();
+        const float d = (axis[a] - level) * (axis[a] - level);
+        for (size_t j = 0; j < HALF; j++) {
+          float &m = ((v >> (HALF - 1 - j)) & 1) ? min1[j] : min0[j];
+          m = std::min(m, d);
+        }
+      }
+      for (size_t j = 0; j < HALF; j++)
+        llr[k * M + a * HALF + j] = (min1[j] - min0[j]) * scale;
+    }
+  }
+}
+
+// Scaled max-log LLRs for up to CHUNK symbols, symbol major.
+template <typename Map>
+void searchLlrs(const std::complex<float> *y, size_t n, float scale,
+                float *llr) {
+  constexpr size_t M = Map::BITS_PER_SYMBOL;
+  constexpr size_t N = Map::NUM_POINTS;
+  constexpr auto &table = Map::table;
+  size_t k = 0;
+#if defined(__AVX2__)
+  for (; k + BATCH <= n; k += BATCH) {
+    __m256 re, im;
+    loadSoA(y + k, re, im);
+    const __m256 inf = _mm256_set1_ps(std::numeric_limits<float>::max());
+    __m256 min0[M], min1[M];
+    for (size_t j = 0; j < M; j++)
+      min0[j] = min1[j] = inf;
+    for (size_t p = 0; p < N; p++) {
+      __m256 dr = _mm256_sub_ps(re, _mm256_set1_ps(table[p].real()));
+      __m256 di = _mm256_sub_ps(im, _mm256_set1_ps(table[p].imag()));
+      __m256 d = _mm256_add_ps(_mm256_mul_ps(dr, dr), _mm256_mul_ps(di, di));
+      for (size_t j = 0; j < M; j++) {
+        if ((p >> (M - 1 - j)) & 1)
+          min1[j] = _mm256_min_ps(min1[j], d);
+        else
+          min0[j] = _mm256_min_ps(min0[j], d);
+      }
+    }
+    storeLlrs(min0, min1, M, 0, M, scale, llr + k * M);
+  }
+#endif
+  for (; k < n; k++) {
+    float min0[M], min1[M];
+    std::fill(min0, min0 + M, std::numeric_limits<float>::max());
+    std::fill(min1, min1 + M, std::numeric_limits<float>::max());
+    for (size_t p = 0; p < N; p++) {
+      float d = std::norm(y[k] - table[p]);
+      for (size_t j = 0; j < M; j++) {
+        float &m = ((p >> (M - 1 - j)) & 1) ? min1[j] : min0[j];
+        m = std::min(m, d);
+      }
+    }
+    for (size_t j = 0; j < M; j++)
+      llr[k * M + j] = (min1[j] - min0[j]) * scale;
+  }
+}
+
+// BPSK and QPSK: the distance differences are linear. For QPSK's points at
+// (+-1 +-j)/sqrt(2) the label MSB is the sign of Q and the LSB that of I,
+// and min1 - min0 = 2 sqrt(2) Q (resp. I). BPSK: 4 I.
+void linearLlrs(Modulation mod, const std::complex<float> *y, size_t n,
+                float scale, float *llr) {
+  if (mod == Modulation::BPSK) {
+    const float c = 4.0f * scale;
+    for (size_t k = 0; k < n; k++)
+      llr[k] = c * y[k].real();
+    return;
+  }
+  const float c = 2.0f * std::sqrt(2.0f) * scale;
+  for (size_t k = 0; k < n; k++) {
+    llr[2 * k] = c * y[k].imag();
+    llr[2 * k + 1] = c * y[k].real();
+  }
+}
+
+void llrChunk(Modulation mod, const std::complex<float> *y, size_t n,
+              float scale, float *llr) {
+  if (mod == Modulation::BPSK || mod == Modulation::QPSK) {
+    linearLlrs(mod, y, n, scale, llr);
+    return;
+  }
+  withMapper(mod, [&](auto mapper) {
+    using Map = decltype(mapper);
+    if constexpr (SquareQam<Map>::value)
+      axisLlrs<Map>(y, n, scale, llr);
+    else
+      searchLlrs<Map>(y, n, scale, llr);
+  });
+}
+} // namespace
+
+Demapper::Demapper(Modulation mod, float noiseVariance)
+    : mod(mod), bits(::bitsPerSymbol(mod)), points(constellationPoints(mod)),
+      noiseVar(noiseVariance) {}
+
+size_t Demapper::soft(const std::complex<float> *symbols, size_t numSymbols,
+                      int8_t *llrs) const {
+  const float scale = 1.0f / (std::max(noiseVar, 1e-6f) * LLR_STEP);
+  float staging[CHUNK * MAX_BITS];
+  for (size_t k = 0; k < numSymbols; k += CHUNK) {
+    const size_t n = std::min(CHUNK, numSymbols - k);
+    llrChunk(mod, symbols + k, n, scale, staging);
+    quantize(staging, n * bits, llrs + k * bits);
+  }
+  return numSymbols * bits;
+}
+
+size_t Demapper::hard(const std::complex<float> *symbols, size_t numSymbols,
+                      uint8_t *out) const {
+  float staging[CHUNK * MAX_BITS];
+  for (size_t k = 0; k < numSymbols; k += CHUNK) {
+    const size_t n = std::min(CHUNK, numSymbols - k);
+    llrChunk(mod, symbols + k, n, 1.0f, staging);
+    signs(staging, n * bits, out + k * bits);
+  }
+  return numSymbols * bits;
+}
+
+void Demapper::estimateNoise(const std::complex<float> *symbols,
+                             size_t numSymbols) {
+  const size_t skip = std::min(numSymbols, NOISE_SKIP - noiseSkipped);
+  noiseSkipped += skip;
+  symbols += skip;
+  numSymbols -= skip;
+  if (numSymbols == 0)
+    return;
+  double sum = 0.0;
+  for (size_t k = 0; k < numSymbols; k++) {
+    float best = std::numeric_limits<float>::max();
+    for (std::complex<float> p : points)
+      best = std::min(best, std::norm(symbols[k] - p));
+    sum += best;
+  }
+  if (noiseCount < NOISE_SETTLE) {
+    noiseSum += sum;
+    noiseCount += numSymbols;
+    if (noiseCount >= NOISE_SETTLE)
+      noiseVar = (float)(noiseSum / (double)noiseCount);
+    return;
+  }
+  // About 64k symbols of memory, however the batches are cut.
+  const float mse = (float)(sum / numSymbols);
+  const float alpha = 1.0f - std::exp(-(float)numSymbols / 65536.0f);
+  noiseVar += alpha * (mse - noiseVar);
+}
+
+size_t OqpskRealigner::process(const std::complex<float> *in,
+                               size_t numSamples, std::complex<float> *out) {
+  size_t numSyms = 0;
+  for (size_t i = 0; i < numSamples; i++) {
+    if (skipNext) {
+      skipNext = false;
+      continue;
+    }
+    if (!havePending) {
+      pendingI = in[i].real();
+      havePending = true;
+    } else {
+      out[numSyms++] = {pendingI, in[i].imag()};
+      havePending = false;
+    }
+  }
+  return numSyms;
+}
+
+size_t BitPacker::pack(const uint8_t *bits, size_t numBits, uint8_t *out) {
+  size_t numBytes = 0, i = 0;
+  // Finish the carried byte, then go eight bits at a time.
+  for (; count != 0 && i < numBits; i++) {
+    acc = (uint8_t)((acc << 1) | (bits[i] & 1));
+    if (++count == 8) {
+      out[numBytes++] = acc;
+      acc = 0;
+      count = 0;
+    }
+  }
+  for (; i + 8 <= numBits; i += 8) {
+    uint8_t b = 0;
+    for (size_t j = 0; j < 8; j++)
+      b = (uint8_t)((b << 1) | (bits[i + j] & 1));
+    out[numBytes++] = b;
+  }
+  for (; i < numBits; i++) {
+    acc = (uint8_t)((acc << 1) | (bits[i] & 1));
+    count++;
+  }
+  return numBytes;
+}
@@ -0,0 +1,210 @@
+/*
+ * fft.cpp - Split radix FFT with cached plans and batched transforms.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "fft.h"
+
+#include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+constexpr double PI = 3.141592653589793;
+using cf = std::complex<float>;
+
+// -i x going forward, +i x going back.
+template <bool Inverse> inline cf rotate(cf x) {
+  return Inverse ? cf(-x.imag(), x.real()) : cf(x.imag(), -x.real());
+}
+
+#if defined(__AVX2__)
+// Four complex products, interleaved re/im.
+inline __m256 cmul(__m256 a, __m256 w) {
+  const __m256 wr = _mm256_moveldup_ps(w), wi = _mm256_movehdup_ps(w);
+  const __m256 aSwap = _mm256_permute_ps(a, 0xB1);
+#if defined(__FMA__)
+  return _mm256_fmaddsub_ps(a, wr, _mm256_mul_ps(aSwap, wi));
+#else
+  return _mm256_addsub_ps(_mm256_mul_ps(a, wr), _mm256_mul_ps(aSwap, wi));
+#endif
+}
+
+template <bool Inverse> inline __m256 rotate(__m256 x) {
+  const __m256 sign = Inverse ? _mm256_setr_ps(-0.f, 0.f, -0.f, 0.f, -0.f,
+                                               0.f, -0.f, 0.f)
+                              : _mm256_setr_ps(0.f, -0.f, 0.f, -0.f, 0.f,
+                                               -0.f, 0.f, -0.f);
+  return _mm256_xor_ps(_mm256_permute_ps(x, 0xB1), sign);
+}
+#endif
+
+// Puts U (out[0, m/2)), Z (out[m/2, 3m/4)) and Z' (out[3m/4, m)) together:
+// X[k] = U[k] + (w^k Z[k] + w^3k Z'[k]), and so on round the circle.
+template <bool Inverse>
+void combine(cf *out, size_t q, const cf *w1, const cf *w3) {
+  size_t k = 0;
+#if defined(__AVX2__)
+  float *f = reinterpret_cast<float *>(out);
+  const float *t1 = reinterpret_cast<const float *>(w1);
+  const float *t3 = reinterpret_cast<const float *>(w3);
+  for (; k + 4 <= q; k += 4) {
+    const __m256 a = cmul(_mm256_loadu_ps(f + 2 * (k + 2 * q)),
+                          _mm256_loadu_ps(t1 + 2 * k));
+    const __m256 b = cmul(_mm256_loadu_ps(f + 2 * (k + 3 * q)),
+                          _mm256_loadu_ps(t3 + 2 * k));
+    const __m256 s = _mm256_add_ps(a, b);
+    const __m256 d = rotate<Inverse>(_mm256_sub_ps(a, b));
+    const __m256 u0 = _mm256_loadu_ps(f + 2 * k);
+    const __m256 u1 = _mm256_loadu_ps(f + 2 * (k + q));
+    _mm256_storeu_ps(f + 2 * k, _mm256_add_ps(u0, s));
+    _mm256_storeu_ps(f + 2 * (k + 2 * q), _mm256_sub_ps(u0, s));
+    _mm256_storeu_ps(f + 2 * (k + q), _mm256_add_ps(u1, d));
+    _mm256_storeu_ps(f + 2 * (k + 3 * q), _mm256_sub_ps(u1, d));
+  }
+#elif defined(__ARM_NEON)
+  float *f = reinterpret_cast<float *>(out);
+  const float *t1 = reinterpret_cast<const float *>(w1);
+  const float *t3 = reinterpret_cast<const float *>(w3);
+  for (; k + 4 <= q; k += 4) {
+    const float32x4x2_t z = vld2q_f32(f + 2 * (k + 2 * q));
+    const float32x4x2_t z3 = vld2q_f32(f + 2 * (k + 3 * q));
+    const float32x4x2_t c1 = vld2q_f32(t1 + 2 * k);
+    const float32x4x2_t c3 = vld2q_f32(t3 + 2 * k);
+    const float32x4_t ar =
+        vmlsq_f32(vmulq_f32(z.val[0], c1.val[0]), z.val[1], c1.val[1]);
+    const float32x4_t ai =
+        vmlaq_f32(vmulq_f32(z.val[0], c1.val[1]), z.val[1], c1.val[0]);
+    const float32x4_t br =
+        vmlsq_f32(vmulq_f32(z3.val[0], c3.val[0]), z3.val[1], c3.val[1]);
+    const float32x4_t bi =
+        vmlaq_f32(vmulq_f32(z3.val[0], c3.val[1]), z3.val[1], c3.val[0]);
+    const float32x4_t sr = vaddq_f32(ar, br), si = vaddq_f32(ai, bi);
+    // d = -i (a - b) forward, +i (a - b) back
+    const float32x4_t dr = Inverse ? vsubq_f32(bi, ai) : vsubq_f32(ai, bi);
+    const float32x4_t di = Inverse ? vsubq_f32(ar, br) : vsubq_f32(br, ar);
+    const float32x4x2_t u0 = vld2q_f32(f + 2 * k);
+    const float32x4x2_t u1 = vld2q_f32(f + 2 * (k + q));
+    float32x4x2_t r;
+    r.val[0] = vaddq_f32(u0.val[0], sr), r.val[1] = vaddq_f32(u0.val[1], si);
+    vst2q_f32(f + 2 * k, r);
+    r.val[0] = vsubq_f32(u0.val[0], sr), r.val[1] = vsubq_f32(u0.val[1], si);
+    vst2q_f32(f + 2 * (k + 2 * q), r);
+    r.val[0] = vaddq_f32(u1.val[0], dr), r.val[1] = vaddq_f32(u1.val[1], di);
+    vst2q_f32(f + 2 * (k + q), r);
+    r.val[0] = vsubq_f32(u1.val[0], dr), r.val[1] = vsubq_f32(u1.val[1], di);
+    vst2q_f32(f + 2 * (k + 3 * q), r);
+  }
+#endif
+  for (; k < q; k++) {
+    const cf a = out[k + 2 * q] * w1[k], b = out[k + 3 * q] * w3[k];
+    const cf s = a + b, d = rotate<Inverse>(a - b);
+    const cf u0 = out[k], u1 = out[k + q];
+    out[k] = u0 + s;
+    out[k + 2 * q] = u0 - s;
+    out[k + q] = u1 + d;
+    out[k + 3 * q] = u1 - d;
+  }
+}
+} // namespace
+
+FftPlan::FftPlan(size_t n) : n(n), offset(64, 0) {
+  for (size_t m = 8, level = 3; m <= n; m <<= 1, level++) {
+    const size_t q = m / 4;
+    offset[level] = fwdTwiddles.size();
+    for (size_t power = 1; power <= 3; power += 2)
+      for (size_t k = 0; k < q; k++) {
+        const double angle = -2.0 * PI * (double)(power * k) / (double)m;
+        fwdTwiddles.emplace_back((float)std::cos(angle),
+                                 (float)std::sin(angle));
+        invTwiddles.push_back(std::conj(fwdTwiddles.back()));
+      }
+  }
+}
+
+const FftPlan &FftPlan::cached(size_t n) {
+  static std::mutex lock;
+  static std::map<size_t, std::unique_ptr<FftPlan>> plans;
+  std::lock_guard<std::mutex> guard(lock);
+  std::unique_ptr<FftPlan> &plan = plans[n];
+  if (!plan)
+    plan = std::make_unique<FftPlan>(n);
+  return *plan;
+}
+
+template <bool Inverse>
+void FftPlan::transform(const cf *in, size_t stride, cf *out, size_t m) const {
+  if (m == 1) {
+    out[0] = in[0];
+    return;
+  }
+  if (m == 2) {
+    const cf a = in[0], b = in[stride];
+    out[0] = a + b;
+    out[1] = a - b;
+    return;
+  }
+  if (m == 4) {
+    const cf a = in[0], b = in[stride], c = in[2 * stride],
+             d = in[3 * stride];
+    const cf t0 = a + c, t1 = a - c, t2 = b + d;
+    const cf t3 = rotate<Inverse>(b - d);
+    out[0] = t0 + t2;
+    out[2] = t0 - t2;
+    out[1] = t1 + t3;
+    out[3] = t1 - t3;
+    return;
+  }
+  if (m == 8) {
+    // Both halves of the split straight from the input, then one combine.
+    const cf x0 = in[0], x2 = in[2 * stride], x4 = in[4 * stride],
+             x6 = in[6 * stride];
+    const cf t0 = x0 + x4, t1 = x0 - x4, t2 = x2 + x6;
+    const cf t3 = rotate<Inverse>(x2 - x6);
+    out[0] = t0 + t2;
+    out[2] = t0 - t2;
+    out[1] = t1 + t3;
+    out[3] = t1 - t3;
+    const cf x1 = in[stride], x5 = in[5 * stride], x3 = in[3 * stride],
+             x7 = in[7 * stride];
+    out[4] = x1 + x5;
+    out[5] = x1 - x5;
+    out[6] = x3 + x7;
+    out[7] = x3 - x7;
+    const cf *w1 = (Inverse ? invTwiddles : fwdTwiddles).data() + offset[3];
+    combine<Inverse>(out, 2, w1, w1 + 2);
+    return;
+  }
+  const size_t q = m / 4;
+  transform<Inverse>(in, 2 * stride, out, m / 2);
+  transform<Inverse>(in + stride, 4 * stride, out + 2 * q, q);
+  transform<Inverse>(in + 3 * stride, 4 * stride, out + 3 * q, q);
+  const cf *w1 = (Inverse ? invTwiddles : fwdTwiddles).data() +
+                 offset[__builtin_ctzll(m)];
+  combine<Inverse>(out, q, w1, w1 + q);
+}
+
+void FftPlan::forward(const cf *in, cf *out, size_t count, size_t inDist,
+                      size_t outDist) const {
+  inDist = inDist ? inDist : n;
+  outDist = outDist ? outDist : n;
+  for (size_t i = 0; i < count; i++)
+    transform<false>(in + i * inDist, 1, out + i * outDist, n);
+}
+
+void FftPlan::inverse(const cf *in, cf *out, size_t count, size_t inDist,
+                      size_t outDist) const {
+  inDist = inDist ? inDist : n;
+  outDist = outDist ? outDist : n;
+  for (size_t i = 0; i < count; i++)
+    transform<true>(in + i * inDist, 1, out + i * outDist, n);
+}
@@ -0,0 +1,211 @@
+/*
+ * fir_filter.cpp - Streaming real-tap FIR over complex samples.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "fir_filter.h"
+
+#include <algorithm>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+// out[n] = sum_j rev[j] * w[n + j] for n in [0, numOut), in floats:
+// complex sample n is floats 2n, 2n+1 and both get the same tap.
+void firKernel(const float *rev, size_t numTaps, const float *w,
+               size_t numOut, float *out) {
+  size_t n = 0;
+#if defined(__AVX2__)
+  // Four independent FMA chains (16 outputs) so the FMA latency is hidden.
+  for (; n + 16 <= numOut; n += 16) {
+    __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+    __m256 acc2 = _mm256_setzero_ps(), acc3 = _mm256_setzero_ps();
+    const float *x = w + 2 * n;
+    for (size_t j = 0; j < numTaps; j++, x += 2) {
+      __m256 h = _mm256_broadcast_ss(rev + j);
+#if defined(__FMA__)
+      acc0 = _mm256_fmadd_ps(h, _mm256_loadu_ps(x), acc0);
+      acc1 = _mm256_fmadd_ps(h, _mm256_loadu_ps(x + 8), acc1);
+      acc2 = _mm256_fmadd_ps(h, _mm256_loadu_ps(x + 16), acc2);
+      acc3 = _mm256_fmadd_ps(h, _mm256_loadu_ps(x + 24), acc3);
+#else
+      acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(h, _mm256_loadu_ps(x)));
+      acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(h, _mm256_loadu_ps(x + 8)));
+      acc2 = _mm256_add_ps(acc2, _mm256_mul_ps(h, _mm256_loadu_ps(x + 16)));
+      acc3 = _mm256_add_ps(acc3, _mm256_mul_ps(h, _mm256_loadu_ps(x + 24)));
+#endif
+    }
+    _mm256_storeu_ps(out + 2 * n, acc0);
+    _mm256_storeu_ps(out + 2 * n + 8, acc1);
+    _mm256_storeu_ps(out + 2 * n + 16, acc2);
+    _mm256_storeu_ps(out + 2 * n + 24, acc3);
+  }
+#elif defined(__ARM_NEON)
+  for (; n + 4 <= numOut; n += 4) {
+    float32x4_t acc0 = vdupq_n_f32(0.0f), acc1 = vdupq_n_f32(0.0f);
+    const float *x = w + 2 * n;
+    for (size_t j = 0; j < numTaps; j++, x += 2) {
+      acc0 = vmlaq_n_f32(acc0, vld1q_f32(x), rev[j]);
+      acc1 = vmlaq_n_f32(acc1, vld1q_f32(x + 4), rev[j]);
+    }
+    vst1q_f32(out + 2 * n, acc0);
+    vst1q_f32(out + 2 * n + 4, acc1);
+  }
+#endif
+  for (; n < numOut; n++) {
+    float re = 0.0f, im = 0.0f;
+    const float *x = w + 2 * n;
+    for (size_t j = 0; j < numTaps; j++) {
+      re += rev[j] * x[2 * j];
+      im += rev[j] * x[2 * j + 1];
+    }
+    out[2 * n] = re;
+    out[2 * n + 1] = im;
+  }
+}
+
+// x[k] *= h[k], complex.
+void multiplySpectrum(std::complex<float> *x, const std::complex<float> *h,
+                      size_t n) {
+  float *f = reinterpret_cast<float *>(x);
+  const float *g = reinterpret_cast<const float *>(h);
+  size_t k = 0;
+#if defined(__AVX2__)
+  for (; k + 4 <= n; k += 4) {
+    const __m256 a = _mm256_loadu_ps(f + 2 * k), w = _mm256_loadu_ps(g + 2 * k);
+    const __m256 wr = _mm256_moveldup_ps(w), wi = _mm256_movehdup_ps(w);
+    const __m256 aSwap = _mm256_permute_ps(a, 0xB1);
+#if defined(__FMA__)
+    _mm256_storeu_ps(f + 2 * k,
+                     _mm256_fmaddsub_ps(a, wr, _mm256_mul_ps(aSwap, wi)));
+#else
+    _mm256_storeu_ps(f + 2 * k, _mm256_addsub_ps(_mm256_mul_ps(a, wr),
+                                                 _mm256_mul_ps(aSwap, wi)));
+#endif
+  }
+#elif defined(__ARM_NEON)
+  for (; k + 4 <= n; k += 4) {
+    const float32x4x2_t a = vld2q_f32(f + 2 * k), w = vld2q_f32(g + 2 * k);
+    float32x4x2_t r;
+    r.val[0] = vmlsq_f32(vmulq_f32(a.val[0], w.val[0]), a.val[1], w.val[1]);
+    r.val[1] = vmlaq_f32(vmulq_f32(a.val[0], w.val[1]), a.val[1], w.val[0]);
+    vst2q_f32(f + 2 * k, r);
+  }
+#endif
+  // Spelled out: std::complex's operator* checks for inf/nan.
+  for (; k < n; k++) {
+    const float ar = f[2 * k], ai = f[2 * k + 1];
+    f[2 * k] = ar * g[2 * k] - ai * g[2 * k + 1];
+    f[2 * k + 1] = ar * g[2 * k + 1] + ai * g[2 * k];
+  }
+}
+} // namespace
+
+FirFilter::FirFilter(std::vector<float> taps, FirMethod method)
+    : method(method) {
+  setTaps(std::move(taps));
+}
+
+void FirFilter::reset() {
+  work.assign(coefficients.size() - 1, {0.0f, 0.0f});
+}
+
+void FirFilter::setTaps(std::vector<float> taps) {
+  if (taps.empty())
+    taps.push_back(1.0f);
+  // Keep the newest T - 1 inputs, zeros in front if there are fewer.
+  const size_t histLen = taps.size() - 1;
+  if (work.size() > histLen)
+    work.erase(work.begin(), work.end() - histLen);
+  else
+    work.insert(work.begin(), histLen - work.size(), {0.0f, 0.0f});
+
+  coefficients = std::move(taps);
+  reversed.assign(coefficients.rbegin(), coefficients.rend());
+  plan();
+}
+
+void FirFilter::plan() {
+  const size_t numTaps = coefficients.size();
+  const bool useFft =
+      method == FirMethod::OverlapSave ||
+      (method == FirMethod::Auto && numTaps >= FFT_THRESHOLD);
+  size_t n = 64;
+  while (n < 8 * numTaps && n < FftPlan::MAX_SIZE)
+    n <<= 1;
+  if (!useFft || numTaps > n / 2) {
+    fft = nullptr;
+    return;
+  }
+  // Same transform while the taps fit in half of it, so an adaptive filter
+  // updating its taps never allocates or builds a plan.
+  if (!fft || numTaps > fft->size() / 2) {
+    fft = &FftPlan::cached(n);
+    spectrum.resize(n);
+    bins.resize(n);
+    segment.resize(n);
+  }
+  n = fft->size();
+  std::fill(segment.begin(), segment.end(), 0.0f);
+  const float scale = 1.0f / (float)n;
+  for (size_t k = 0; k < numTaps; k++)
+    segment[k] = coefficients[k] * scale;
+  fft->forward(segment.data(), spectrum.data());
+}
+
+size_t FirFilter::filter(const std::complex<float> *in, size_t numSamples,
+                         std::complex<float> *out) {
+  const size_t histLen = coefficients.size() - 1;
+  work.resize(histLen + numSamples);
+  std::copy(in, in + numSamples, work.begin() + histLen);
+
+  if (fft)
+    filterFft(numSamples, out);
+  else
+    filterDirect(numSamples, out);
+
+  std::copy(work.end() - histLen, work.end(), work.begin());
+  work.resize(histLen);
+  return numSamples;
+}
+
+void FirFilter::filterDirect(size_t numSamples, std::complex<float> *out) {
+  firKernel(reversed.data(), reversed.size(),
+            reinterpret_cast<const float *>(work.data()), numSamples,
+            reinterpret_cast<float *>(out));
+}
+
+void FirFilter::filterFft(size_t numSamples, std::complex<float> *out) {
+  const size_t n = fft->size(), histLen = coefficients.size() - 1;
+  const size_t hop = n - histLen; // New outputs per segment
+  for (size_t done = 0; done < numSamples; done += hop) {
+    const size_t len = std::min(hop, numSamples - done);
+    const std::complex<float> *x = work.data() + done;
+    // A segment costs about what hop outputs of a FFT_THRESHOLD tap direct
+    // filter do, so a short tail (or block) is cheaper done directly.
+    if (len < hop && len * coefficients.size() < hop * FFT_THRESHOLD) {
+      firKernel(reversed.data(), reversed.size(),
+                reinterpret_cast<const float *>(x), len,
+                reinterpret_cast<float *>(out + done));
+      break;
+    }
+    if (len < hop) {
+      // Last, short segment: what's left, then zeros. Only wrapped around
+      // outputs (the ones thrown away) see the zeros.
+      std::copy(x, x + histLen + len, segment.begin());
+      std::fill(segment.begin() + histLen + len, segment.end(), 0.0f);
+      x = segment.data();
+    }
+    fft->forward(x, bins.data());
+    multiplySpectrum(bins.data(), spectrum.data(), n);
+    fft->inverse(bins.data(), segment.data());
+    std::copy(segment.begin() + histLen, segment.begin() + histLen + len,
+              out + done);
+  }
+}
@@ -0,0 +1,319 @@
+/*
+ * frame_sync.cpp - CCSDS attached sync marker search and PN randomizer.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "frame_sync.h"
+
+#include <algorithm>
+#include <bit>
+#include <complex>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+// Zeros kept after the data, so 64 bit windows and 64 LLR loads can run
+// past the end.
+constexpr size_t PAD = 128;
+
+unsigned nearestLabel(std::complex<float> p,
+                      std::span<const std::complex<float>> points) {
+  unsigned best = 0;
+  for (unsigned l = 1; l < points.size(); l++)
+    if (std::norm(points[l] - p) < std::norm(points[best] - p))
+      best = l;
+  return best;
+}
+} // namespace
+
+// *** === Frame sync === ***
+FrameSync::FrameSync(size_t periodBits, Ambiguity ambiguity, uint64_t marker,
+                     unsigned markerBits, size_t markerAt, bool keepMarker)
+    : period(periodBits), markerBits(std::clamp(markerBits, 1u, 64u)),
+      markerAt(markerAt), keepMarker(keepMarker),
+      maxErrors(this->markerBits / 10) {
+  if (period < markerAt + this->markerBits) {
+    fprintf(stderr, "[WARNING] Frame of %zu bits is shorter than its %u bit "
+                    "marker.\n", period, this->markerBits);
+    period = markerAt + this->markerBits;
+  }
+  if (ambiguity == Ambiguity::Qpsk && (period % 2 != 0 || markerAt % 2 != 0)) {
+    fprintf(stderr, "[WARNING] Odd frame length or marker position; QPSK "
+                    "ambiguities are not searched.\n");
+    ambiguity = Ambiguity::None;
+  }
+  step = (ambiguity == Ambiguity::Qpsk) ? 2 : 1;
+
+  // Label bit maps for each rotation (and conjugate), worked out from the
+  // constellation rather than by hand: received bit i == sent bit src[i]
+  // ^ flip[i] holds for every label under Gray coded BPSK and QPSK.
+  const unsigned numRot = (ambiguity == Ambiguity::Qpsk)   ? 4
+                          : (ambiguity == Ambiguity::Bpsk) ? 2
+                                                           : 1;
+  const unsigned numConj = (ambiguity == Ambiguity::Qpsk) ? 2 : 1;
+  const Modulation mod =
+      (ambiguity == Ambiguity::Qpsk) ? Modulation::QPSK : Modulation::BPSK;
+  const auto points = constellationPoints(mod);
+  const unsigned bits = (unsigned)step;
+  for (unsigned c = 0; c < numConj; c++)
+    for (unsigned r = 0; r < numRot; r++) {
+      Variant v{};
+      v.rotation = r * 360 / std::max(numRot, 2u);
+      v.conjugated = c != 0;
+      std::complex<float> turn = std::polar(1.0f, (float)(v.rotation *
+                                                          constellation::PI /
+                                                          180.0));
+      unsigned map[4];
+      for (unsigned l = 0; l < points.size(); l++)
+        map[l] = nearestLabel((c ? std::conj(points[l]) : points[l]) * turn,
+                              points);
+      auto bitOf = [&](unsigned label, unsigned i) {
+        return (label >> (bits - 1 - i)) & 1;
+      };
+      for (unsigned i = 0; i < bits; i++)
+        for (unsigned j = 0; j < bits; j++)
+          for (unsigned f = 0; f < 2; f++) {
+            bool holds = true;
+            for (unsigned l = 0; l < points.size(); l++)
+              holds &= bitOf(map[l], i) == (bitOf(l, j) ^ f);
+            if (holds) {
+              v.src[i] = (uint8_t)j;
+              v.flip[i] = f != 0;
+            }
+          }
+
+      for (unsigned k = 0; k < this->markerBits; k++) {
+        const unsigned base = k - k % bits, i = k % bits;
+        const unsigned from = base + v.src[i];
+        if (from >= this->markerBits)
+          continue; // Its partner is outside the marker
+        const unsigned sent =
+            (unsigned)(marker >> (this->markerBits - 1 - from)) & 1;
+        const unsigned got = sent ^ (v.flip[i] ? 1 : 0);
+        v.pattern |= (uint64_t)got << k;
+        v.mask |= uint64_t(1) << k;
+        v.signs[k] = got ? -1 : 1;
+      }
+      variants.push_back(v);
+    }
+  reset();
+}
+
+void FrameSync::reset() {
+  buf.assign(PAD, 0);
+  hard.clear();
+  fill = 0;
+  pos = markerAt; // Room for the start of the first frame
+  lock = checked = false;
+  misses = 0;
+  current = 0;
+}
+
+// Hard decisions for everything buffered: bit k of the stream is bit k % 64
+// of word k / 64, set for negative LLRs (a 1).
+void FrameSync::packSigns(size_t from) {
+  const size_t words = (fill + 63) / 64 + 1;
+  hard.resize(words);
+  for (size_t w = from / 64; w < words; w++) {
+    const int8_t *l = buf.data() + 64 * w;
+#if defined(__AVX2__)
+    uint32_t lo = (uint32_t)_mm256_movemask_epi8(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(l)));
+    uint32_t hi = (uint32_t)_mm256_movemask_epi8(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(l + 32)));
+    hard[w] = ((uint64_t)hi << 32) | lo;
+#else
+    uint64_t word = 0;
+    for (unsigned k = 0; k < 64; k++)
+      word |= (uint64_t)(l[k] < 0) << k;
+    hard[w] = word;
+#endif
+  }
+}
+
+uint64_t FrameSync::window(size_t p) const {
+  const size_t w = p / 64, shift = p % 64;
+  if (shift == 0)
+    return hard[w];
+  return (hard[w] >> shift) | (hard[w + 1] << (64 - shift));
+}
+
+// sum(sign * llr) / sum(|llr|) over the marker, in [-1, 1]; the hard bits'
+// agreement when the LLRs there are all 0.
+float FrameSync::correlation(size_t p, const Variant &v) const {
+  const int8_t *l = buf.data() + p;
+  int dot = 0, mag = 0;
+#if defined(__AVX2__)
+  const __m256i ones8 = _mm256_set1_epi8(1), ones16 = _mm256_set1_epi16(1);
+  __m256i accDot = _mm256_setzero_si256(), accMag = _mm256_setzero_si256();
+  for (unsigned k = 0; k < 64; k += 32) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(l + k));
+    __m256i s = _mm256_load_si256(reinterpret_cast<const __m256i *>(v.signs + k));
+    __m256i prod = _mm256_sign_epi8(x, s); // 0 where the sign is 0
+    __m256i abs = _mm256_abs_epi8(prod);
+    accDot = _mm256_add_epi32(
+        accDot,
+        _mm256_madd_epi16(_mm256_maddubs_epi16(ones8, prod), ones16));
+    accMag = _mm256_add_epi32(
+        accMag, _mm256_madd_epi16(_mm256_maddubs_epi16(ones8, abs), ones16));
+  }
+  // Both horizontal sums at once: dot in the low half, mag in the high.
+  __m256i both = _mm256_hadd_epi32(accDot, accMag);
+  both = _mm256_hadd_epi32(both, both);
+  __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(both),
+                              _mm256_extracti128_si256(both, 1));
+  dot = _mm_cvtsi128_si32(sum);
+  mag = _mm_extract_epi32(sum, 1);
+#else
+  for (unsigned k = 0; k < 64; k++) {
+    dot += v.signs[k] * l[k];
+    mag += v.signs[k] ? std::abs(l[k]) : 0;
+  }
+#endif
+  if (mag > 0)
+    return (float)dot / (float)mag;
+  // All zero LLRs (a demapper that hasn't measured its noise yet, or hard
+  // bits fed through as 0s): fall back on the hard decisions, so the score
+  // is 1 - 2 * (bits wrong) / (bits compared) rather than nothing at all.
+  const int wrong = std::popcount((window(p) ^ v.pattern) & v.mask);
+  return 1.0f - 2.0f * (float)wrong / (float)std::popcount(v.mask);
+}
+
+bool FrameSync::search() {
+  for (; pos + markerBits <= fill; pos += step) {
+    const uint64_t w = window(pos);
+    float best = -1.0f;
+    for (size_t i = 0; i < variants.size(); i++) {
+      const Variant &v = variants[i];
+      if ((unsigned)std::popcount((w ^ v.pattern) & v.mask) > maxErrors)
+        continue;
+      float c = correlation(pos, v);
+      if (c > best) {
+        best = c;
+        current = i;
+      }
+    }
+    if (best > 0.0f) {
+      pos -= markerAt;
+      lock = checked = true;
+      misses = 0;
+      return true;
+    }
+  }
+  return false;
+}
+
+void FrameSync::undo(int8_t *llrs, size_t n, const Variant &v) const {
+  if (step == 2) {
+    if (v.src[0] == 0 && !v.flip[0] && !v.flip[1])
+      return;
+    for (size_t k = 0; k + 1 < n; k += 2) {
+      const int8_t got[2] = {llrs[k], llrs[k + 1]};
+      for (unsigned i = 0; i < 2; i++)
+        llrs[k + v.src[i]] = v.flip[i] ? (int8_t)-got[i] : got[i];
+    }
+  } else if (v.flip[0]) {
+    for (size_t k = 0; k < n; k++)
+      llrs[k] = (int8_t)-llrs[k];
+  }
+}
+
+size_t FrameSync::process(const int8_t *llrs, size_t n, int8_t *frames) {
+  buf.resize(fill + n + PAD); // The old padding is zero, so is the new
+  std::copy(llrs, llrs + n, buf.begin() + fill);
+  const size_t from = fill;
+  fill += n;
+  packSigns(from);
+
+  const size_t skip = keepMarker ? 0 : markerAt + markerBits;
+  size_t out = 0;
+  for (;;) {
+    if (!lock && !search())
+      break;
+    if (pos + period > fill)
+      break; // Wait for the rest of the frame
+    if (!checked) {
+      if (correlation(pos + markerAt, variants[current]) <
+          LOCKED_CORRELATION) {
+        if (++misses > MAX_MISSES) {
+          lock = false;
+          numLosses++;
+          pos += markerAt + step;
+          continue;
+        }
+      } else {
+        misses = 0;
+      }
+    }
+    checked = false;
+    int8_t *f = buf.data() + pos;
+    undo(f, period, variants[current]);
+    std::copy(f + skip, f + period, frames + out * frameBits());
+    out++;
+    numFrames++;
+    pos += period;
+  }
+
+  // Forget what's behind the next frame's start (a whole number of symbols,
+  // so the pairs stay where they were).
+  const size_t drop = lock ? pos : pos - std::min(pos, markerAt);
+  buf.erase(buf.begin(), buf.begin() + drop);
+  fill -= drop;
+  pos -= drop;
+  packSigns(0);
+  return out;
+}
+
+// *** === Randomizer === ***
+Randomizer::Randomizer(size_t frameBytes)
+    : pn(frameBytes), signs(8 * frameBytes) {
+  unsigned x = 0xff;
+  for (size_t i = 0; i < 8 * frameBytes; i++) {
+    const unsigned bit = x & 1;
+    pn[i / 8] = (uint8_t)((pn[i / 8] << 1) | bit);
+    signs[i] = bit ? -1 : 1;
+    const unsigned fb = (x ^ (x >> 3) ^ (x >> 5) ^ (x >> 7)) & 1;
+    x = (x >> 1) | (fb << 7);
+  }
+}
+
+void Randomizer::apply(uint8_t *bytes) const {
+  const size_t n = pn.size();
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    uint64_t a, b;
+    std::memcpy(&a, bytes + i, 8);
+    std::memcpy(&b, pn.data() + i, 8);
+    a ^= b;
+    std::memcpy(bytes + i, &a, 8);
+  }
+  for (; i < n; i++)
+    bytes[i] ^= pn[i];
+}
+
+void Randomizer::applySoft(int8_t *llrs) const {
+  const size_t n = signs.size();
+  size_t i = 0;
+#if defined(__AVX2__)
+  for (; i + 32 <= n; i += 32) {
+    __m256i l = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(llrs + i));
+    __m256i s =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(signs.data() + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(llrs + i),
+                        _mm256_sign_epi8(l, s));
+  }
+#elif defined(__ARM_NEON)
+  for (; i + 16 <= n; i += 16)
+    vst1q_s8(llrs + i, vmulq_s8(vld1q_s8(llrs + i), vld1q_s8(signs.data() + i)));
+#endif
+  for (; i < n; i++)
+    llrs[i] = (int8_t)(llrs[i] * signs[i]);
+}
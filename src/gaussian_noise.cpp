@@ -0,0 +1,289 @@
+/*
+ * gaussian_noise.cpp - Vectorized xoshiro256+ and Box-Muller Gaussian noise.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "gaussian_noise.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+constexpr uint64_t JUMP[4] = {0x180ec6d33cfd0aba, 0xd5a61266f0c9392c,
+                              0xa9582618e03fc9aa, 0x39abdc4529b1661c};
+constexpr uint64_t LONG_JUMP[4] = {0x76e15d3efefdcbbf, 0xc5004e441c522fb3,
+                                   0x77710069854ee241, 0x39109bb02acbe635};
+
+constexpr size_t CHUNK_BATCHES = 32; // Normals made per pass, on the stack
+constexpr float TO_UNIT = 1.0f / 16777216.0f; // 2^-24
+constexpr float SQRT_HALF = 0.707106781186547524f;
+constexpr float LN2_HI = 0.693359375f;
+constexpr float LN2_LO = -2.12194440e-4f;
+constexpr float HALF_PI = 1.57079632679489662f;
+
+// Cephes logf: x = m 2^e with m in [sqrt(1/2), sqrt(2)), log(m) by a
+// polynomial in m - 1.
+constexpr float LOG_POLY[9] = {7.0376836292e-2f,  -1.1514610310e-1f,
+                               1.1676998740e-1f,  -1.2420140846e-1f,
+                               1.4249322787e-1f,  -1.6668057665e-1f,
+                               2.0000714765e-1f,  -2.4999993993e-1f,
+                               3.3333331174e-1f};
+// Cephes sinf/cosf on [-pi/4, pi/4].
+constexpr float SIN_POLY[3] = {-1.9515295891e-4f, 8.3321608736e-3f,
+                               -1.6666654611e-1f};
+constexpr float COS_POLY[3] = {2.443315711809948e-5f, -1.388731625493765e-3f,
+                               4.166664568298827e-2f};
+
+uint64_t splitmix64(uint64_t &x) {
+  uint64_t z = (x += 0x9e3779b97f4a7c15);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+  return z ^ (z >> 31);
+}
+
+#if defined(__AVX2__)
+// a * b + c
+inline __m256 madd(__m256 a, __m256 b, __m256 c) {
+#if defined(__FMA__)
+  return _mm256_fmadd_ps(a, b, c);
+#else
+  return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+}
+
+inline __m256 logPs(__m256 x) {
+  const __m256 one = _mm256_set1_ps(1.0f);
+  __m256i bits = _mm256_castps_si256(x);
+  __m256 e = _mm256_cvtepi32_ps(
+      _mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(126)));
+  __m256 m = _mm256_castsi256_ps(_mm256_or_si256(
+      _mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)),
+      _mm256_set1_epi32(0x3f000000)));
+  __m256 small = _mm256_cmp_ps(m, _mm256_set1_ps(SQRT_HALF), _CMP_LT_OQ);
+  e = _mm256_sub_ps(e, _mm256_and_ps(small, one));
+  m = _mm256_sub_ps(_mm256_add_ps(m, _mm256_and_ps(small, m)), one);
+  const __m256 z = _mm256_mul_ps(m, m);
+  __m256 y = _mm256_set1_ps(LOG_POLY[0]);
+  for (int k = 1; k < 9; k++)
+    y = madd(y, m, _mm256_set1_ps(LOG_POLY[k]));
+  y = _mm256_mul_ps(_mm256_mul_ps(y, m), z);
+  y = madd(e, _mm256_set1_ps(LN2_LO), y);
+  y = madd(_mm256_set1_ps(-0.5f), z, y);
+  return madd(e, _mm256_set1_ps(LN2_HI), _mm256_add_ps(m, y));
+}
+
+inline void sinCosTurnsPs(__m256 u, __m256 &c, __m256 &s) {
+  const __m256 u4 = _mm256_mul_ps(u, _mm256_set1_ps(4.0f));
+  const __m256 q = _mm256_round_ps(u4, _MM_FROUND_TO_NEAREST_INT |
+                                           _MM_FROUND_NO_EXC);
+  const __m256 x = _mm256_mul_ps(_mm256_sub_ps(u4, q), _mm256_set1_ps(HALF_PI));
+  const __m256 z = _mm256_mul_ps(x, x);
+  __m256 sp =
+      madd(_mm256_set1_ps(SIN_POLY[0]), z, _mm256_set1_ps(SIN_POLY[1]));
+  sp = madd(sp, z, _mm256_set1_ps(SIN_POLY[2]));
+  sp = madd(_mm256_mul_ps(sp, z), x, x);
+  __m256 cp =
+      madd(_mm256_set1_ps(COS_POLY[0]), z, _mm256_set1_ps(COS_POLY[1]));
+  cp = madd(cp, z, _mm256_set1_ps(COS_POLY[2]));
+  cp = madd(_mm256_mul_ps(cp, z), z,
+            madd(_mm256_set1_ps(-0.5f), z, _mm256_set1_ps(1.0f)));
+
+  const __m256i quad = _mm256_cvtps_epi32(q);
+  const __m256 swap = _mm256_castsi256_ps(_mm256_slli_epi32(quad, 31));
+  const __m256 cs = _mm256_blendv_ps(cp, sp, swap);
+  const __m256 ss = _mm256_blendv_ps(sp, cp, swap);
+  // Sign bits: cos negative in quadrants 1 and 2, sin in 2 and 3.
+  const __m256i two = _mm256_set1_epi32(2);
+  const __m256i cSign = _mm256_slli_epi32(
+      _mm256_and_si256(_mm256_add_epi32(quad, _mm256_set1_epi32(1)), two), 30);
+  const __m256i sSign = _mm256_slli_epi32(_mm256_and_si256(quad, two), 30);
+  c = _mm256_xor_ps(cs, _mm256_castsi256_ps(cSign));
+  s = _mm256_xor_ps(ss, _mm256_castsi256_ps(sSign));
+}
+
+// One xoshiro256+ step of all four lanes.
+inline __m256i nextLanes(__m256i &s0, __m256i &s1, __m256i &s2, __m256i &s3) {
+  const __m256i result = _mm256_add_epi64(s0, s3);
+  const __m256i t = _mm256_slli_epi64(s1, 17);
+  s2 = _mm256_xor_si256(s2, s0);
+  s3 = _mm256_xor_si256(s3, s1);
+  s1 = _mm256_xor_si256(s1, s2);
+  s0 = _mm256_xor_si256(s0, s3);
+  s2 = _mm256_xor_si256(s2, t);
+  s3 = _mm256_or_si256(_mm256_slli_epi64(s3, 45), _mm256_srli_epi64(s3, 19));
+  return result;
+}
+#else
+// The scalar twins of the AVX2 kernels above, same steps in the same order.
+float logPoly(float x) {
+  uint32_t bits;
+  std::memcpy(&bits, &x, 4);
+  float e = (float)((int)(bits >> 23) - 126);
+  bits = (bits & 0x007fffff) | 0x3f000000; // [0.5, 1)
+  float m;
+  std::memcpy(&m, &bits, 4);
+  if (m < SQRT_HALF) {
+    e -= 1.0f;
+    m = m + m - 1.0f;
+  } else {
+    m = m - 1.0f;
+  }
+  const float z = m * m;
+  float y = LOG_POLY[0];
+  for (int k = 1; k < 9; k++)
+    y = y * m + LOG_POLY[k];
+  y = y * m * z;
+  y += e * LN2_LO;
+  y -= 0.5f * z;
+  return m + y + e * LN2_HI;
+}
+
+// cos and sin of 2 pi u, u in [0, 1): the nearest quarter turn q, then
+// +-pi/4 around it.
+void sinCosTurns(float u, float &c, float &s) {
+  const float q = std::nearbyint(4.0f * u);
+  const float x = (4.0f * u - q) * HALF_PI, z = x * x;
+  float sp = ((SIN_POLY[0] * z + SIN_POLY[1]) * z + SIN_POLY[2]) * z * x + x;
+  float cp = ((COS_POLY[0] * z + COS_POLY[1]) * z + COS_POLY[2]) * z * z -
+             0.5f * z + 1.0f;
+  const unsigned quad = (unsigned)q;
+  if (quad & 1)
+    std::swap(sp, cp);
+  c = ((quad + 1) & 2) ? -cp : cp;
+  s = (quad & 2) ? -sp : sp;
+}
+#endif
+} // namespace
+
+// *** === Xoshiro256 === ***
+Xoshiro256::Xoshiro256(uint64_t seed) {
+  for (uint64_t &w : s)
+    w = splitmix64(seed);
+}
+
+void Xoshiro256::apply(const uint64_t *poly) {
+  uint64_t t[4] = {0, 0, 0, 0};
+  for (int i = 0; i < 4; i++)
+    for (int b = 0; b < 64; b++) {
+      if (poly[i] & (uint64_t(1) << b))
+        for (int k = 0; k < 4; k++)
+          t[k] ^= s[k];
+      next();
+    }
+  std::memcpy(s, t, sizeof(s));
+}
+
+void Xoshiro256::jump() { apply(JUMP); }
+void Xoshiro256::longJump() { apply(LONG_JUMP); }
+
+// *** === Gaussian noise === ***
+GaussianNoise::GaussianNoise(uint64_t seed, uint64_t stream) {
+  Xoshiro256 gen(seed);
+  for (uint64_t k = 0; k < stream; k++)
+    gen.longJump();
+  for (size_t lane = 0; lane < LANES; lane++) {
+    for (int w = 0; w < 4; w++)
+      state[w][lane] = gen.words()[w];
+    gen.jump();
+  }
+}
+
+void GaussianNoise::refill(float *out, size_t batches) {
+#if defined(__AVX2__)
+  __m256i s0 = _mm256_load_si256(reinterpret_cast<const __m256i *>(state[0]));
+  __m256i s1 = _mm256_load_si256(reinterpret_cast<const __m256i *>(state[1]));
+  __m256i s2 = _mm256_load_si256(reinterpret_cast<const __m256i *>(state[2]));
+  __m256i s3 = _mm256_load_si256(reinterpret_cast<const __m256i *>(state[3]));
+  const __m256 unit = _mm256_set1_ps(TO_UNIT);
+  for (size_t k = 0; k < batches; k++, out += BATCH) {
+    const __m256i a = _mm256_srli_epi32(nextLanes(s0, s1, s2, s3), 8);
+    const __m256i b = _mm256_srli_epi32(nextLanes(s0, s1, s2, s3), 8);
+    const __m256 u1 = _mm256_mul_ps(
+        _mm256_cvtepi32_ps(_mm256_add_epi32(a, _mm256_set1_epi32(1))), unit);
+    const __m256 u2 = _mm256_mul_ps(_mm256_cvtepi32_ps(b), unit);
+    const __m256 r =
+        _mm256_sqrt_ps(_mm256_mul_ps(_mm256_set1_ps(-2.0f), logPs(u1)));
+    __m256 c, s;
+    sinCosTurnsPs(u2, c, s);
+    _mm256_storeu_ps(out, _mm256_mul_ps(r, c));
+    _mm256_storeu_ps(out + 8, _mm256_mul_ps(r, s));
+  }
+  _mm256_store_si256(reinterpret_cast<__m256i *>(state[0]), s0);
+  _mm256_store_si256(reinterpret_cast<__m256i *>(state[1]), s1);
+  _mm256_store_si256(reinterpret_cast<__m256i *>(state[2]), s2);
+  _mm256_store_si256(reinterpret_cast<__m256i *>(state[3]), s3);
+#else
+  for (size_t b = 0; b < batches; b++, out += BATCH) {
+    // Two steps of every lane, each 64 bit output split into two words
+    // (low half first), as the AVX2 registers hold them.
+    uint32_t words[2][2 * LANES];
+    for (int step = 0; step < 2; step++)
+      for (size_t lane = 0; lane < LANES; lane++) {
+        uint64_t *s = &state[0][lane];
+        const size_t W = LANES; // Between words of a lane
+        const uint64_t result = s[0] + s[3 * W];
+        const uint64_t t = s[W] << 17;
+        s[2 * W] ^= s[0];
+        s[3 * W] ^= s[W];
+        s[W] ^= s[2 * W];
+        s[0] ^= s[3 * W];
+        s[2 * W] ^= t;
+        s[3 * W] = (s[3 * W] << 45) | (s[3 * W] >> 19);
+        words[step][2 * lane] = (uint32_t)result;
+        words[step][2 * lane + 1] = (uint32_t)(result >> 32);
+      }
+    for (size_t k = 0; k < 2 * LANES; k++) {
+      const float u1 = (float)((words[0][k] >> 8) + 1) * TO_UNIT;
+      const float u2 = (float)(words[1][k] >> 8) * TO_UNIT;
+      const float r = std::sqrt(-2.0f * logPoly(u1));
+      float c, s;
+      sinCosTurns(u2, c, s);
+      out[k] = r * c;
+      out[k + 2 * LANES] = r * s;
+    }
+  }
+#endif
+}
+
+void GaussianNoise::emit(float *dst, size_t n, float sigma, bool accumulate) {
+  auto put = [&](const float *src, size_t m) {
+    if (accumulate)
+      for (size_t i = 0; i < m; i++)
+        dst[i] += sigma * src[i];
+    else
+      for (size_t i = 0; i < m; i++)
+        dst[i] = sigma * src[i];
+    dst += m;
+    n -= m;
+  };
+
+  size_t take = std::min(numSpare, n);
+  put(spare + BATCH - numSpare, take);
+  numSpare -= take;
+  alignas(32) float chunk[CHUNK_BATCHES * BATCH];
+  while (n >= BATCH) {
+    const size_t batches = std::min(n / BATCH, CHUNK_BATCHES);
+    refill(chunk, batches);
+    put(chunk, batches * BATCH);
+  }
+  if (n > 0) {
+    refill(spare, 1);
+    numSpare = BATCH - n;
+    put(spare, n);
+  }
+}
+
+void GaussianNoise::generate(float *out, size_t n, float sigma) {
+  emit(out, n, sigma, false);
+}
+
+void GaussianNoise::add(std::complex<float> *x, size_t n, float sigma) {
+  emit(reinterpret_cast<float *>(x), 2 * n, sigma, true);
+}
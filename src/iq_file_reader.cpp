@@ -0,0 +1,239 @@
+/*
+ * iq_file_reader.cpp - Streaming reader for large cf32/cs16/cs8 recordings.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "iq_file_reader.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+uint64_t pageSize() {
+  static const uint64_t size = (uint64_t)sysconf(_SC_PAGESIZE);
+  return size;
+}
+} // namespace
+
+void DcBlocker::process(std::complex<float> *data, size_t numSamples) {
+  if (numSamples == 0)
+    return;
+  float *f = reinterpret_cast<float *>(data);
+
+  // Eight independent float lanes (even I, odd Q) vectorize without
+  // reassociation; they're flushed to double every SUM_BLOCK floats.
+  constexpr size_t LANES = 8, SUM_BLOCK = 2048;
+  const size_t numFloats = 2 * numSamples;
+  double sumI = 0.0, sumQ = 0.0;
+  size_t i = 0;
+  while (i + LANES <= numFloats) {
+    float lane[LANES] = {};
+    const size_t end = std::min(numFloats, i + SUM_BLOCK) / LANES * LANES;
+    for (; i < end; i += LANES)
+      for (size_t j = 0; j < LANES; j++)
+        lane[j] += f[i + j];
+    for (size_t j = 0; j < LANES; j += 2) {
+      sumI += lane[j];
+      sumQ += lane[j + 1];
+    }
+  }
+  for (; i < numFloats; i += 2) {
+    sumI += f[i];
+    sumQ += f[i + 1];
+  }
+  std::complex<double> mean(sumI / numSamples, sumQ / numSamples);
+
+  if (!primed) {
+    estimate = mean;
+    primed = true;
+  } else {
+    double alpha = 1.0 - std::exp(-(double)numSamples / tau);
+    estimate += alpha * (mean - estimate);
+  }
+
+  const float dcI = (float)estimate.real(), dcQ = (float)estimate.imag();
+  for (i = 0; i < numFloats; i += 2) {
+    f[i] -= dcI;
+    f[i + 1] -= dcQ;
+  }
+}
+
+IQFileReader::IQFileReader(const std::string &filename)
+    : IQFileReader(filename, formatFromFilename(filename)) {}
+
+IQFileReader::IQFileReader(const std::string &filename, SampleFormat fmt,
+                           FileAccess access, float fullScale)
+    : filename(filename), fmt(fmt), fullScale(fullScale),
+      sampleBytes(bytesPerSample(fmt)) {
+  fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    fprintf(stderr, "%s could not be opened! (%s)\n", filename.c_str(),
+            strerror(errno));
+    return;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    fprintf(stderr, "%s is not a regular file.\n", filename.c_str());
+    close(fd);
+    fd = -1;
+    return;
+  }
+  fileBytes = (uint64_t)st.st_size;
+  totalSamples = fileBytes / sampleBytes;
+  if (fileBytes % sampleBytes != 0)
+    fprintf(stderr, "[WARNING] %s ends in a partial %s sample, ignoring it.\n",
+            filename.c_str(), formatName(fmt));
+
+  if (access != FileAccess::Pread && fileBytes > 0) {
+    void *m = mmap(nullptr, fileBytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (m != MAP_FAILED) {
+      mapping = static_cast<const uint8_t *>(m);
+      madvise(m, fileBytes, MADV_SEQUENTIAL);
+    } else if (access == FileAccess::Mmap) {
+      fprintf(stderr, "Could not mmap %s (%s)\n", filename.c_str(),
+              strerror(errno));
+      close(fd);
+      fd = -1;
+      return;
+    }
+  }
+  if (!mapping)
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+}
+
+IQFileReader::~IQFileReader() {
+  if (mapping)
+    munmap(const_cast<uint8_t *>(mapping), fileBytes);
+  if (fd >= 0)
+    close(fd);
+}
+
+int IQFileReader::preadAll(uint8_t *dst, size_t numBytes,
+                           uint64_t fileOffset) {
+  while (numBytes > 0) {
+    ssize_t n = pread(fd, dst, numBytes, (off_t)fileOffset);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0) {
+      fprintf(stderr, "Could not read %s at byte %llu (%s)\n",
+              filename.c_str(), (unsigned long long)fileOffset,
+              n < 0 ? strerror(errno) : "unexpected end of file");
+      return 1;
+    }
+    dst += n;
+    numBytes -= (size_t)n;
+    fileOffset += (uint64_t)n;
+  }
+  return 0;
+}
+
+size_t IQFileReader::read(size_t offset, size_t numSamples,
+                          std::complex<float> *out) {
+  if (!isOpen() || offset >= totalSamples)
+    return 0;
+  numSamples = std::min(numSamples, totalSamples - offset);
+  const uint64_t byteOffset = (uint64_t)offset * sampleBytes;
+
+  if (mapping) {
+    toComplexFloat(fmt, mapping + byteOffset, numSamples, out, fullScale);
+    return numSamples;
+  }
+
+  if (fmt == SampleFormat::CF32) { // Straight into place
+    if (preadAll(reinterpret_cast<uint8_t *>(out),
+                 numSamples * sampleBytes, byteOffset) != 0)
+      return 0;
+    return numSamples;
+  }
+  raw.resize(std::max(raw.size(), numSamples * sampleBytes));
+  if (preadAll(raw.data(), numSamples * sampleBytes, byteOffset) != 0)
+    return 0;
+  toComplexFloat(fmt, raw.data(), numSamples, out, fullScale);
+  return numSamples;
+}
+
+std::span<const std::complex<float>> IQFileReader::window(size_t offset,
+                                                          size_t numSamples) {
+  if (!isOpen() || offset >= totalSamples)
+    return {};
+  numSamples = std::min(numSamples, totalSamples - offset);
+
+  if (mapping && fmt == SampleFormat::CF32)
+    return {reinterpret_cast<const std::complex<float> *>(mapping) + offset,
+            numSamples};
+
+  if (converted.size() < numSamples)
+    converted.resize(numSamples);
+  size_t n = read(offset, numSamples, converted.data());
+  return {converted.data(), n};
+}
+
+std::span<const std::complex<float>> IQFileReader::next(size_t maxSamples) {
+  std::span<const std::complex<float>> w;
+  if (removeDc) { // Has to be a copy we can write to
+    if (converted.size() < maxSamples)
+      converted.resize(maxSamples);
+    size_t n = read(pos, maxSamples, converted.data());
+    dc.process(converted.data(), n);
+    w = {converted.data(), n};
+  } else {
+    w = window(pos, maxSamples);
+  }
+  adviseAround((uint64_t)pos * sampleBytes,
+               (uint64_t)(pos + w.size()) * sampleBytes);
+  pos += w.size();
+  return w;
+}
+
+void IQFileReader::seek(size_t sample) {
+  pos = std::min(sample, totalSamples);
+  dc.reset();
+  // Start the readahead window over from here.
+  const uint64_t byteOffset = (uint64_t)pos * sampleBytes;
+  aheadMark = behindMark = byteOffset / pageSize() * pageSize();
+}
+
+void IQFileReader::enableDcRemoval(double timeConstant) {
+  removeDc = true;
+  dc = DcBlocker(timeConstant);
+}
+
+// Once the reader gets within half a readahead step of what we've asked the
+// kernel for, ask for the next step; once the window is a whole step past
+// what we've dropped, drop everything before it. Both are page aligned and
+// a syscall per step, not per window.
+void IQFileReader::adviseAround(uint64_t windowStart, uint64_t windowEnd) {
+  if (!isOpen())
+    return;
+  const uint64_t step = READAHEAD_BYTES;
+  uint8_t *base = const_cast<uint8_t *>(mapping);
+  while (aheadMark < fileBytes && aheadMark < windowEnd + step / 2) {
+    uint64_t len = std::min(step, fileBytes - aheadMark);
+    if (mapping)
+      madvise(base + aheadMark, len, MADV_WILLNEED);
+    else
+      posix_fadvise(fd, (off_t)aheadMark, (off_t)len, POSIX_FADV_WILLNEED);
+    aheadMark += len;
+  }
+
+  // The caller is still looking at the window we just handed out.
+  const uint64_t keepFrom = windowStart / pageSize() * pageSize();
+  if (keepFrom < behindMark + step)
+    return;
+  const uint64_t len = keepFrom - behindMark;
+  if (mapping)
+    madvise(base + behindMark, len, MADV_DONTNEED);
+  else
+    posix_fadvise(fd, (off_t)behindMark, (off_t)len, POSIX_FADV_DONTNEED);
+  behindMark = keepFrom;
+}
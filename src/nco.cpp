@@ -0,0 +1,201 @@
+/*
+ * nco.cpp - Phase continuous, vectorized numerically controlled oscillator.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "nco.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+constexpr double TWO_PI = 6.283185307179586;
+constexpr double RAD_PER_LSB = TWO_PI / 18446744073709551616.0; // 2*pi / 2^64
+
+inline uint64_t radiansToAcc(double radians) {
+  double turns = radians / TWO_PI;
+  turns -= std::floor(turns);
+  double scaled = turns * 18446744073709551616.0;
+  return (scaled >= 18446744073709551616.0) ? 0 : (uint64_t)scaled;
+}
+
+#if defined(__AVX2__)
+// (ar + j*ai)(br + j*bi) for 4 interleaved complex floats at once.
+inline __m256 cmul(__m256 a, __m256 b) {
+  __m256 br = _mm256_moveldup_ps(b);
+  __m256 bi = _mm256_movehdup_ps(b);
+  __m256 aSwap = _mm256_permute_ps(a, 0xB1); // ai, ar
+#if defined(__FMA__)
+  return _mm256_fmaddsub_ps(a, br, _mm256_mul_ps(aSwap, bi));
+#else
+  return _mm256_addsub_ps(_mm256_mul_ps(a, br), _mm256_mul_ps(aSwap, bi));
+#endif
+}
+
+// Run numSamples (a multiple of LANES) through the rotator; lanes is left
+// pointing at the next LANES samples.
+void rotate(const std::complex<float> *in, std::complex<float> *out,
+            size_t numSamples, std::complex<float> *lanes,
+            std::complex<float> step) {
+  float *laneF = reinterpret_cast<float *>(lanes);
+  __m256 p0 = _mm256_loadu_ps(laneF);
+  __m256 p1 = _mm256_loadu_ps(laneF + 8);
+  const float sr = step.real(), si = step.imag();
+  __m256 rot = _mm256_setr_ps(sr, si, sr, si, sr, si, sr, si);
+
+  const float *src = reinterpret_cast<const float *>(in);
+  float *dst = reinterpret_cast<float *>(out);
+  for (size_t i = 0; i < numSamples; i += 8, dst += 16) {
+    if (src) {
+      _mm256_storeu_ps(dst, cmul(_mm256_loadu_ps(src), p0));
+      _mm256_storeu_ps(dst + 8, cmul(_mm256_loadu_ps(src + 8), p1));
+      src += 16;
+    } else {
+      _mm256_storeu_ps(dst, p0);
+      _mm256_storeu_ps(dst + 8, p1);
+    }
+    p0 = cmul(p0, rot);
+    p1 = cmul(p1, rot);
+  }
+
+  _mm256_storeu_ps(laneF, p0);
+  _mm256_storeu_ps(laneF + 8, p1);
+}
+#elif defined(__ARM_NEON)
+void rotate(const std::complex<float> *in, std::complex<float> *out,
+            size_t numSamples, std::complex<float> *lanes,
+            std::complex<float> step) {
+  float *laneF = reinterpret_cast<float *>(lanes);
+  // Deinterleaved: val[0] = real parts, val[1] = imaginary parts.
+  float32x4x2_t p0 = vld2q_f32(laneF);
+  float32x4x2_t p1 = vld2q_f32(laneF + 8);
+  const float sr = step.real(), si = step.imag();
+
+  auto cmul = [](float32x4x2_t a, float32x4x2_t b) {
+    float32x4x2_t r;
+    r.val[0] = vmlsq_f32(vmulq_f32(a.val[0], b.val[0]), a.val[1], b.val[1]);
+    r.val[1] = vmlaq_f32(vmulq_f32(a.val[0], b.val[1]), a.val[1], b.val[0]);
+    return r;
+  };
+  auto rot = [=](float32x4x2_t a) {
+    float32x4x2_t r;
+    r.val[0] = vmlsq_n_f32(vmulq_n_f32(a.val[0], sr), a.val[1], si);
+    r.val[1] = vmlaq_n_f32(vmulq_n_f32(a.val[0], si), a.val[1], sr);
+    return r;
+  };
+
+  const float *src = reinterpret_cast<const float *>(in);
+  float *dst = reinterpret_cast<float *>(out);
+  for (size_t i = 0; i < numSamples; i += 8, dst += 16) {
+    if (src) {
+      vst2q_f32(dst, cmul(vld2q_f32(src), p0));
+      vst2q_f32(dst + 8, cmul(vld2q_f32(src + 8), p1));
+      src += 16;
+    } else {
+      vst2q_f32(dst, p0);
+      vst2q_f32(dst + 8, p1);
+    }
+    p0 = rot(p0);
+    p1 = rot(p1);
+  }
+
+  vst2q_f32(laneF, p0);
+  vst2q_f32(laneF + 8, p1);
+}
+#else
+void rotate(const std::complex<float> *in, std::complex<float> *out,
+            size_t numSamples, std::complex<float> *lanes,
+            std::complex<float> step) {
+  // Plain real arithmetic; std::complex operator* drags in the inf/nan
+  // checks and kills auto-vectorization.
+  float pr[NCO::LANES], pi[NCO::LANES];
+  for (size_t k = 0; k < NCO::LANES; k++) {
+    pr[k] = lanes[k].real();
+    pi[k] = lanes[k].imag();
+  }
+  const float sr = step.real(), si = step.imag();
+
+  for (size_t i = 0; i < numSamples; i += NCO::LANES) {
+    for (size_t k = 0; k < NCO::LANES; k++) {
+      float outR = pr[k], outI = pi[k];
+      if (in) {
+        float xr = in[i + k].real(), xi = in[i + k].imag();
+        outR = xr * pr[k] - xi * pi[k];
+        outI = xr * pi[k] + xi * pr[k];
+      }
+      out[i + k] = {outR, outI};
+
+      float nr = pr[k] * sr - pi[k] * si;
+      pi[k] = pr[k] * si + pi[k] * sr;
+      pr[k] = nr;
+    }
+  }
+
+  for (size_t k = 0; k < NCO::LANES; k++)
+    lanes[k] = {pr[k], pi[k]};
+}
+#endif
+} // namespace
+
+NCO::NCO(double freq, double sampleRate, double initialPhase) {
+  setFrequency(freq, sampleRate);
+  setPhase(initialPhase);
+}
+
+void NCO::setFrequency(double freq, double sampleRate) {
+  // Negative frequencies wrap around to the top of the accumulator range,
+  // which is exactly what two's complement phase arithmetic wants.
+  this->freq = freq;
+  phaseInc = radiansToAcc(TWO_PI * freq / sampleRate);
+  double w = (double)phaseInc * RAD_PER_LSB;
+  laneStep = {(float)std::cos(LANES * w), (float)std::sin(LANES * w)};
+}
+
+void NCO::setPhase(double radians) { phaseAcc = radiansToAcc(radians); }
+
+double NCO::phase() const { return (double)phaseAcc * RAD_PER_LSB; }
+
+void NCO::generate(std::complex<float> *out, size_t numSamples) {
+  process(nullptr, out, numSamples);
+}
+
+void NCO::mix(const std::complex<float> *in, std::complex<float> *out,
+              size_t numSamples) {
+  process(in, out, numSamples);
+}
+
+void NCO::process(const std::complex<float> *in, std::complex<float> *out,
+                  size_t numSamples) {
+  alignas(32) std::complex<float> lanes[LANES];
+
+  while (numSamples > 0) {
+    size_t chunk = std::min(numSamples, RESYNC_SAMPLES);
+
+    // Exact starting phasors for this chunk, straight from the accumulator.
+    for (size_t k = 0; k < LANES; k++) {
+      double phi = (double)(phaseAcc + k * phaseInc) * RAD_PER_LSB;
+      lanes[k] = {(float)std::cos(phi), (float)std::sin(phi)};
+    }
+
+    size_t body = chunk / LANES * LANES;
+    rotate(in, out, body, lanes, laneStep);
+
+    // Leftovers: lanes already holds the phasors for the next LANES samples.
+    for (size_t k = 0; body + k < chunk; k++)
+      out[body + k] = in ? in[body + k] * lanes[k] : lanes[k];
+
+    phaseAcc += chunk * phaseInc;
+    if (in)
+      in += chunk;
+    out += chunk;
+    numSamples -= chunk;
+  }
+}
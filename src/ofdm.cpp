@@ -0,0 +1,234 @@
+/*
+ * ofdm.cpp - OFDM modulator and demodulator over the constellation mappers.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "ofdm.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+using cf = std::complex<float>;
+
+// Data and pilot bins, each in ascending frequency.
+void splitBins(const std::vector<Subcarrier> &map, std::vector<uint32_t> &data,
+               std::vector<uint32_t> &pilots) {
+  const size_t n = map.size();
+  for (size_t i = 0; i < n; i++) {
+    const uint32_t bin = (uint32_t)((i + n / 2) % n); // Frequency i - n/2
+    if (map[bin] == Subcarrier::Data)
+      data.push_back(bin);
+    else if (map[bin] == Subcarrier::Pilot)
+      pilots.push_back(bin);
+  }
+}
+
+// Signed frequency of a bin, in bins.
+long binFrequency(uint32_t bin, size_t n) {
+  return bin < n / 2 ? (long)bin : (long)bin - (long)n;
+}
+
+// +-1 from 802.11's x^7 + x^4 + 1 scrambler, all ones to start.
+std::vector<cf> pilotSequence(size_t count) {
+  std::vector<cf> values(count);
+  unsigned state = 0x7F;
+  for (cf &v : values) {
+    const unsigned bit = ((state >> 6) ^ (state >> 3)) & 1;
+    state = ((state << 1) | bit) & 0x7F;
+    v = bit ? -1.0f : 1.0f;
+  }
+  return values;
+}
+
+size_t prefixLength(const OfdmSettings &settings) {
+  return settings.cyclicPrefix == OfdmSettings::AUTO ? settings.fftSize / 4
+                                                     : settings.cyclicPrefix;
+}
+} // namespace
+
+bool makeCarrierMap(const OfdmSettings &settings, std::vector<Subcarrier> &map) {
+  const size_t n = settings.fftSize;
+  if (n < 4 || !FftPlan::validSize(n))
+    return false;
+  map.assign(n, Subcarrier::Null);
+
+  if (!settings.map.empty()) {
+    if (settings.map.size() != n)
+      return false;
+    for (size_t i = 0; i < n; i++) {
+      Subcarrier &bin = map[(i + n / 2) % n];
+      switch (settings.map[i]) {
+      case 'd': bin = Subcarrier::Data; break;
+      case 'p': bin = Subcarrier::Pilot; break;
+      case '-': bin = Subcarrier::Null; break;
+      default: return false;
+      }
+    }
+  } else {
+    const size_t guard =
+        settings.guard == OfdmSettings::AUTO ? n * 5 / 64 : settings.guard;
+    if (guard + 1 >= n / 2)
+      return false;
+    const long edge = (long)(n / 2 - guard); // Used: 0 < |f| < edge
+    size_t used = 0;
+    for (long f = -edge + 1; f < edge; f++) {
+      if (f == 0)
+        continue;
+      const size_t spacing = settings.pilotSpacing;
+      const bool pilot = spacing > 0 && used % spacing == spacing / 2;
+      map[(size_t)(f + (long)n) % n] =
+          pilot ? Subcarrier::Pilot : Subcarrier::Data;
+      used++;
+    }
+  }
+  return std::count(map.begin(), map.end(), Subcarrier::Data) > 0;
+}
+
+// *** === OfdmModulator === ***
+OfdmModulator::OfdmModulator(const OfdmSettings &settings, Modulation mod)
+    : n(settings.fftSize), cp(prefixLength(settings)), mod(mod),
+      fft(FftPlan::cached(settings.fftSize)) {
+  std::vector<Subcarrier> map;
+  makeCarrierMap(settings, map);
+  splitBins(map, dataBins, pilotBins);
+  scale = 1.0f / std::sqrt((float)usedCarriers());
+
+  points.resize(BATCH * dataCarriers());
+  bins.assign(BATCH * n, 0.0f);
+  const std::vector<cf> pilots = pilotSequence(pilotBins.size());
+  for (size_t s = 0; s < BATCH; s++)
+    for (size_t p = 0; p < pilotBins.size(); p++)
+      bins[s * n + pilotBins[p]] = pilots[p] * scale;
+  pending.reserve(dataCarriers());
+}
+
+void OfdmModulator::modulateWhole(const uint8_t *labels, size_t numSyms,
+                                  cf *out) {
+  const size_t dc = dataCarriers(), len = symbolLength();
+  for (size_t s0 = 0; s0 < numSyms; s0 += BATCH) {
+    const size_t count = std::min(BATCH, numSyms - s0);
+    withMapper(mod, [&](auto mapper) {
+      mapper.map(labels + s0 * dc, count * dc, points.data());
+    });
+    for (size_t s = 0; s < count; s++) {
+      cf *b = bins.data() + s * n;
+      const cf *p = points.data() + s * dc;
+      for (size_t j = 0; j < dc; j++)
+        b[dataBins[j]] = p[j] * scale;
+    }
+    cf *o = out + s0 * len;
+    fft.inverse(bins.data(), o + cp, count, n, len);
+    for (size_t s = 0; s < count; s++)
+      std::copy(o + s * len + n, o + s * len + n + cp, o + s * len);
+  }
+}
+
+size_t OfdmModulator::modulate(const uint8_t *labels, size_t numLabels,
+                               cf *out) {
+  const size_t dc = dataCarriers();
+  size_t used = 0, written = 0;
+  if (!pending.empty()) {
+    used = std::min(dc - pending.size(), numLabels);
+    pending.insert(pending.end(), labels, labels + used);
+    if (pending.size() < dc)
+      return 0;
+    modulateWhole(pending.data(), 1, out);
+    pending.clear();
+    written = symbolLength();
+  }
+  const size_t whole = (numLabels - used) / dc;
+  modulateWhole(labels + used, whole, out + written);
+  written += whole * symbolLength();
+  used += whole * dc;
+  pending.assign(labels + used, labels + numLabels);
+  return written;
+}
+
+size_t OfdmModulator::flush(cf *out) {
+  if (pending.empty())
+    return 0;
+  pending.resize(dataCarriers(), 0);
+  modulateWhole(pending.data(), 1, out);
+  pending.clear();
+  return symbolLength();
+}
+
+// *** === OfdmDemodulator === ***
+OfdmDemodulator::OfdmDemodulator(const OfdmSettings &settings)
+    : n(settings.fftSize), cp(prefixLength(settings)),
+      fft(FftPlan::cached(settings.fftSize)) {
+  std::vector<Subcarrier> map;
+  makeCarrierMap(settings, map);
+  splitBins(map, dataBins, pilotBins);
+  scale = std::sqrt((float)(dataBins.size() + pilotBins.size())) / (float)n;
+  pilotValues = pilotSequence(pilotBins.size());
+
+  // Both lists ascend in frequency, so one pass finds the neighbours.
+  size_t p = 0;
+  for (uint32_t bin : dataBins) {
+    const long f = binFrequency(bin, n);
+    while (p < pilotBins.size() && binFrequency(pilotBins[p], n) < f)
+      p++;
+    const size_t below = p > 0 ? p - 1 : 0;
+    const size_t above = p < pilotBins.size() ? p : pilotBins.size() - 1;
+    const long fb = binFrequency(pilotBins.empty() ? 0 : pilotBins[below], n);
+    const long fa = binFrequency(pilotBins.empty() ? 0 : pilotBins[above], n);
+    left.push_back((uint32_t)below);
+    right.push_back((uint32_t)above);
+    frac.push_back(fa > fb && f > fb ? (float)(f - fb) / (float)(fa - fb)
+                                     : 0.0f);
+  }
+
+  bins.resize(BATCH * n);
+  gains.resize(pilotBins.size());
+  partial.reserve(symbolLength());
+}
+
+void OfdmDemodulator::demodulateWhole(const cf *in, size_t numSyms, cf *out) {
+  const size_t dc = dataCarriers(), len = symbolLength();
+  for (size_t s0 = 0; s0 < numSyms; s0 += BATCH) {
+    const size_t count = std::min(BATCH, numSyms - s0);
+    fft.forward(in + s0 * len + cp, bins.data(), count, len, n);
+    for (size_t s = 0; s < count; s++) {
+      const cf *b = bins.data() + s * n;
+      cf *o = out + (s0 + s) * dc;
+      if (pilotBins.empty()) {
+        for (size_t j = 0; j < dc; j++)
+          o[j] = b[dataBins[j]] * scale;
+        continue;
+      }
+      // The pilots are +-1, dividing by one is multiplying by it.
+      for (size_t p = 0; p < pilotBins.size(); p++)
+        gains[p] = b[pilotBins[p]] * pilotValues[p];
+      for (size_t j = 0; j < dc; j++) {
+        const cf h =
+            gains[left[j]] * (1.0f - frac[j]) + gains[right[j]] * frac[j];
+        const float power = std::norm(h);
+        o[j] = power > 0.0f ? b[dataBins[j]] * std::conj(h) / power : 0.0f;
+      }
+    }
+  }
+}
+
+size_t OfdmDemodulator::demodulate(const cf *in, size_t numSamps, cf *out) {
+  const size_t len = symbolLength();
+  size_t used = 0, written = 0;
+  if (!partial.empty()) {
+    used = std::min(len - partial.size(), numSamps);
+    partial.insert(partial.end(), in, in + used);
+    if (partial.size() < len)
+      return 0;
+    demodulateWhole(partial.data(), 1, out);
+    partial.clear();
+    written = dataCarriers();
+  }
+  const size_t whole = (numSamps - used) / len;
+  demodulateWhole(in + used, whole, out + written);
+  written += whole * dataCarriers();
+  used += whole * len;
+  partial.assign(in + used, in + numSamps);
+  return written;
+}
@@ -0,0 +1,212 @@
+/*
+ * output_handler.cpp - Persistent, buffered IQ sink.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "output_handler.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+OutputHandler::OutputHandler(const std::string &filename, size_t bufferBytes,
+                             FlushPolicy policy, bool append)
+    : filename(filename), policy(policy) {
+  int flags = O_WRONLY | O_CREAT | (append ? O_APPEND : O_TRUNC);
+  fd = open(filename.c_str(), flags, 0644);
+  if (fd < 0) {
+    fprintf(stderr, "%s could not be opened! (%s)\n", filename.c_str(),
+            strerror(errno));
+    return;
+  }
+
+  // Round up to whole pages so every full flush is a page multiple. That is
+  // whole samples too: a page holds a whole number of every format's (2, 4
+  // or 8 bytes).
+  static_assert(BUFFER_ALIGNMENT % sizeof(std::complex<float>) == 0);
+  capacity = (bufferBytes + BUFFER_ALIGNMENT - 1) & ~(BUFFER_ALIGNMENT - 1);
+  if (capacity == 0)
+    capacity = BUFFER_ALIGNMENT;
+
+  void *mem = nullptr;
+  if (posix_memalign(&mem, BUFFER_ALIGNMENT, capacity) != 0) {
+    fprintf(stderr, "Could not allocate a %zu byte staging buffer for %s\n",
+            capacity, filename.c_str());
+    ::close(fd);
+    fd = -1;
+    return;
+  }
+  buffer = static_cast<char *>(mem);
+}
+
+OutputHandler::~OutputHandler() {
+  close();
+  free(buffer);
+}
+
+int OutputHandler::writeToFile(
+    const std::vector<std::complex<float>> &iqSamples) {
+  return writeToFile(iqSamples.data(), iqSamples.size());
+}
+
+int OutputHandler::writeToFile(const std::complex<float> *iqSamples,
+                               size_t numSamples) {
+  if (!isOpen())
+    return 1;
+
+  // std::complex<float> is guaranteed to be laid out as float[2] = {I, Q},
+  // which is exactly interleaved cf32. No per-sample unpacking needed.
+  if (stage(reinterpret_cast<const char *>(iqSamples),
+            numSamples * sizeof(std::complex<float>)) != 0)
+    return 1;
+  return endOfWrite();
+}
+
+int OutputHandler::writeBytes(const void *data, size_t numBytes) {
+  if (!isOpen())
+    return 1;
+  if (stage(static_cast<const char *>(data), numBytes) != 0)
+    return 1;
+  return endOfWrite();
+}
+
+int OutputHandler::writeViews(const std::span<const std::complex<float>> *views,
+                              size_t numViews) {
+  if (!isOpen())
+    return 1;
+  if (numViews == 0)
+    return 0;
+
+  size_t numBytes = 0;
+  for (size_t v = 0; v < numViews; v++)
+    numBytes += views[v].size_bytes();
+
+  // Lots of tiny views: a memcpy each into the staging buffer is cheaper
+  // than making the kernel walk a long iovec list.
+  if (numBytes / numViews < WRITEV_MIN_BYTES) {
+    for (size_t v = 0; v < numViews; v++)
+      if (stage(reinterpret_cast<const char *>(views[v].data()),
+                views[v].size_bytes()) != 0)
+        return 1;
+    return endOfWrite();
+  }
+
+  // Anything already staged has to go out first to keep the stream in order.
+  if (flush() != 0)
+    return 1;
+
+  struct iovec iov[IOV_MAX_BATCH];
+  for (size_t v = 0; v < numViews;) {
+    size_t batch = std::min(numViews - v, IOV_MAX_BATCH);
+    for (size_t b = 0; b < batch; b++, v++) {
+      iov[b].iov_base = const_cast<std::complex<float> *>(views[v].data());
+      iov[b].iov_len = views[v].size_bytes();
+    }
+    if (writevAll(iov, batch) != 0)
+      return 1;
+  }
+  return (policy == FlushPolicy::Sync) ? (fdatasync(fd) != 0) : 0;
+}
+
+int OutputHandler::stage(const char *data, size_t numBytes) {
+  if (used + numBytes > capacity) {
+    if (flush() != 0)
+      return 1;
+    // Blocks at least as large as the staging buffer go straight out in one
+    // call; copying them first would only cost us a memcpy.
+    if (numBytes >= capacity) {
+      if (writeAll(data, numBytes) != 0)
+        return 1;
+      return (policy == FlushPolicy::Sync) ? (fdatasync(fd) != 0) : 0;
+    }
+  }
+
+  memcpy(buffer + used, data, numBytes);
+  used += numBytes;
+  return (used == capacity) ? flush() : 0;
+}
+
+int OutputHandler::endOfWrite() {
+  return (policy == FlushPolicy::EveryWrite) ? flush() : 0;
+}
+
+int OutputHandler::flush() {
+  if (!isOpen())
+    return 1;
+  if (used == 0)
+    return 0;
+
+  int ret = writeAll(buffer, used);
+  used = 0;
+  if (ret == 0 && policy == FlushPolicy::Sync && fdatasync(fd) != 0) {
+    fprintf(stderr, "fdatasync on %s failed! (%s)\n", filename.c_str(),
+            strerror(errno));
+    return 1;
+  }
+  return ret;
+}
+
+int OutputHandler::close() {
+  if (!isOpen())
+    return 0;
+
+  int ret = flush();
+  if (::close(fd) != 0)
+    ret = 1;
+  fd = -1;
+  return ret;
+}
+
+int OutputHandler::writeAll(const char *data, size_t numBytes) {
+  // write(2) may return short counts (pipes, signals); keep going until the
+  // whole block is out.
+  while (numBytes > 0) {
+    ssize_t n = ::write(fd, data, numBytes);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      fprintf(stderr,
+              "Not all samples written to file %s. (%zu bytes left: %s)\n",
+              filename.c_str(), numBytes, strerror(errno));
+      return 1;
+    }
+    data += n;
+    numBytes -= n;
+    totalBytes += n;
+  }
+  return 0;
+}
+
+int OutputHandler::writevAll(struct iovec *iov, size_t iovCount) {
+  while (iovCount > 0) {
+    ssize_t n = ::writev(fd, iov, (int)iovCount);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      fprintf(stderr, "writev to %s failed! (%s)\n", filename.c_str(),
+              strerror(errno));
+      return 1;
+    }
+    totalBytes += n;
+
+    // Short write: skip the iovecs that made it out and trim the partial one.
+    size_t done = n;
+    while (iovCount > 0 && done >= iov->iov_len) {
+      done -= iov->iov_len;
+      iov++;
+      iovCount--;
+    }
+    if (iovCount > 0) {
+      iov->iov_base = static_cast<char *>(iov->iov_base) + done;
+      iov->iov_len -= done;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,197 @@
+/*
+ * packet.cpp - Length delimited, CRC checked packets over the frame bodies.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "packet.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace {
+using Tables16 = std::array<std::array<uint16_t, 256>, 8>;
+using Tables32 = std::array<std::array<uint32_t, 256>, 8>;
+
+// t[0] is the byte at a time table; t[s][i] is byte i followed by s zeros.
+constexpr Tables16 CRC16 = [] {
+  Tables16 t{};
+  for (unsigned i = 0; i < 256; i++) {
+    uint16_t c = (uint16_t)(i << 8);
+    for (int k = 0; k < 8; k++)
+      c = (uint16_t)((c & 0x8000) ? (c << 1) ^ 0x1021 : c << 1);
+    t[0][i] = c;
+  }
+  for (unsigned s = 1; s < 8; s++)
+    for (unsigned i = 0; i < 256; i++)
+      t[s][i] = (uint16_t)((t[s - 1][i] << 8) ^ t[0][t[s - 1][i] >> 8]);
+  return t;
+}();
+
+constexpr Tables32 CRC32 = [] {
+  Tables32 t{};
+  for (unsigned i = 0; i < 256; i++) {
+    uint32_t c = i;
+    for (int k = 0; k < 8; k++)
+      c = (c & 1) ? (c >> 1) ^ 0xEDB88320u : c >> 1;
+    t[0][i] = c;
+  }
+  for (unsigned s = 1; s < 8; s++)
+    for (unsigned i = 0; i < 256; i++)
+      t[s][i] = (t[s - 1][i] >> 8) ^ t[0][t[s - 1][i] & 0xff];
+  return t;
+}();
+
+static_assert(CRC16[0][1] == 0x1021 && CRC32[0][128] == 0xEDB88320u);
+
+uint32_t load32le(const uint8_t *p) {
+  return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 |
+         (uint32_t)p[3] << 24;
+}
+
+uint16_t load16be(const uint8_t *p) { return (uint16_t)(p[0] << 8 | p[1]); }
+
+void store16be(uint8_t *p, uint16_t v) {
+  p[0] = (uint8_t)(v >> 8);
+  p[1] = (uint8_t)v;
+}
+} // namespace
+
+// *** === CRC === ***
+uint16_t crc::crc16(const uint8_t *data, size_t n, uint16_t crc) {
+  const Tables16 &t = CRC16;
+  uint16_t c = crc;
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const uint8_t *p = data + i;
+    c ^= load16be(p);
+    c = t[7][c >> 8] ^ t[6][c & 0xff] ^ t[5][p[2]] ^ t[4][p[3]] ^
+        t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+  }
+  for (; i < n; i++)
+    c = (uint16_t)((c << 8) ^ t[0][(c >> 8) ^ data[i]]);
+  return c;
+}
+
+uint32_t crc::crc32(const uint8_t *data, size_t n, uint32_t crc) {
+  const Tables32 &t = CRC32;
+  uint32_t c = ~crc;
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const uint32_t lo = load32le(data + i) ^ c;
+    const uint32_t hi = load32le(data + i + 4);
+    c = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^ t[5][(lo >> 16) & 0xff] ^
+        t[4][lo >> 24] ^ t[3][hi & 0xff] ^ t[2][(hi >> 8) & 0xff] ^
+        t[1][(hi >> 16) & 0xff] ^ t[0][hi >> 24];
+  }
+  for (; i < n; i++)
+    c = (c >> 8) ^ t[0][(c ^ data[i]) & 0xff];
+  return ~c;
+}
+
+// *** === Packetizer === ***
+size_t Packetizer::seal(uint8_t *packet, size_t payloadBytes) const {
+  store16be(packet, packet::SYNC);
+  store16be(packet + 2, (uint16_t)payloadBytes);
+  store16be(packet + 4, crc::crc16(packet, 4));
+  const size_t covered = packet::HEADER_BYTES - 2 + payloadBytes;
+  uint8_t *end = packet + packet::HEADER_BYTES + payloadBytes;
+  if (settings.crcBits == 16) {
+    store16be(end, crc::crc16(packet + 2, covered));
+  } else {
+    const uint32_t c = crc::crc32(packet + 2, covered);
+    store16be(end, (uint16_t)(c >> 16));
+    store16be(end + 2, (uint16_t)c);
+  }
+  return packet::HEADER_BYTES + payloadBytes + settings.crcBytes();
+}
+
+// *** === Deframer === ***
+size_t Deframer::header(const uint8_t *p) const {
+  if (load16be(p) != packet::SYNC || crc::crc16(p, 4) != load16be(p + 4))
+    return 0;
+  return packet::HEADER_BYTES + load16be(p + 2) + settings.crcBytes();
+}
+
+void Deframer::accept(const uint8_t *p, size_t total,
+                      std::vector<std::span<const uint8_t>> &payloads) {
+  const size_t crcBytes = settings.crcBytes();
+  const size_t length = total - packet::HEADER_BYTES - crcBytes;
+  const size_t covered = total - 2 - crcBytes;
+  const uint8_t *end = p + total - crcBytes;
+  const bool good =
+      crcBytes == 2
+          ? crc::crc16(p + 2, covered) == load16be(end)
+          : crc::crc32(p + 2, covered) ==
+                ((uint32_t)load16be(end) << 16 | load16be(end + 2));
+  if (!good) {
+    numFailed++;
+    return;
+  }
+  payloads.emplace_back(p + packet::HEADER_BYTES, length);
+  numPackets++;
+  numPayload += length;
+}
+
+size_t Deframer::parse(const uint8_t *p, size_t at, size_t n,
+                       std::vector<std::span<const uint8_t>> &payloads) {
+  const uint8_t first = packet::SYNC >> 8;
+  while (at + packet::HEADER_BYTES <= n) {
+    if (p[at] != first) {
+      const void *hit = std::memchr(p + at, first, n - at);
+      const size_t next =
+          hit ? (size_t)(static_cast<const uint8_t *>(hit) - p) : n;
+      numSkipped += next - at;
+      at = next;
+      continue;
+    }
+    const size_t total = header(p + at);
+    if (total == 0) {
+      numSkipped++;
+      at++;
+      continue;
+    }
+    if (at + total > n)
+      break; // Comes together next call
+    accept(p + at, total, payloads);
+    at += total;
+  }
+  return at;
+}
+
+void Deframer::process(const uint8_t *bytes, size_t n,
+                       std::vector<std::span<const uint8_t>> &payloads) {
+  payloads.clear();
+  // First the packet the last call left unfinished, taking only as much of
+  // bytes as it needs, so that all the rest is looked at in place.
+  size_t at = 0;
+  while (!tail.empty()) {
+    size_t need = packet::HEADER_BYTES;
+    if (tail.size() >= need) {
+      need = header(tail.data());
+      if (need == 0) {
+        // Not a packet after all; on from its next possible sync.
+        const auto next =
+            std::find(tail.begin() + 1, tail.end(), packet::SYNC >> 8);
+        numSkipped += next - tail.begin();
+        tail.erase(tail.begin(), next);
+        continue;
+      }
+    }
+    if (tail.size() < need) {
+      if (at == n)
+        return; // All of bytes went into it
+      const size_t take = std::min(need - tail.size(), n - at);
+      tail.insert(tail.end(), bytes + at, bytes + at + take);
+      at += take;
+      continue;
+    }
+    joined.swap(tail);
+    tail.clear();
+    accept(joined.data(), joined.size(), payloads);
+  }
+  const size_t end = parse(bytes, at, n, payloads);
+  tail.assign(bytes + end, bytes + n);
+}
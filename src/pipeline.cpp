@@ -0,0 +1,31 @@
+/*
+ * pipeline.cpp - Block pipeline: fused in one thread or one thread per stage.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "pipeline.h"
+
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+
+int pinThisThread(int cpu) {
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+  if (err != 0) {
+    fprintf(stderr, "Could not pin thread to CPU %d (%s)\n", cpu,
+            strerror(err));
+    return 1;
+  }
+  return 0;
+#else
+  (void)cpu;
+  fprintf(stderr, "CPU pinning is only supported on Linux.\n");
+  return 1;
+#endif
+}
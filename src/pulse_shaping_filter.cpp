@@ -0,0 +1,239 @@
+/*
+ * pulse_shaping_filter.cpp - RRC/RC pulse design and polyphase interpolator.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "pulse_shaping_filter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+constexpr double PI_D = 3.141592653589793;
+constexpr size_t VEC_FLOATS = 8; // Row padding, one AVX register
+
+double rrc(double t, double beta) {
+  if (t == 0.0)
+    return 1.0 - beta + 4.0 * beta / PI_D;
+  if (beta > 0.0 && std::abs(std::abs(t) - 1.0 / (4.0 * beta)) < 1e-9)
+    return beta / std::sqrt(2.0) *
+           ((1.0 + 2.0 / PI_D) * std::sin(PI_D / (4.0 * beta)) +
+            (1.0 - 2.0 / PI_D) * std::cos(PI_D / (4.0 * beta)));
+  double num = std::sin(PI_D * t * (1.0 - beta)) +
+               4.0 * beta * t * std::cos(PI_D * t * (1.0 + beta));
+  double den = PI_D * t * (1.0 - (4.0 * beta * t) * (4.0 * beta * t));
+  return num / den;
+}
+
+double rc(double t, double beta) {
+  auto sinc = [](double x) {
+    return (x == 0.0) ? 1.0 : std::sin(PI_D * x) / (PI_D * x);
+  };
+  if (beta > 0.0 && std::abs(std::abs(t) - 1.0 / (2.0 * beta)) < 1e-9)
+    return PI_D / 4.0 * sinc(1.0 / (2.0 * beta));
+  return sinc(t) * std::cos(PI_D * beta * t) /
+         (1.0 - (2.0 * beta * t) * (2.0 * beta * t));
+}
+
+double window(Window w, size_t n, size_t len) {
+  if (len < 2)
+    return 1.0;
+  double x = 2.0 * PI_D * n / (len - 1);
+  switch (w) {
+  case Window::Hamming:
+    return 0.54 - 0.46 * std::cos(x);
+  case Window::Hann:
+    return 0.5 - 0.5 * std::cos(x);
+  case Window::Blackman:
+    return 0.42 - 0.5 * std::cos(x) + 0.08 * std::cos(2.0 * x);
+  case Window::Rectangular:
+  default:
+    return 1.0;
+  }
+}
+
+// acc[0 .. rowWidth) = sum_k rows[k] * {xr, xi, xr, xi, ...} with x = hist[-k]
+void polyphaseRow(const float *rows, size_t numRows, size_t rowWidth,
+                  const std::complex<float> *newest, float *acc) {
+#if defined(__AVX2__)
+  for (size_t c = 0; c < rowWidth; c += 8) {
+    __m256 sum = _mm256_setzero_ps();
+    for (size_t k = 0; k < numRows; k++) {
+      __m256 x = _mm256_castpd_ps(
+          _mm256_broadcast_sd(reinterpret_cast<const double *>(newest - k)));
+      __m256 h = _mm256_loadu_ps(rows + k * rowWidth + c);
+#if defined(__FMA__)
+      sum = _mm256_fmadd_ps(h, x, sum);
+#else
+      sum = _mm256_add_ps(sum, _mm256_mul_ps(h, x));
+#endif
+    }
+    _mm256_storeu_ps(acc + c, sum);
+  }
+#elif defined(__ARM_NEON)
+  for (size_t c = 0; c < rowWidth; c += 4) {
+    float32x4_t sum = vdupq_n_f32(0.0f);
+    for (size_t k = 0; k < numRows; k++) {
+      float32x2_t xp = vld1_f32(reinterpret_cast<const float *>(newest - k));
+      sum = vmlaq_f32(sum, vld1q_f32(rows + k * rowWidth + c),
+                      vcombine_f32(xp, xp));
+    }
+    vst1q_f32(acc + c, sum);
+  }
+#else
+  std::fill(acc, acc + rowWidth, 0.0f);
+  for (size_t k = 0; k < numRows; k++) {
+    const float xr = newest[-(ptrdiff_t)k].real();
+    const float xi = newest[-(ptrdiff_t)k].imag();
+    const float *row = rows + k * rowWidth;
+    for (size_t c = 0; c < rowWidth; c += 2) {
+      acc[c] += row[c] * xr;
+      acc[c + 1] += row[c + 1] * xi;
+    }
+  }
+#endif
+}
+} // namespace
+
+std::vector<float> designPulse(PulseShape shape, float rollOff, double sps,
+                               size_t spanSymbols, Window w) {
+  size_t numTaps = (size_t)(spanSymbols * sps) + 1;
+  if (sps != std::floor(sps))
+    numTaps |= 1;
+  std::vector<float> h(numTaps);
+  double centre = (numTaps - 1) / 2.0;
+
+  double energy = 0.0;
+  for (size_t n = 0; n < numTaps; n++) {
+    double t = (n - centre) / sps; // In symbols
+    double v = (shape == PulseShape::RootRaisedCosine) ? rrc(t, rollOff)
+                                                       : rc(t, rollOff);
+    v *= window(w, n, numTaps);
+    h[n] = (float)v;
+    energy += v * v;
+  }
+
+  if (shape == PulseShape::RootRaisedCosine) {
+    float scale = (float)std::sqrt(sps / energy);
+    for (float &tap : h)
+      tap *= scale;
+  } else {
+    float scale = 1.0f / h[numTaps / 2];
+    for (float &tap : h)
+      tap *= scale;
+  }
+  return h;
+}
+
+PulseShapingFilter::PulseShapingFilter(float rollOffFactor,
+                                       size_t samplesPerSymbol,
+                                       size_t spanSymbols, PulseShape shape,
+                                       Window window, size_t decimation)
+    : filterCoefficients(designPulse(shape, rollOffFactor, samplesPerSymbol,
+                                     spanSymbols, window)),
+      sps(samplesPerSymbol), decim(std::max<size_t>(decimation, 1)) {
+  numPhaseTaps = (filterCoefficients.size() + sps - 1) / sps;
+
+  if (decim > 1) {
+    // Row p holds h[p + k*L] for k = 0 .. P-1.
+    phaseTaps.assign(sps * numPhaseTaps, 0.0f);
+    for (size_t p = 0; p < sps; p++)
+      for (size_t k = 0; k < numPhaseTaps; k++) {
+        size_t n = p + k * sps;
+        if (n < filterCoefficients.size())
+          phaseTaps[p * numPhaseTaps + k] = filterCoefficients[n];
+      }
+    reset();
+    return;
+  }
+
+  rowWidth = (2 * sps + VEC_FLOATS - 1) / VEC_FLOATS * VEC_FLOATS;
+
+  // Row k, phase p holds h[p + k*sps] twice (for I and Q); padding is zero.
+  phaseRows.assign(numPhaseTaps * rowWidth, 0.0f);
+  for (size_t k = 0; k < numPhaseTaps; k++) {
+    for (size_t p = 0; p < sps; p++) {
+      size_t n = p + k * sps;
+      float tap = (n < filterCoefficients.size()) ? filterCoefficients[n] : 0;
+      phaseRows[k * rowWidth + 2 * p] = tap;
+      phaseRows[k * rowWidth + 2 * p + 1] = tap;
+    }
+  }
+
+  scratch.resize(rowWidth);
+  reset();
+}
+
+void PulseShapingFilter::reset() {
+  work.assign(numPhaseTaps - 1, {0.0f, 0.0f});
+  phaseAcc = 0;
+}
+
+size_t PulseShapingFilter::interpolate(const std::complex<float> *symbols,
+                                       size_t numSymbols,
+                                       std::complex<float> *out) {
+  const size_t histLen = numPhaseTaps - 1;
+  work.resize(histLen + numSymbols);
+  std::copy(symbols, symbols + numSymbols, work.begin() + histLen);
+
+  if (decim > 1) {
+    size_t numSamps = interpolateRational(work.data() + histLen, numSymbols,
+                                          out);
+    std::copy(work.end() - histLen, work.end(), work.begin());
+    work.resize(histLen);
+    return numSamps;
+  }
+
+  float *dst = reinterpret_cast<float *>(out);
+  const bool padded = rowWidth != 2 * sps;
+  for (size_t n = 0; n < numSymbols; n++, dst += 2 * sps) {
+    const std::complex<float> *newest = work.data() + histLen + n;
+    if (padded) {
+      polyphaseRow(phaseRows.data(), numPhaseTaps, rowWidth, newest,
+                   scratch.data());
+      memcpy(dst, scratch.data(), 2 * sps * sizeof(float));
+    } else {
+      polyphaseRow(phaseRows.data(), numPhaseTaps, rowWidth, newest, dst);
+    }
+  }
+
+  // Keep the newest P-1 symbols around for the next call.
+  std::copy(work.end() - histLen, work.end(), work.begin());
+  work.resize(histLen);
+  return numSymbols * sps;
+}
+
+// Every output sample is one P-tap dot product against the newest P symbols.
+size_t PulseShapingFilter::interpolateRational(
+    const std::complex<float> *newest, size_t numSymbols,
+    std::complex<float> *out) {
+  const size_t P = numPhaseTaps;
+  size_t numSamps = 0;
+  for (size_t n = 0; n < numSymbols; n++, newest++) {
+    for (; phaseAcc < sps; phaseAcc += decim) {
+      const float *h = phaseTaps.data() + phaseAcc * P;
+      float re = 0.0f, im = 0.0f;
+      for (size_t k = 0; k < P; k++) {
+        re += h[k] * newest[-(ptrdiff_t)k].real();
+        im += h[k] * newest[-(ptrdiff_t)k].imag();
+      }
+      out[numSamps++] = {re, im};
+    }
+    phaseAcc -= sps;
+  }
+  return numSamps;
+}
+
+size_t PulseShapingFilter::flush(std::complex<float> *out) {
+  std::vector<std::complex<float>> zeros(numPhaseTaps - 1);
+  return interpolate(zeros.data(), zeros.size(), out);
+}
@@ -0,0 +1,349 @@
+/*
+ * reed_solomon.cpp - CCSDS Reed-Solomon (255,223) codec with interleaving.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "reed_solomon.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+using namespace rs;
+
+namespace {
+constexpr unsigned FIELD_POLY = 0x187; // x^8 + x^7 + x^2 + x + 1
+constexpr unsigned FIRST_ROOT = 112;   // Roots alpha^(PRIM * (112 + j))
+constexpr unsigned PRIM = 11;
+constexpr unsigned IPRIM = 116;        // PRIM * IPRIM == 1 mod 255
+constexpr unsigned A0 = 255;           // log(0)
+constexpr unsigned MAX_ERRORS = NUM_PARITY / 2;
+
+// Conventional -> dual basis, one row per bit (CCSDS 131.0-B annex F).
+constexpr uint8_t DUAL_ROWS[8] = {0x8d, 0xef, 0xec, 0x86,
+                                  0xfa, 0x99, 0xaf, 0x7b};
+
+unsigned modnn(unsigned x) { return x % 255; }
+} // namespace
+
+ReedSolomon::ReedSolomon(bool dualBasis) : dual(dualBasis) {
+  // *** === Field === ***
+  unsigned x = 1;
+  for (unsigned i = 0; i < 255; i++) {
+    alphaTo[i] = (uint8_t)x;
+    indexOf[x] = (uint8_t)i;
+    x <<= 1;
+    if (x & 0x100)
+      x ^= FIELD_POLY;
+  }
+  alphaTo[A0] = 0;
+  indexOf[0] = A0;
+
+  for (unsigned v = 0; v < 256; v++) {
+    uint8_t d = 0;
+    for (unsigned bit = 0; bit < 8; bit++)
+      if (v & (1u << bit))
+        d ^= DUAL_ROWS[7 - bit];
+    toDual[v] = d;
+    fromDual[d] = (uint8_t)v;
+  }
+
+  auto mul = [&](unsigned a, unsigned b) -> uint8_t {
+    if (a == 0 || b == 0)
+      return 0;
+    return alphaTo[modnn(indexOf[a] + indexOf[b])];
+  };
+
+  // *** === Generator === ***
+  // Product of (x - root_j), poly form, g[0] the constant term.
+  uint8_t g[NUM_PARITY + 1] = {1};
+  for (unsigned j = 0, root = FIRST_ROOT * PRIM; j < NUM_PARITY;
+       j++, root += PRIM) {
+    g[j + 1] = 1;
+    for (unsigned i = j; i > 0; i--)
+      g[i] = g[i - 1] ^ mul(g[i], alphaTo[modnn(root)]);
+    g[0] = mul(g[0], alphaTo[modnn(root)]);
+  }
+
+  // The LFSR adds fb * g[NUM_PARITY - 1 - j] into register byte j.
+  for (unsigned fb = 0; fb < 256; fb++)
+    for (unsigned j = 0; j < NUM_PARITY; j++)
+      feedback[fb][j] = mul(fb, g[NUM_PARITY - 1 - j]);
+
+  // *** === Syndrome tables === ***
+  for (unsigned j = 0; j < NUM_PARITY; j++) {
+    const unsigned root = modnn(PRIM * (FIRST_ROOT + j));
+    for (unsigned p = 0; p < 6; p++) {
+      const uint8_t c = alphaTo[modnn(root << (5 - p))]; // root^(32 >> p)
+      for (unsigned n = 0; n < 16; n++) {
+        mulTables[j][p][n] = mul(c, n);
+        mulTables[j][p][16 + n] = mul(c, n << 4);
+      }
+    }
+  }
+}
+
+// *** === Encoder === ***
+void ReedSolomon::encodeStrided(uint8_t *codeword, size_t stride) const {
+  uint8_t reg[NUM_PARITY] = {};
+  for (size_t i = 0; i < K; i++) {
+    uint8_t d = codeword[i * stride];
+    const uint8_t *fb = feedback[(dual ? fromDual[d] : d) ^ reg[0]];
+    for (unsigned j = 0; j + 1 < NUM_PARITY; j++)
+      reg[j] = reg[j + 1] ^ fb[j];
+    reg[NUM_PARITY - 1] = fb[NUM_PARITY - 1];
+  }
+  for (unsigned j = 0; j < NUM_PARITY; j++)
+    codeword[(K + j) * stride] = dual ? toDual[reg[j]] : reg[j];
+}
+
+void ReedSolomon::encode(uint8_t *codeword) const {
+  encodeStrided(codeword, 1);
+}
+
+int ReedSolomon::encodeInterleaved(uint8_t *frame, unsigned depth) const {
+  if (depth < 1 || depth > MAX_INTERLEAVE) {
+    fprintf(stderr, "[ERROR] RS interleave depth %u (1 .. %u)\n", depth,
+            MAX_INTERLEAVE);
+    return 1;
+  }
+  for (unsigned i = 0; i < depth; i++)
+    encodeStrided(frame + i, depth);
+  return 0;
+}
+
+// *** === Syndromes === ***
+bool ReedSolomon::syndromes(const uint8_t *buf, uint8_t *s) const {
+  uint8_t raw[NUM_PARITY];
+#if defined(__AVX2__)
+  const __m256i nibble = _mm256_set1_epi8(0x0f);
+  __m256i blocks[8];
+  for (unsigned c = 0; c < 8; c++)
+    blocks[c] = _mm256_load_si256(reinterpret_cast<const __m256i *>(buf) + c);
+
+  for (unsigned j = 0; j < NUM_PARITY; j++) {
+    // t * x: both nibble tables sit in each 128 bit lane, as PSHUFB wants.
+    auto mul = [&](__m256i x, unsigned p) {
+      __m128i t = _mm_load_si128(
+          reinterpret_cast<const __m128i *>(mulTables[j][p]));
+      __m128i u = _mm_load_si128(
+          reinterpret_cast<const __m128i *>(mulTables[j][p] + 16));
+      __m256i lo = _mm256_broadcastsi128_si256(t);
+      __m256i hi = _mm256_broadcastsi128_si256(u);
+      __m256i xl = _mm256_and_si256(x, nibble);
+      __m256i xh = _mm256_and_si256(_mm256_srli_epi16(x, 4), nibble);
+      return _mm256_xor_si256(_mm256_shuffle_epi8(lo, xl),
+                              _mm256_shuffle_epi8(hi, xh));
+    };
+    __m256i a = blocks[0];
+    for (unsigned c = 1; c < 8; c++)
+      a = _mm256_xor_si256(mul(a, 0), blocks[c]);
+    // Fold 32 -> 16 lanes, then within the low 128 bits down to one.
+    a = _mm256_xor_si256(mul(a, 1), _mm256_permute2x128_si256(a, a, 0x81));
+    a = _mm256_xor_si256(mul(a, 2), _mm256_srli_si256(a, 8));
+    a = _mm256_xor_si256(mul(a, 3), _mm256_srli_si256(a, 4));
+    a = _mm256_xor_si256(mul(a, 4), _mm256_srli_si256(a, 2));
+    a = _mm256_xor_si256(mul(a, 5), _mm256_srli_si256(a, 1));
+    raw[j] = (uint8_t)_mm256_cvtsi256_si32(a);
+  }
+#elif defined(__ARM_NEON)
+  // Same, 16 byte blocks: Horner by b^16 and four folds.
+  const uint8x16_t nibble = vdupq_n_u8(0x0f);
+  const uint8x16_t zero = vdupq_n_u8(0);
+  for (unsigned j = 0; j < NUM_PARITY; j++) {
+    auto mul = [&](uint8x16_t x, unsigned p) {
+      uint8x16_t lo = vld1q_u8(mulTables[j][p]);
+      uint8x16_t hi = vld1q_u8(mulTables[j][p] + 16);
+      return veorq_u8(vqtbl1q_u8(lo, vandq_u8(x, nibble)),
+                      vqtbl1q_u8(hi, vshrq_n_u8(x, 4)));
+    };
+    uint8x16_t a = vld1q_u8(buf);
+    for (unsigned c = 1; c < 16; c++)
+      a = veorq_u8(mul(a, 1), vld1q_u8(buf + 16 * c));
+    a = veorq_u8(mul(a, 2), vextq_u8(a, zero, 8));
+    a = veorq_u8(mul(a, 3), vextq_u8(a, zero, 4));
+    a = veorq_u8(mul(a, 4), vextq_u8(a, zero, 2));
+    a = veorq_u8(mul(a, 5), vextq_u8(a, zero, 1));
+    raw[j] = vgetq_lane_u8(a, 0);
+  }
+#else
+  // Plain Horner with the times-b nibble tables, all 32 syndromes a byte
+  // at a time so the lookups don't wait on each other.
+  std::fill(raw, raw + NUM_PARITY, 0);
+  for (size_t i = 1; i <= N; i++)
+    for (unsigned j = 0; j < NUM_PARITY; j++) {
+      const uint8_t *t = mulTables[j][5];
+      raw[j] = buf[i] ^ t[raw[j] & 15] ^ t[16 + (raw[j] >> 4)];
+    }
+#endif
+  uint8_t any = 0;
+  for (unsigned j = 0; j < NUM_PARITY; j++) {
+    any |= raw[j];
+    s[j] = indexOf[raw[j]];
+  }
+  return any != 0;
+}
+
+// *** === Decoder === ***
+int ReedSolomon::correct(const uint8_t *s, uint8_t *cw, uint8_t *where) const {
+  // Berlekamp-Massey: error locator lambda (poly form), b its last
+  // correction (log form).
+  uint8_t lambda[NUM_PARITY + 1] = {1};
+  uint8_t b[NUM_PARITY + 1], t[NUM_PARITY + 1];
+  for (unsigned i = 0; i <= NUM_PARITY; i++)
+    b[i] = indexOf[lambda[i]];
+  unsigned el = 0;
+  for (unsigned r = 1; r <= NUM_PARITY; r++) {
+    unsigned discr = 0;
+    for (unsigned i = 0; i < r; i++)
+      if (lambda[i] != 0 && s[r - i - 1] != A0)
+        discr ^= alphaTo[modnn(indexOf[lambda[i]] + s[r - i - 1])];
+    discr = indexOf[discr];
+
+    if (discr == A0) {
+      std::memmove(b + 1, b, NUM_PARITY);
+      b[0] = A0;
+      continue;
+    }
+    t[0] = lambda[0];
+    for (unsigned i = 0; i < NUM_PARITY; i++)
+      t[i + 1] = b[i] != A0 ? lambda[i + 1] ^ alphaTo[modnn(discr + b[i])]
+                            : lambda[i + 1];
+    if (2 * el <= r - 1) {
+      el = r - el;
+      for (unsigned i = 0; i <= NUM_PARITY; i++)
+        b[i] = lambda[i] == 0 ? A0 : modnn(indexOf[lambda[i]] + 255 - discr);
+    } else {
+      std::memmove(b + 1, b, NUM_PARITY);
+      b[0] = A0;
+    }
+    std::memcpy(lambda, t, sizeof(lambda));
+  }
+
+  unsigned degLambda = 0;
+  for (unsigned i = 0; i <= NUM_PARITY; i++) {
+    lambda[i] = indexOf[lambda[i]];
+    if (lambda[i] != A0)
+      degLambda = i;
+  }
+  if (degLambda == 0 || degLambda > MAX_ERRORS)
+    return -1;
+
+  // Chien search: the roots of lambda are the inverse error locations.
+  uint8_t reg[NUM_PARITY + 1], root[MAX_ERRORS], loc[MAX_ERRORS];
+  std::memcpy(reg, lambda, sizeof(reg));
+  unsigned count = 0;
+  for (unsigned i = 1, k = IPRIM - 1; i <= 255; i++, k = modnn(k + IPRIM)) {
+    unsigned q = 1; // lambda[0] is always 1
+    for (unsigned j = degLambda; j > 0; j--)
+      if (reg[j] != A0) {
+        reg[j] = modnn(reg[j] + j);
+        q ^= alphaTo[reg[j]];
+      }
+    if (q != 0)
+      continue;
+    root[count] = (uint8_t)i;
+    loc[count] = (uint8_t)k;
+    if (++count == degLambda)
+      break;
+  }
+  if (count != degLambda)
+    return -1; // Fewer roots than its degree: uncorrectable
+
+  // Error evaluator omega = s * lambda mod x^NUM_PARITY, log form.
+  const unsigned degOmega = degLambda - 1;
+  uint8_t omega[NUM_PARITY];
+  for (unsigned i = 0; i <= degOmega; i++) {
+    unsigned acc = 0;
+    for (unsigned j = 0; j <= i; j++)
+      if (s[i - j] != A0 && lambda[j] != A0)
+        acc ^= alphaTo[modnn(s[i - j] + lambda[j])];
+    omega[i] = indexOf[acc];
+  }
+
+  // Forney: value = root^(FIRST_ROOT - 1) * omega(root) / lambda'(root).
+  for (unsigned j = 0; j < count; j++) {
+    unsigned num = 0;
+    for (unsigned i = 0; i <= degOmega; i++)
+      if (omega[i] != A0)
+        num ^= alphaTo[modnn(omega[i] + i * root[j])];
+    if (num == 0) {
+      where[j] = loc[j]; // Located, but the value is zero
+      continue;
+    }
+    const unsigned scale = modnn(root[j] * (FIRST_ROOT - 1) + 255);
+    unsigned den = 0; // lambda', the odd terms
+    for (unsigned i = std::min<unsigned>(degLambda, NUM_PARITY - 1) & ~1u;;
+         i -= 2) {
+      if (lambda[i + 1] != A0)
+        den ^= alphaTo[modnn(lambda[i + 1] + i * root[j])];
+      if (i == 0)
+        break;
+    }
+    if (den == 0)
+      return -1;
+    cw[loc[j]] ^= alphaTo[modnn(indexOf[num] + scale + 255 - indexOf[den])];
+    where[j] = loc[j];
+  }
+  return (int)count;
+}
+
+int ReedSolomon::decodeStrided(uint8_t *codeword, size_t stride) const {
+  // Conventional basis, with a zero in front to make 256 bytes for the
+  // syndrome kernels; the codeword itself is only written if it's fixable.
+  alignas(32) uint8_t buf[N + 1];
+  buf[0] = 0;
+  if (dual)
+    for (size_t i = 0; i < N; i++)
+      buf[1 + i] = fromDual[codeword[i * stride]];
+  else if (stride == 1)
+    std::memcpy(buf + 1, codeword, N);
+  else
+    for (size_t i = 0; i < N; i++)
+      buf[1 + i] = codeword[i * stride];
+
+  uint8_t s[NUM_PARITY];
+  if (!syndromes(buf, s))
+    return 0;
+
+  uint8_t where[MAX_ERRORS];
+  int n = correct(s, buf + 1, where);
+  for (int e = 0; e < n; e++) {
+    const uint8_t v = buf[1 + where[e]];
+    codeword[where[e] * stride] = dual ? toDual[v] : v;
+  }
+  return n;
+}
+
+int ReedSolomon::decode(uint8_t *codeword) const {
+  return decodeStrided(codeword, 1);
+}
+
+int ReedSolomon::decodeInterleaved(uint8_t *frame, unsigned depth,
+                                   int *corrections) const {
+  if (depth < 1 || depth > MAX_INTERLEAVE) {
+    fprintf(stderr, "[ERROR] RS interleave depth %u (1 .. %u)\n", depth,
+            MAX_INTERLEAVE);
+    return -1;
+  }
+  int total = 0;
+  bool failed = false;
+  for (unsigned i = 0; i < depth; i++) {
+    int n = decodeStrided(frame + i, depth);
+    if (corrections)
+      corrections[i] = n;
+    if (n < 0)
+      failed = true;
+    else
+      total += n;
+  }
+  return failed ? -1 : total;
+}
@@ -0,0 +1,188 @@
+/*
+ * resampler.cpp - Arbitrary ratio Farrow resampler, up or down.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "resampler.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+constexpr double PI = 3.141592653589793;
+// Kaiser for 80 dB: beta = 0.1102 (80 - 8.7), and (80 - 8) / (2.285 * 2 pi
+// * transition) taps at the lower rate.
+constexpr double KAISER_BETA = 7.857;
+constexpr double ATTENUATION = 80.0;
+
+// Taps either side at the lower rate: 13 for the default 0.4 .. 0.6.
+size_t halfTaps(double passband) {
+  const double transition = std::max(0.02, 1.0 - 2.0 * passband);
+  return (size_t)std::ceil((ATTENUATION - 8.0) /
+                           (2.285 * 2.0 * PI * transition) / 2.0);
+}
+
+double besselI0(double x) {
+  double sum = 1.0, term = 1.0;
+  for (int k = 1; k < 50 && term > 1e-12 * sum; k++) {
+    term *= (x / (2.0 * k)) * (x / (2.0 * k));
+    sum += term;
+  }
+  return sum;
+}
+
+// The kernel at t inputs from the output, cutoff fc cycles per input.
+double kernel(double t, double fc, double half) {
+  if (std::abs(t) >= half)
+    return 0.0;
+  const double x = 2.0 * fc * t;
+  const double sinc = x == 0.0 ? 1.0 : std::sin(PI * x) / (PI * x);
+  const double r = t / half;
+  return 2.0 * fc * sinc * besselI0(KAISER_BETA * std::sqrt(1.0 - r * r)) /
+         besselI0(KAISER_BETA);
+}
+
+// y = v0 + u (v1 + u (v2 + u v3)), vp = sum_k row[8k + 2p] * x[k].
+std::complex<float> farrow(const float *row, const std::complex<float> *x,
+                           size_t numTaps, float u) {
+  size_t k = 0;
+  float v[8] = {};
+#if defined(__AVX2__)
+  // Two chains so the FMA latency is hidden.
+  __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+  const double *xd = reinterpret_cast<const double *>(x);
+  for (; k + 2 <= numTaps; k += 2) {
+    const __m256 x0 = _mm256_castpd_ps(_mm256_broadcast_sd(xd + k));
+    const __m256 x1 = _mm256_castpd_ps(_mm256_broadcast_sd(xd + k + 1));
+#if defined(__FMA__)
+    acc0 = _mm256_fmadd_ps(x0, _mm256_loadu_ps(row + 8 * k), acc0);
+    acc1 = _mm256_fmadd_ps(x1, _mm256_loadu_ps(row + 8 * k + 8), acc1);
+#else
+    acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(x0, _mm256_loadu_ps(row + 8 * k)));
+    acc1 = _mm256_add_ps(acc1,
+                         _mm256_mul_ps(x1, _mm256_loadu_ps(row + 8 * k + 8)));
+#endif
+  }
+  _mm256_storeu_ps(v, _mm256_add_ps(acc0, acc1));
+#elif defined(__ARM_NEON)
+  float32x4_t lo = vdupq_n_f32(0.0f), hi = vdupq_n_f32(0.0f);
+  const float *xf = reinterpret_cast<const float *>(x);
+  for (; k < numTaps; k++) {
+    const float32x2_t s = vld1_f32(xf + 2 * k);
+    const float32x4_t xx = vcombine_f32(s, s);
+    lo = vmlaq_f32(lo, xx, vld1q_f32(row + 8 * k));
+    hi = vmlaq_f32(hi, xx, vld1q_f32(row + 8 * k + 4));
+  }
+  vst1q_f32(v, lo);
+  vst1q_f32(v + 4, hi);
+#endif
+  for (; k < numTaps; k++)
+    for (size_t p = 0; p < 4; p++) {
+      v[2 * p] += row[8 * k + 2 * p] * x[k].real();
+      v[2 * p + 1] += row[8 * k + 2 * p] * x[k].imag();
+    }
+  const float re = v[0] + u * (v[2] + u * (v[4] + u * v[6]));
+  const float im = v[1] + u * (v[3] + u * (v[5] + u * v[7]));
+  return {re, im};
+}
+} // namespace
+
+size_t Resampler::tapsFor(uint64_t interp, uint64_t decim, double passband) {
+  const double scale = std::min(1.0, (double)interp / (double)decim);
+  return 2 * (size_t)std::ceil((double)halfTaps(passband) / scale);
+}
+
+Resampler::Resampler(uint64_t interp, uint64_t decim, double passband)
+    : interp(interp), decim(decim), whole(decim / interp),
+      rem(decim % interp), half(tapsFor(interp, decim, passband) / 2) {
+  const size_t numTaps = 2 * half;
+  const double fc = 0.5 * std::min(1.0, (double)interp / (double)decim);
+
+  // Monomial coefficients of the Lagrange basis on u = 0, 1/3, 2/3, 1:
+  // basis[i][j] is the u^j coefficient of the i-th one.
+  double basis[4][4] = {};
+  for (int i = 0; i < 4; i++) {
+    double poly[4] = {1.0, 0.0, 0.0, 0.0};
+    double denom = 1.0;
+    for (int j = 0, deg = 0; j < 4; j++) {
+      if (j == i)
+        continue;
+      // poly *= (u - j/3)
+      for (int d = ++deg; d >= 0; d--)
+        poly[d] = (d > 0 ? poly[d - 1] : 0.0) - (j / 3.0) * poly[d];
+      denom *= (i - j) / 3.0;
+    }
+    for (int d = 0; d < 4; d++)
+      basis[i][d] = poly[d] / denom;
+  }
+
+  // Unit gain at DC.
+  double gain = 0.0;
+  for (size_t k = 0; k < numTaps; k++)
+    gain += kernel((double)half - 1.0 - (double)k, fc, (double)half);
+
+  // Tap k is input next + k; the output sits at next + half - 1 + mu, with
+  // mu = (piece + u) / PHASES.
+  rows.assign(PHASES * numTaps * 8, 0.0f);
+  for (size_t piece = 0; piece < PHASES; piece++)
+    for (size_t k = 0; k < numTaps; k++) {
+      double f[4];
+      for (int i = 0; i < 4; i++) {
+        const double mu = (piece + i / 3.0) / PHASES;
+        f[i] = kernel((double)half - 1.0 - (double)k + mu, fc, (double)half) /
+               gain;
+      }
+      float *b = rows.data() + (piece * numTaps + k) * 8;
+      for (int d = 0; d < 4; d++) {
+        double c = 0.0;
+        for (int i = 0; i < 4; i++)
+          c += f[i] * basis[i][d];
+        b[2 * d] = b[2 * d + 1] = (float)c;
+      }
+    }
+  reset();
+}
+
+void Resampler::reset() {
+  // half - 1 zeros ahead of the first input, which the first output is on.
+  work.assign(half - 1, {0.0f, 0.0f});
+  next = 0;
+  frac = 0;
+}
+
+size_t Resampler::process(const std::complex<float> *in, size_t numIn,
+                          std::complex<float> *out) {
+  const size_t numTaps = 2 * half;
+  work.insert(work.end(), in, in + numIn);
+  size_t count = 0;
+  while (next + numTaps <= work.size()) {
+    const double mu = (double)frac / (double)interp * PHASES;
+    const size_t piece = std::min((size_t)mu, PHASES - 1);
+    out[count++] = farrow(rows.data() + piece * numTaps * 8,
+                          work.data() + next, numTaps, (float)(mu - piece));
+    next += whole;
+    frac += rem;
+    if (frac >= interp) {
+      frac -= interp;
+      next++;
+    }
+  }
+  // Decimating, the next output can be past what we have: skip ahead.
+  const size_t used = std::min(next, work.size());
+  work.erase(work.begin(), work.begin() + used);
+  next -= used;
+  return count;
+}
+
+size_t Resampler::flush(std::complex<float> *out) {
+  const std::vector<std::complex<float>> zeros(half);
+  return process(zeros.data(), zeros.size(), out);
+}
@@ -0,0 +1,417 @@
+/*
+ * sample_format.cpp - cf32 <-> cs16/cs8/cu8 conversion for IQ files.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "sample_format.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+template <typename Int, bool Unsigned>
+size_t packScalar(const float *in, size_t numFloats, float gain, float offset,
+                  Int *out) {
+  constexpr float lo = (sizeof(Int) == 2) ? -32768.0f : -128.0f;
+  constexpr float hi = (sizeof(Int) == 2) ? 32767.0f : 127.0f;
+  size_t clipped = 0;
+  for (size_t i = 0; i < numFloats; i++) {
+    float v = in[i] * gain + offset;
+    if (v > hi + 0.5f || v < lo - 0.5f)
+      clipped++;
+    long r = std::clamp(std::lrintf(v), (long)lo, (long)hi);
+    out[i] = Unsigned ? (Int)(r ^ 0x80) : (Int)r;
+  }
+  return clipped;
+}
+
+#if defined(__AVX2__)
+inline __m256i scaleToInt(const float *in, __m256 g, __m256 o, __m256 hiT,
+                          __m256 loT, size_t &clipped) {
+  __m256 v = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(in), g), o);
+  __m256 bad = _mm256_or_ps(_mm256_cmp_ps(v, hiT, _CMP_GT_OQ),
+                            _mm256_cmp_ps(v, loT, _CMP_LT_OQ));
+  clipped += __builtin_popcount(_mm256_movemask_ps(bad));
+  return _mm256_cvtps_epi32(v); // Round to nearest even, like lrintf
+}
+
+size_t packS16(const float *in, size_t numFloats, float gain, float offset,
+               int16_t *out) {
+  const __m256 g = _mm256_set1_ps(gain), o = _mm256_set1_ps(offset);
+  const __m256 hiT = _mm256_set1_ps(32767.5f), loT = _mm256_set1_ps(-32768.5f);
+  size_t clipped = 0, i = 0;
+  for (; i + 16 <= numFloats; i += 16) {
+    __m256i a = scaleToInt(in + i, g, o, hiT, loT, clipped);
+    __m256i b = scaleToInt(in + i + 8, g, o, hiT, loT, clipped);
+    // packs works per 128 bit half; the permute puts a before b again.
+    __m256i p = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xD8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), p);
+  }
+  return clipped + packScalar<int16_t, false>(in + i, numFloats - i, gain,
+                                              offset, out + i);
+}
+
+template <bool Unsigned>
+size_t packS8(const float *in, size_t numFloats, float gain, float offset,
+              int8_t *out) {
+  const __m256 g = _mm256_set1_ps(gain), o = _mm256_set1_ps(offset);
+  const __m256 hiT = _mm256_set1_ps(127.5f), loT = _mm256_set1_ps(-128.5f);
+  const __m256i flip = _mm256_set1_epi8((char)0x80);
+  size_t clipped = 0, i = 0;
+  for (; i + 32 <= numFloats; i += 32) {
+    __m256i a = scaleToInt(in + i, g, o, hiT, loT, clipped);
+    __m256i b = scaleToInt(in + i + 8, g, o, hiT, loT, clipped);
+    __m256i c = scaleToInt(in + i + 16, g, o, hiT, loT, clipped);
+    __m256i d = scaleToInt(in + i + 24, g, o, hiT, loT, clipped);
+    __m256i ab = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xD8);
+    __m256i cd = _mm256_permute4x64_epi64(_mm256_packs_epi32(c, d), 0xD8);
+    __m256i p = _mm256_permute4x64_epi64(_mm256_packs_epi16(ab, cd), 0xD8);
+    if (Unsigned)
+      p = _mm256_xor_si256(p, flip);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), p);
+  }
+  return clipped + packScalar<int8_t, Unsigned>(in + i, numFloats - i, gain,
+                                                offset, out + i);
+}
+#elif defined(__ARM_NEON)
+inline int32x4_t scaleToInt(const float *in, float32x4_t g, float32x4_t o,
+                            float32x4_t hiT, float32x4_t loT,
+                            uint32x4_t &clipped) {
+  float32x4_t v = vmlaq_f32(o, vld1q_f32(in), g);
+  uint32x4_t bad = vorrq_u32(vcgtq_f32(v, hiT), vcltq_f32(v, loT));
+  clipped = vsubq_u32(clipped, bad); // bad lanes are all ones == -1
+  return vcvtnq_s32_f32(v);
+}
+
+size_t packS16(const float *in, size_t numFloats, float gain, float offset,
+               int16_t *out) {
+  const float32x4_t g = vdupq_n_f32(gain), o = vdupq_n_f32(offset);
+  const float32x4_t hiT = vdupq_n_f32(32767.5f), loT = vdupq_n_f32(-32768.5f);
+  uint32x4_t clipV = vdupq_n_u32(0);
+  size_t i = 0;
+  for (; i + 8 <= numFloats; i += 8) {
+    int32x4_t a = scaleToInt(in + i, g, o, hiT, loT, clipV);
+    int32x4_t b = scaleToInt(in + i + 4, g, o, hiT, loT, clipV);
+    vst1q_s16(out + i, vcombine_s16(vqmovn_s32(a), vqmovn_s32(b)));
+  }
+  return vaddvq_u32(clipV) + packScalar<int16_t, false>(in + i, numFloats - i,
+                                                        gain, offset, out + i);
+}
+
+template <bool Unsigned>
+size_t packS8(const float *in, size_t numFloats, float gain, float offset,
+              int8_t *out) {
+  const float32x4_t g = vdupq_n_f32(gain), o = vdupq_n_f32(offset);
+  const float32x4_t hiT = vdupq_n_f32(127.5f), loT = vdupq_n_f32(-128.5f);
+  uint32x4_t clipV = vdupq_n_u32(0);
+  size_t i = 0;
+  for (; i + 16 <= numFloats; i += 16) {
+    int16x8_t lo = vcombine_s16(
+        vqmovn_s32(scaleToInt(in + i, g, o, hiT, loT, clipV)),
+        vqmovn_s32(scaleToInt(in + i + 4, g, o, hiT, loT, clipV)));
+    int16x8_t hi = vcombine_s16(
+        vqmovn_s32(scaleToInt(in + i + 8, g, o, hiT, loT, clipV)),
+        vqmovn_s32(scaleToInt(in + i + 12, g, o, hiT, loT, clipV)));
+    int8x16_t p = vcombine_s8(vqmovn_s16(lo), vqmovn_s16(hi));
+    if (Unsigned)
+      p = veorq_s8(p, vdupq_n_s8((int8_t)0x80));
+    vst1q_s8(out + i, p);
+  }
+  return vaddvq_u32(clipV) + packScalar<int8_t, Unsigned>(in + i,
+                                                          numFloats - i, gain,
+                                                          offset, out + i);
+}
+#else
+size_t packS16(const float *in, size_t numFloats, float gain, float offset,
+               int16_t *out) {
+  return packScalar<int16_t, false>(in, numFloats, gain, offset, out);
+}
+
+template <bool Unsigned>
+size_t packS8(const float *in, size_t numFloats, float gain, float offset,
+              int8_t *out) {
+  return packScalar<int8_t, Unsigned>(in, numFloats, gain, offset, out);
+}
+#endif
+
+// *** === Reading back: integer -> float === ***
+// out = in * gain + offset; offset is -127.5 * gain for cu8, else 0.
+template <typename Int>
+void unpackScalar(const Int *in, size_t numInts, float gain, float offset,
+                  float *out) {
+  for (size_t i = 0; i < numInts; i++)
+    out[i] = (float)in[i] * gain + offset;
+}
+
+#if defined(__AVX2__)
+inline void storeScaled(__m256i v, __m256 g, __m256 o, float *out) {
+  __m256 f = _mm256_cvtepi32_ps(v);
+#if defined(__FMA__)
+  _mm256_storeu_ps(out, _mm256_fmadd_ps(f, g, o));
+#else
+  _mm256_storeu_ps(out, _mm256_add_ps(_mm256_mul_ps(f, g), o));
+#endif
+}
+
+void unpackS16(const int16_t *in, size_t numInts, float gain, float *out) {
+  const __m256 g = _mm256_set1_ps(gain), o = _mm256_setzero_ps();
+  size_t i = 0;
+  for (; i + 16 <= numInts; i += 16) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i));
+    storeScaled(_mm256_cvtepi16_epi32(_mm256_castsi256_si128(v)), g, o,
+                out + i);
+    storeScaled(_mm256_cvtepi16_epi32(_mm256_extracti128_si256(v, 1)), g, o,
+                out + i + 8);
+  }
+  unpackScalar(in + i, numInts - i, gain, 0.0f, out + i);
+}
+
+template <typename Int>
+void unpack8(const Int *in, size_t numInts, float gain, float offset,
+             float *out) {
+  const __m256 g = _mm256_set1_ps(gain), o = _mm256_set1_ps(offset);
+  size_t i = 0;
+  for (; i + 16 <= numInts; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+    __m128i hi = _mm_unpackhi_epi64(v, v);
+    if constexpr (std::is_signed_v<Int>) {
+      storeScaled(_mm256_cvtepi8_epi32(v), g, o, out + i);
+      storeScaled(_mm256_cvtepi8_epi32(hi), g, o, out + i + 8);
+    } else {
+      storeScaled(_mm256_cvtepu8_epi32(v), g, o, out + i);
+      storeScaled(_mm256_cvtepu8_epi32(hi), g, o, out + i + 8);
+    }
+  }
+  unpackScalar(in + i, numInts - i, gain, offset, out + i);
+}
+#elif defined(__ARM_NEON)
+void unpackS16(const int16_t *in, size_t numInts, float gain, float *out) {
+  size_t i = 0;
+  for (; i + 8 <= numInts; i += 8) {
+    int16x8_t v = vld1q_s16(in + i);
+    vst1q_f32(out + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))),
+                                   gain));
+    vst1q_f32(out + i + 4,
+              vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), gain));
+  }
+  unpackScalar(in + i, numInts - i, gain, 0.0f, out + i);
+}
+
+template <typename Int>
+void unpack8(const Int *in, size_t numInts, float gain, float offset,
+             float *out) {
+  const float32x4_t o = vdupq_n_f32(offset);
+  size_t i = 0;
+  for (; i + 8 <= numInts; i += 8) {
+    int32x4_t lo, hi;
+    if constexpr (std::is_signed_v<Int>) {
+      int16x8_t w = vmovl_s8(vld1_s8(reinterpret_cast<const int8_t *>(in + i)));
+      lo = vmovl_s16(vget_low_s16(w));
+      hi = vmovl_s16(vget_high_s16(w));
+    } else {
+      uint16x8_t w =
+          vmovl_u8(vld1_u8(reinterpret_cast<const uint8_t *>(in + i)));
+      lo = vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(w)));
+      hi = vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(w)));
+    }
+    vst1q_f32(out + i, vmlaq_n_f32(o, vcvtq_f32_s32(lo), gain));
+    vst1q_f32(out + i + 4, vmlaq_n_f32(o, vcvtq_f32_s32(hi), gain));
+  }
+  unpackScalar(in + i, numInts - i, gain, offset, out + i);
+}
+#else
+void unpackS16(const int16_t *in, size_t numInts, float gain, float *out) {
+  unpackScalar(in, numInts, gain, 0.0f, out);
+}
+
+template <typename Int>
+void unpack8(const Int *in, size_t numInts, float gain, float offset,
+             float *out) {
+  unpackScalar(in, numInts, gain, offset, out);
+}
+#endif
+} // namespace
+
+SampleFormat formatFromFilename(const std::string &filename) {
+  // The last extension of the last path component only: "run.cs8.iq" is
+  // cf32, and so is "./cs8.d/run".
+  const size_t base = filename.find_last_of('/');
+  const size_t dot = filename.find_last_of('.');
+  if (dot == std::string::npos || (base != std::string::npos && dot < base))
+    return SampleFormat::CF32;
+  const std::string_view ext = std::string_view(filename).substr(dot);
+  if (ext == ".sc16" || ext == ".cs16")
+    return SampleFormat::CS16;
+  if (ext == ".sc8" || ext == ".cs8")
+    return SampleFormat::CS8;
+  if (ext == ".cu8" || ext == ".u8")
+    return SampleFormat::CU8;
+  return SampleFormat::CF32;
+}
+
+size_t bytesPerSample(SampleFormat fmt) {
+  switch (fmt) {
+  case SampleFormat::CS16:
+    return 4;
+  case SampleFormat::CS8:
+  case SampleFormat::CU8:
+    return 2;
+  case SampleFormat::CF32:
+  default:
+    return 8;
+  }
+}
+
+const char *formatName(SampleFormat fmt) {
+  switch (fmt) {
+  case SampleFormat::CS16:
+    return "cs16";
+  case SampleFormat::CS8:
+    return "cs8";
+  case SampleFormat::CU8:
+    return "cu8";
+  case SampleFormat::CF32:
+  default:
+    return "cf32";
+  }
+}
+
+FormatConverter::FormatConverter(SampleFormat fmt, float fullScale,
+                                 bool dither, uint64_t seed)
+    : fmt(fmt), dither(dither && fmt != SampleFormat::CF32) {
+  switch (fmt) {
+  case SampleFormat::CS16:
+    gain = 32767.0f / fullScale;
+    offset = 0.0f;
+    break;
+  case SampleFormat::CS8:
+    gain = 127.0f / fullScale;
+    offset = 0.0f;
+    break;
+  case SampleFormat::CU8:
+    // round(x*127.5 + 127.5) - 128, packed signed then flipped to unsigned
+    gain = 127.5f / fullScale;
+    offset = -0.5f;
+    break;
+  case SampleFormat::CF32:
+  default:
+    gain = 1.0f;
+    offset = 0.0f;
+    break;
+  }
+
+  // splitmix64 to spread one seed over the lanes; xorshift hates zero.
+  for (size_t k = 0; k < DITHER_LANES; k++) {
+    seed += 0x9e3779b97f4a7c15ULL;
+    uint64_t z = seed;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    rngState[k] = (uint32_t)(z ^ (z >> 31)) | 1;
+  }
+  if (this->dither)
+    scratch.resize(2 * CHUNK_SAMPLES);
+}
+
+void FormatConverter::addDither(const float *in, float *out,
+                                size_t numFloats) {
+  // Lane k of every group of DITHER_LANES values has its own generator so
+  // the loop has no serial dependency between neighbours.
+  constexpr float toUnit = 1.0f / 16777216.0f; // 2^-24
+  for (size_t i = 0; i < numFloats; i += DITHER_LANES) {
+    size_t n = std::min(DITHER_LANES, numFloats - i);
+    for (size_t k = 0; k < n; k++) {
+      uint32_t x = rngState[k];
+      x ^= x << 13;
+      x ^= x >> 17;
+      x ^= x << 5;
+      float u1 = (x >> 8) * toUnit;
+      x ^= x << 13;
+      x ^= x >> 17;
+      x ^= x << 5;
+      float u2 = (x >> 8) * toUnit;
+      rngState[k] = x;
+      out[i + k] = in[i + k] * gain + offset + (u1 - u2);
+    }
+  }
+}
+
+size_t FormatConverter::convert(const std::complex<float> *in,
+                                size_t numSamples, void *out) {
+  const size_t numBytes = numSamples * bytesPerSample();
+  if (fmt == SampleFormat::CF32) {
+    memcpy(out, in, numBytes);
+    return numBytes;
+  }
+
+  const float *src = reinterpret_cast<const float *>(in);
+  size_t numFloats = 2 * numSamples;
+  char *dst = static_cast<char *>(out);
+  const size_t bytesPerFloat = bytesPerSample() / 2;
+
+  while (numFloats > 0) {
+    // With dither: scale + dither into scratch, then pack at unit gain.
+    size_t n = dither ? std::min(numFloats, scratch.size()) : numFloats;
+    const float *block = src;
+    float g = gain, o = offset;
+    if (dither) {
+      addDither(src, scratch.data(), n);
+      block = scratch.data();
+      g = 1.0f;
+      o = 0.0f;
+    }
+
+    switch (fmt) {
+    case SampleFormat::CS16:
+      clipped += packS16(block, n, g, o, reinterpret_cast<int16_t *>(dst));
+      break;
+    case SampleFormat::CS8:
+      clipped += packS8<false>(block, n, g, o, reinterpret_cast<int8_t *>(dst));
+      break;
+    case SampleFormat::CU8:
+      clipped += packS8<true>(block, n, g, o, reinterpret_cast<int8_t *>(dst));
+      break;
+    default:
+      break;
+    }
+
+    src += n;
+    dst += n * bytesPerFloat;
+    numFloats -= n;
+  }
+  return numBytes;
+}
+
+void toComplexFloat(SampleFormat fmt, const void *in, size_t numSamples,
+                    std::complex<float> *out, float fullScale) {
+  float *dst = reinterpret_cast<float *>(out);
+  const size_t numInts = 2 * numSamples;
+  switch (fmt) {
+  case SampleFormat::CS16:
+    unpackS16(static_cast<const int16_t *>(in), numInts, fullScale / 32767.0f,
+              dst);
+    break;
+  case SampleFormat::CS8:
+    unpack8(static_cast<const int8_t *>(in), numInts, fullScale / 127.0f, 0.0f,
+            dst);
+    break;
+  case SampleFormat::CU8:
+    unpack8(static_cast<const uint8_t *>(in), numInts, fullScale / 127.5f,
+            -fullScale, dst);
+    break;
+  case SampleFormat::CF32:
+  default:
+    memcpy(dst, in, numSamples * sizeof(std::complex<float>));
+    break;
+  }
+}
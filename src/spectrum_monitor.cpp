@@ -0,0 +1,206 @@
+/*
+ * spectrum_monitor.cpp - Welch PSD, constellation and eye taps off a pipeline.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "spectrum_monitor.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+
+namespace {
+constexpr double PI = 3.141592653589793;
+constexpr size_t EYE_EVERY = 64; // Chunks between rewrites of the eye file
+} // namespace
+
+SpectrumMonitor::SpectrumMonitor(const MonitorSettings &settings,
+                                 double sampleRate, double centerFreq,
+                                 double samplesPerSymbol)
+    : settings(settings), sampleRate(sampleRate), centerFreq(centerFreq),
+      sps(samplesPerSymbol), fft(FftPlan::cached(settings.fftSize)),
+      freeChunks(CHUNKS), fullChunks(CHUNKS) {
+  const size_t n = settings.fftSize;
+  window.resize(n);
+  double sum = 0.0;
+  for (size_t i = 0; i < n; i++) {
+    window[i] = (float)(0.5 - 0.5 * std::cos(2.0 * PI * i / n));
+    sum += window[i];
+  }
+  windowGain = (float)(sum * sum);
+
+  chunks.resize(CHUNKS);
+  for (Chunk &c : chunks) {
+    c.psd.resize((SEGMENTS_PER_BLOCK + 1) * n / 2);
+    c.eye.resize(sps > 0.0 ? (size_t)std::ceil(EYE_SYMBOLS * sps) : 0);
+    c.points.resize(MAX_POINTS);
+    freeChunks.tryPush(&c);
+  }
+  segments.resize(SEGMENTS_PER_BLOCK * n);
+  spectra.resize(SEGMENTS_PER_BLOCK * n);
+  accum.assign(n, 0.0);
+  frame.resize(n);
+  eyeHist.assign(2 * EYE_TIME_BINS * EYE_AMP_BINS, 0);
+
+  const std::string psdName = settings.prefix + ".psd";
+  const std::string constName = settings.prefix + ".const";
+  psdFile = fopen(psdName.c_str(), "wb");
+  constFile = psdFile ? fopen(constName.c_str(), "wb") : nullptr;
+  if (!psdFile || !constFile) {
+    fprintf(stderr, "%s could not be opened! (%s)\n",
+            (psdFile ? constName : psdName).c_str(), strerror(errno));
+    if (psdFile)
+      fclose(psdFile);
+    psdFile = nullptr;
+    return;
+  }
+  writeSidecar(); // So the viewer can look while we run
+  worker = std::thread(&SpectrumMonitor::work, this);
+}
+
+SpectrumMonitor::~SpectrumMonitor() { close(); }
+
+void SpectrumMonitor::feed(const std::complex<float> *samples, size_t numSamps,
+                           const std::complex<float> *eye, size_t numEye,
+                           const std::complex<float> *symbols,
+                           size_t numSyms) {
+  if (!eye || sps <= 0.0)
+    numEye = 0;
+  Chunk *c;
+  if (!isOpen() || !freeChunks.tryPop(c)) {
+    dropped += isOpen();
+    eyeIndex += numEye;
+    symbolPhase += numSyms;
+    return;
+  }
+  c->numPsd = samples ? std::min(numSamps, c->psd.size()) : 0;
+  std::copy(samples, samples + c->numPsd, c->psd.begin());
+  c->numEye = std::min(numEye, c->eye.size());
+  std::copy(eye, eye + c->numEye, c->eye.begin());
+  c->eyeStart = eyeIndex;
+  eyeIndex += numEye;
+
+  const size_t d = settings.decimation;
+  c->numPoints = 0;
+  for (size_t k = (d - symbolPhase % d) % d;
+       k < numSyms && c->numPoints < MAX_POINTS; k += d)
+    c->points[c->numPoints++] = symbols[k];
+  symbolPhase += numSyms;
+
+  fullChunks.tryPush(c); // Never full: there are only CHUNKS chunks
+}
+
+void SpectrumMonitor::work() {
+  Chunk *c;
+  // Asleep on the ring while there's nothing to do; close() wakes it.
+  while (fullChunks.pop(c, stop)) {
+    analyze(*c);
+    freeChunks.tryPush(c);
+  }
+  // Everything fed before stop was set is in the ring by now.
+  while (fullChunks.tryPop(c))
+    analyze(*c);
+}
+
+void SpectrumMonitor::analyze(const Chunk &c) {
+  // Welch: Hann windowed segments at 50% overlap, one batched FFT.
+  const size_t n = settings.fftSize, hop = n / 2;
+  const size_t count =
+      c.numPsd >= n ? std::min((c.numPsd - n) / hop + 1, SEGMENTS_PER_BLOCK)
+                    : 0;
+  for (size_t s = 0; s < count; s++)
+    for (size_t i = 0; i < n; i++)
+      segments[s * n + i] = c.psd[s * hop + i] * window[i];
+  fft.forward(segments.data(), spectra.data(), count);
+  for (size_t s = 0; s < count; s++) {
+    const std::complex<float> *x = spectra.data() + s * n;
+    for (size_t k = 0; k < n; k++)
+      accum[k] += std::norm(x[k]);
+    if (++accumulated < settings.average)
+      continue;
+    const double scale = 1.0 / ((double)settings.average * windowGain);
+    for (size_t k = 0; k < n; k++) // Lowest frequency first
+      frame[k] = (float)(10.0 * std::log10(accum[(k + n / 2) % n] * scale +
+                                           1e-30));
+    fwrite(frame.data(), sizeof(float), n, psdFile);
+    std::fill(accum.begin(), accum.end(), 0.0);
+    accumulated = 0;
+    frames++;
+  }
+
+  // Eye: two symbol periods wide, I and Q.
+  const double period = 2.0 * sps;
+  for (size_t i = 0; i < c.numEye; i++) {
+    const double t = std::fmod((double)(c.eyeStart + i), period) / period;
+    const size_t tb = std::min(EYE_TIME_BINS - 1, (size_t)(t * EYE_TIME_BINS));
+    const float iq[2] = {c.eye[i].real(), c.eye[i].imag()};
+    for (size_t plane = 0; plane < 2; plane++) {
+      const float a = (iq[plane] + EYE_RANGE) / (2.0f * EYE_RANGE);
+      if (a >= 0.0f && a < 1.0f)
+        eyeHist[(plane * EYE_TIME_BINS + tb) * EYE_AMP_BINS +
+                (size_t)(a * EYE_AMP_BINS)]++;
+    }
+  }
+
+  fwrite(c.points.data(), sizeof(std::complex<float>), c.numPoints,
+         constFile);
+  if (++chunksSeen % EYE_EVERY == 0)
+    writeEye();
+}
+
+void SpectrumMonitor::writeEye() {
+  if (sps <= 0.0)
+    return;
+  const std::string name = settings.prefix + ".eye";
+  FILE *f = fopen(name.c_str(), "wb");
+  if (!f)
+    return;
+  fwrite(eyeHist.data(), sizeof(uint32_t), eyeHist.size(), f);
+  fclose(f);
+}
+
+int SpectrumMonitor::writeSidecar() {
+  const std::string name = settings.prefix + ".json";
+  FILE *f = fopen(name.c_str(), "w");
+  if (!f) {
+    fprintf(stderr, "%s could not be opened! (%s)\n", name.c_str(),
+            strerror(errno));
+    return 1;
+  }
+  fprintf(f,
+          "{\"sample_rate\": %.17g, \"center_freq\": %.17g, "
+          "\"fft_size\": %zu, \"segments_per_frame\": %zu, \"overlap\": 0.5,\n"
+          " \"psd\": \"%s.psd\", \"frames\": %zu,\n"
+          " \"constellation\": \"%s.const\", \"decimation\": %zu,\n"
+          " \"eye\": \"%s\", \"samples_per_symbol\": %.17g, "
+          "\"eye_time_bins\": %zu, \"eye_amp_bins\": %zu, "
+          "\"eye_range\": %g, \"eye_symbols\": 2,\n"
+          " \"dropped_blocks\": %zu}\n",
+          sampleRate, centerFreq, settings.fftSize, settings.average,
+          settings.prefix.c_str(), frames, settings.prefix.c_str(),
+          settings.decimation,
+          sps > 0.0 ? (settings.prefix + ".eye").c_str() : "", sps,
+          EYE_TIME_BINS, EYE_AMP_BINS, EYE_RANGE, dropped);
+  return fclose(f) == 0 ? 0 : 1;
+}
+
+int SpectrumMonitor::close() {
+  if (closed || !isOpen())
+    return isOpen() ? 0 : 1;
+  closed = true;
+  stop.store(true);
+  fullChunks.wake();
+  worker.join();
+  writeEye();
+  int err = 0;
+  err |= fclose(psdFile) != 0;
+  err |= fclose(constFile) != 0;
+  err |= writeSidecar();
+  if (err)
+    fprintf(stderr, "[ERROR] Writing the monitor files %s.* failed.\n",
+            settings.prefix.c_str());
+  return err;
+}
@@ -0,0 +1,271 @@
+/*
+ * stage_stats.cpp - Per-stage counters, latency histograms and a stats socket.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "stage_stats.h"
+
+#if defined(QPSK_STATS)
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace stats {
+
+namespace {
+constexpr int POLL_MS = 100; // How quickly the reporter notices stop
+
+std::mutex registryLock;
+std::vector<std::string> stageNames;
+std::vector<std::unique_ptr<ThreadSlot>> slots;
+thread_local ThreadSlot *mySlot = nullptr;
+
+// Smallest recorded value with at least p of the count at or below it.
+uint64_t percentile(const std::vector<uint64_t> &latency, uint64_t count,
+                    double p) {
+  if (count == 0)
+    return 0;
+  const uint64_t want = std::max<uint64_t>(1, (uint64_t)(p * count + 0.5));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < latency.size(); i++) {
+    seen += latency[i];
+    if (seen >= want)
+      return histogram::upperBound(i);
+  }
+  return histogram::upperBound(latency.size() - 1);
+}
+
+uint64_t highest(const std::vector<uint64_t> &latency) {
+  for (size_t i = latency.size(); i-- > 0;)
+    if (latency[i] != 0)
+      return histogram::upperBound(i);
+  return 0;
+}
+} // namespace
+
+thread_local int currentStage = -1;
+
+ThreadSlot &threadSlot() {
+  if (!mySlot) {
+    std::lock_guard<std::mutex> lock(registryLock);
+    slots.push_back(std::make_unique<ThreadSlot>());
+    mySlot = slots.back().get();
+  }
+  return *mySlot;
+}
+
+int registerStage(const std::string &name) {
+  std::lock_guard<std::mutex> lock(registryLock);
+  for (size_t s = 0; s < stageNames.size(); s++)
+    if (stageNames[s] == name)
+      return (int)s;
+  if (stageNames.size() == MAX_STAGES) {
+    fprintf(stderr, "[WARNING] Stats: more than %zu stages, '%s' isn't "
+                    "counted.\n",
+            MAX_STAGES, name.c_str());
+    return -1;
+  }
+  stageNames.push_back(name);
+  return (int)stageNames.size() - 1;
+}
+
+Reporter::Reporter(double interval, const std::string &socketPath)
+    : interval(interval), socketPath(socketPath),
+      start(std::chrono::steady_clock::now()) {
+  if (!socketPath.empty()) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(addr.sun_path)) {
+      fprintf(stderr, "[WARNING] Stats socket path %s is too long.\n",
+              socketPath.c_str());
+    } else {
+      memcpy(addr.sun_path, socketPath.c_str(), socketPath.size() + 1);
+      listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+      unlink(socketPath.c_str()); // Left over from an earlier run
+      if (listenFd < 0 ||
+          bind(listenFd, (const sockaddr *)&addr, sizeof(addr)) != 0 ||
+          listen(listenFd, 4) != 0) {
+        fprintf(stderr, "[WARNING] No stats socket at %s (%s)\n",
+                socketPath.c_str(), strerror(errno));
+        if (listenFd >= 0)
+          close(listenFd);
+        listenFd = -1;
+      }
+    }
+  }
+  if (active())
+    thread = std::thread(&Reporter::run, this);
+}
+
+Reporter::~Reporter() {
+  if (!active())
+    return;
+  stop.store(true);
+  thread.join();
+  const double secs = std::chrono::duration<double>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
+  printSummary(collect(), {}, secs, "whole run");
+  if (listenFd >= 0) {
+    close(listenFd);
+    unlink(socketPath.c_str());
+  }
+}
+
+std::vector<Reporter::StageTotals> Reporter::collect() const {
+  std::lock_guard<std::mutex> lock(registryLock);
+  std::vector<StageTotals> totals(stageNames.size());
+  for (size_t s = 0; s < totals.size(); s++) {
+    StageTotals &t = totals[s];
+    t.name = stageNames[s];
+    t.latency.assign(histogram::BUCKETS, 0);
+    for (const std::unique_ptr<ThreadSlot> &slot : slots) {
+      const StageCounters &c = slot->stages[s];
+      t.blocks += c.blocks.get();
+      t.items += c.items.get();
+      t.busyNs += c.busyNs.get();
+      t.maxNs = std::max(t.maxNs, c.maxNs.get());
+      t.fillSum += c.fillSum.get();
+      t.fillMax = std::max(t.fillMax, c.fillMax.get());
+      t.fillSamples += c.fillSamples.get();
+      t.underruns += c.underruns.get();
+      t.overruns += c.overruns.get();
+      for (size_t i = 0; i < histogram::BUCKETS; i++)
+        t.latency[i] += c.latency[i].get();
+    }
+  }
+  return totals;
+}
+
+// What changed between before and now (all of now if before is empty).
+void Reporter::printSummary(const std::vector<StageTotals> &now,
+                            const std::vector<StageTotals> &before,
+                            double secs, const char *what) const {
+  fprintf(stderr,
+          "[STATUS] Stages, %s (%.2f s):\n"
+          "  %-10s %8s %10s %6s %9s %9s %9s %9s %6s %6s\n",
+          what, secs, "stage", "blocks", "items/s", "busy", "p50 us",
+          "p99 us", "max us", "fill", "under", "over");
+  for (size_t s = 0; s < now.size(); s++) {
+    StageTotals d = now[s];
+    if (s < before.size()) {
+      const StageTotals &b = before[s];
+      d.blocks -= b.blocks;
+      d.items -= b.items;
+      d.busyNs -= b.busyNs;
+      d.fillSum -= b.fillSum;
+      d.fillSamples -= b.fillSamples;
+      d.underruns -= b.underruns;
+      d.overruns -= b.overruns;
+      for (size_t i = 0; i < d.latency.size(); i++)
+        d.latency[i] -= b.latency[i];
+      d.maxNs = std::min(d.maxNs, highest(d.latency));
+    }
+    char fill[16] = "-";
+    if (d.fillSamples > 0)
+      snprintf(fill, sizeof(fill), "%.1f", (double)d.fillSum / d.fillSamples);
+    fprintf(stderr, "  %-10s %8llu %10.4g %5.1f%% %9.1f %9.1f %9.1f %9s "
+                    "%6llu %6llu\n",
+            d.name.c_str(), (unsigned long long)d.blocks,
+            secs > 0 ? d.items / secs : 0.0,
+            secs > 0 ? 100.0 * d.busyNs / (secs * 1e9) : 0.0,
+            percentile(d.latency, d.blocks, 0.5) / 1e3,
+            percentile(d.latency, d.blocks, 0.99) / 1e3, d.maxNs / 1e3, fill,
+            (unsigned long long)d.underruns, (unsigned long long)d.overruns);
+  }
+}
+
+// Running totals; latency as [largest value in bucket, count] pairs.
+std::string Reporter::snapshotJson(
+    const std::vector<StageTotals> &totals) const {
+  const double secs = std::chrono::duration<double>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
+  char buf[512];
+  snprintf(buf, sizeof(buf), "{\"uptime_s\":%.6f,\"stages\":[", secs);
+  std::string json = buf;
+  for (size_t s = 0; s < totals.size(); s++) {
+    const StageTotals &t = totals[s];
+    snprintf(buf, sizeof(buf),
+             "%s{\"name\":\"%s\",\"blocks\":%llu,\"items\":%llu,"
+             "\"busy_ns\":%llu,\"p50_ns\":%llu,\"p90_ns\":%llu,"
+             "\"p99_ns\":%llu,\"p999_ns\":%llu,\"max_ns\":%llu,"
+             "\"fill_avg\":%.3f,\"fill_max\":%llu,\"underruns\":%llu,"
+             "\"overruns\":%llu,\"latency_ns\":[",
+             s ? "," : "", t.name.c_str(), (unsigned long long)t.blocks,
+             (unsigned long long)t.items, (unsigned long long)t.busyNs,
+             (unsigned long long)percentile(t.latency, t.blocks, 0.5),
+             (unsigned long long)percentile(t.latency, t.blocks, 0.9),
+             (unsigned long long)percentile(t.latency, t.blocks, 0.99),
+             (unsigned long long)percentile(t.latency, t.blocks, 0.999),
+             (unsigned long long)t.maxNs,
+             t.fillSamples ? (double)t.fillSum / t.fillSamples : 0.0,
+             (unsigned long long)t.fillMax, (unsigned long long)t.underruns,
+             (unsigned long long)t.overruns);
+    json += buf;
+    bool first = true;
+    for (size_t i = 0; i < t.latency.size(); i++) {
+      if (t.latency[i] == 0)
+        continue;
+      snprintf(buf, sizeof(buf), "%s[%llu,%llu]", first ? "" : ",",
+               (unsigned long long)histogram::upperBound(i),
+               (unsigned long long)t.latency[i]);
+      json += buf;
+      first = false;
+    }
+    json += "]}";
+  }
+  json += "]}\n";
+  return json;
+}
+
+void Reporter::run() {
+  using Clock = std::chrono::steady_clock;
+  std::vector<StageTotals> before = collect();
+  Clock::time_point last = Clock::now();
+  while (!stop.load()) {
+    pollfd pfd{listenFd, POLLIN, 0};
+    if (poll(&pfd, listenFd >= 0 ? 1 : 0, POLL_MS) > 0 &&
+        (pfd.revents & POLLIN))
+      serve();
+    const double secs =
+        std::chrono::duration<double>(Clock::now() - last).count();
+    if (interval > 0.0 && secs >= interval) {
+      std::vector<StageTotals> now = collect();
+      printSummary(now, before, secs, "last interval");
+      before = std::move(now);
+      last = Clock::now();
+    }
+  }
+}
+
+// One snapshot per connection, then hang up.
+void Reporter::serve() {
+  const int fd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+  if (fd < 0)
+    return;
+  const std::string json = snapshotJson(collect());
+  size_t done = 0;
+  while (done < json.size()) {
+    ssize_t n = send(fd, json.data() + done, json.size() - done, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      break;
+    done += (size_t)n;
+  }
+  close(fd);
+}
+
+} // namespace stats
+
+#endif
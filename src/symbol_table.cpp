@@ -0,0 +1,28 @@
+/*
+ * symbol_table.cpp - Precomputed symbol waveforms in one contiguous buffer.
+ * src/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "symbol_table.h"
+
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+SymbolTable::SymbolTable(size_t numSymbols, size_t samplesPerSymbol)
+    : numSymbols(numSymbols), sps(samplesPerSymbol) {
+  // Pad each row out to a whole number of cache lines.
+  constexpr size_t samplesPerLine = ALIGNMENT / sizeof(std::complex<float>);
+  stride = (sps + samplesPerLine - 1) / samplesPerLine * samplesPerLine;
+
+  size_t numBytes = numSymbols * stride * sizeof(std::complex<float>);
+  void *mem = nullptr;
+  if (posix_memalign(&mem, ALIGNMENT, numBytes ? numBytes : ALIGNMENT) != 0) {
+    fprintf(stderr, "Could not allocate a %zu byte symbol table!\n", numBytes);
+    throw std::bad_alloc();
+  }
+  memset(mem, 0, numBytes); // Zeros, padding included
+  buffer.reset(static_cast<std::complex<float> *>(mem));
+}
@@ -0,0 +1,155 @@
+/*
+ * units.cpp - Checks on single blocks a main -> rx round trip can't reach.
+ * tests/ https://github.com/temataro/qpsk-cpp Author: temataro 2026-10-17
+ *
+ * Copyright 2024. SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <vector>
+
+#include "convolutional_code.h"
+#include "demapper.h"
+#include "gaussian_noise.h"
+#include "symbol_mapper.h"
+#include "timing_recovery.h"
+
+namespace {
+int fails = 0;
+
+void check(const char *name, bool ok) {
+  printf("%s %s\n", ok ? "[ OK ]" : "[FAIL]", name);
+  fails += !ok;
+}
+
+// Index of the point nearest to y.
+uint8_t nearest(std::span<const std::complex<float>> points,
+                std::complex<float> y) {
+  size_t best = 0;
+  for (size_t k = 1; k < points.size(); k++)
+    if (std::norm(y - points[k]) < std::norm(y - points[best]))
+      best = k;
+  return (uint8_t)best;
+}
+
+// *** === OQPSK: Gardner midpoints -> OqpskRealigner === ***
+// QPSK labels sent with Q half a symbol late, I and Q going in straight
+// lines from peak to peak, cut into uneven blocks. They go at 8.02 samples
+// per symbol to a loop expecting 8, so it has to track. Label j's I peaks
+// on sample FIRST + j * SENT_SPS, which puts Gardner's first strobe
+// (HALF_TAPS + sps in) on label 1: what comes out of the realigner is
+// labels 1, 2, ... with no half symbol mixed in.
+bool oqpskRoundTrip() {
+  constexpr size_t SPS = 8, FIRST = 4, NUM_LABELS = 4000;
+  constexpr double SENT_SPS = 8.02;
+  const std::span<const std::complex<float>> points =
+      constellationPoints(Modulation::QPSK);
+  Xoshiro256 rng(13);
+  std::vector<uint8_t> sent(NUM_LABELS);
+  for (uint8_t &l : sent)
+    l = (uint8_t)(rng.next() >> 62);
+
+  // Straight line between the peaks of one rail, held at either end.
+  auto rail = [&](double t, bool q) {
+    const double at = std::clamp(t, 0.0, (double)(NUM_LABELS - 1));
+    const size_t j = std::min((size_t)at, NUM_LABELS - 2);
+    const double mu = at - (double)j;
+    const auto part = [&](size_t k) {
+      return q ? points[sent[k]].imag() : points[sent[k]].real();
+    };
+    return (float)((1.0 - mu) * part(j) + mu * part(j + 1));
+  };
+  std::vector<std::complex<float>> samples(
+      (size_t)(NUM_LABELS * SENT_SPS) + FIRST);
+  for (size_t n = 0; n < samples.size(); n++) {
+    const double t = ((double)n - FIRST) / SENT_SPS;
+    samples[n] = {rail(t, false), rail(t - 0.5, true)};
+  }
+
+  GardnerTimingRecovery timing(SPS);
+  timing.emitMidpoints(true);
+  OqpskRealigner realigner;
+  std::vector<std::complex<float>> half(timing.maxSymbols(samples.size()));
+  std::vector<uint8_t> got;
+  for (size_t at = 0, block = 777; at < samples.size(); at += block) {
+    const size_t n = std::min(block, samples.size() - at);
+    const size_t numHalf = timing.process(&samples[at], n, half.data());
+    const size_t numSyms = realigner.process(half.data(), numHalf, half.data());
+    for (size_t k = 0; k < numSyms; k++)
+      got.push_back(nearest(points, half[k]));
+  }
+  // The last few symbols are still inside the interpolator.
+  if (got.size() + 8 < NUM_LABELS)
+    return false;
+  return std::equal(got.begin(), got.end() - 2, sent.begin() + 1);
+}
+
+// *** === Viterbi: scalar reference vs the Auto (AVX2) kernel === ***
+// The same noisy LLRs through both, cut into the same run of uneven blocks
+// (where a call ends is where it traces back from, so the cuts have to
+// match), then flushed: the decoded bits have to agree exactly, errors and
+// all. Noise at sigma 0.85 against +-1 (Eb/N0 about 1.4 dB) leaves close
+// calls and ~1.5% wrong bits for them to disagree on.
+bool viterbiKernelsAgree(bool invertG2) {
+  constexpr size_t NUM_BITS = 100000;
+  constexpr float SCALE = 32.0f, SIGMA = 0.85f;
+  Xoshiro256 rng(14);
+  std::vector<uint8_t> bits(NUM_BITS);
+  for (uint8_t &b : bits)
+    b = (uint8_t)(rng.next() >> 63);
+  ConvEncoder encoder(invertG2);
+  std::vector<uint8_t> coded(2 * NUM_BITS + 12);
+  size_t numCoded = encoder.encode(bits.data(), NUM_BITS, coded.data());
+  numCoded += encoder.flush(&coded[numCoded]);
+
+  GaussianNoise noise(14);
+  std::vector<float> offsets(numCoded);
+  noise.generate(offsets.data(), numCoded, SIGMA);
+  std::vector<int8_t> llrs(numCoded);
+  for (size_t i = 0; i < numCoded; i++) {
+    const float x = SCALE * ((coded[i] ? -1.0f : 1.0f) + offsets[i]);
+    llrs[i] = (int8_t)std::clamp(std::lround(x), -127L, 127L);
+  }
+
+  auto run = [&](ViterbiKernel kernel) {
+    ViterbiDecoder decoder(ViterbiDecoder::DEFAULT_TRACEBACK, invertG2,
+                           kernel);
+    Xoshiro256 cuts(invertG2);
+    std::vector<uint8_t> out;
+    size_t numOut = 0;
+    for (size_t at = 0; at < numCoded;) {
+      const size_t n = std::min<size_t>(1 + cuts.next() % 3000, numCoded - at);
+      out.resize(numOut + n / 2 + decoder.pending());
+      numOut += decoder.decode(&llrs[at], n, out.data() + numOut);
+      at += n;
+    }
+    out.resize(numOut + decoder.pending());
+    numOut += decoder.flush(out.data() + numOut, true);
+    out.resize(numOut);
+    return out;
+  };
+  const std::vector<uint8_t> ref = run(ViterbiKernel::Scalar);
+  const std::vector<uint8_t> fast = run(ViterbiKernel::Auto);
+  // Make sure the noise did its job: some wrong bits, not a wall of them.
+  size_t wrong = 0;
+  for (size_t i = 0; i < std::min(ref.size(), bits.size()); i++)
+    wrong += ref[i] != bits[i];
+  return ref.size() >= NUM_BITS && ref == fast && wrong > 0 &&
+         wrong < NUM_BITS / 10;
+}
+} // namespace
+
+int main() {
+  check("oqpsk: Gardner midpoints realign into the sent labels",
+        oqpskRoundTrip());
+  check("viterbi: scalar and AVX2 kernels decide alike (G2 inverted)",
+        viterbiKernelsAgree(true));
+  check("viterbi: scalar and AVX2 kernels decide alike (G2 as is)",
+        viterbiKernelsAgree(false));
+  return fails;
+}
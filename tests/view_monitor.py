@@ -0,0 +1,106 @@
+#!/usr/bin/env -S uv run --script
+# /// script
+# requires-python = ">=3.12"
+# dependencies = [
+#     "matplotlib",
+#     "numpy",
+# ]
+# ///
+
+# What view_iq.grc / view_symbols.grc show, from the summary files main and rx
+# write with --monitor prefix, all at once instead of played back:
+#
+#   ./tests/view_monitor.py ./data/rx     # reads ./data/rx.{json,psd,const,eye}
+#
+# Mean PSD and waterfall from prefix.psd, the (decimated) constellation from
+# prefix.const and, from rx, the I and Q eye histograms from prefix.eye. It
+# can be run again while the program is still going; the sidecar is written
+# up front and the eye every so often.
+
+import json
+import os
+import sys
+
+import matplotlib.pyplot as plt
+import numpy as np
+
+
+def load(prefix):
+    with open(prefix + ".json") as f:
+        meta = json.load(f)
+    n = meta["fft_size"]
+    psd = np.fromfile(prefix + ".psd", dtype=np.float32)
+    psd = psd[: len(psd) // n * n].reshape(-1, n)
+    points = np.fromfile(prefix + ".const", dtype=np.complex64)
+    eye = None
+    if meta["eye"] and os.path.exists(prefix + ".eye"):
+        shape = (2, meta["eye_time_bins"], meta["eye_amp_bins"])
+        eye = np.fromfile(prefix + ".eye", dtype=np.uint32).reshape(shape)
+    return meta, psd, points, eye
+
+
+def view_monitor(prefix):
+    meta, psd, points, eye = load(prefix)
+    n, fs = meta["fft_size"], meta["sample_rate"]
+    freqs = meta["center_freq"] + (np.arange(n) - n // 2) * fs / n
+    # One frame is fft_size/2 * (segments_per_frame + 1) samples long at
+    # most; the monitor only looks at the start of each block, so this is
+    # frames, not seconds.
+    fig, axes = plt.subplots(2, 2 if eye is None else 3, figsize=(15, 8))
+    fig.suptitle(f"{prefix}: {len(psd)} PSD frames, "
+                 f"{meta['dropped_blocks']} blocks skipped")
+
+    ax = axes[0, 0]
+    if len(psd):
+        mean = 10 * np.log10(np.mean(10 ** (psd / 10), axis=0))
+        ax.plot(freqs / 1e3, mean, lw=0.8, label="Mean")
+        ax.plot(freqs / 1e3, psd.max(axis=0), lw=0.5, alpha=0.6,
+                label="Max hold")
+        ax.legend()
+    ax.set_xlabel("Frequency (kHz)")
+    ax.set_ylabel("dB (0 dB: unit power tone)")
+    ax.set_title("Welch PSD")
+    ax.grid(True)
+
+    ax = axes[1, 0]
+    if len(psd):
+        floor = np.percentile(psd, 5)
+        ax.imshow(psd, aspect="auto", origin="lower", cmap="viridis",
+                  vmin=floor, vmax=psd.max(),
+                  extent=[freqs[0] / 1e3, freqs[-1] / 1e3, 0, len(psd)])
+    ax.set_xlabel("Frequency (kHz)")
+    ax.set_ylabel("Frame")
+    ax.set_title("Waterfall")
+
+    ax = axes[0, 1]
+    ax.plot(points.real, points.imag, ".", ms=1, alpha=0.3)
+    ax.set_aspect("equal")
+    ax.set_title(f"Constellation (1 in {meta['decimation']})")
+    ax.grid(True)
+
+    ax = axes[1, 1]
+    if len(points):
+        ax.hist(np.abs(points), bins=200)
+    ax.set_xlabel("|symbol|")
+    ax.set_title("Symbol magnitudes")
+
+    if eye is not None:
+        r = meta["eye_range"]
+        for row, name in enumerate(("I", "Q")):
+            ax = axes[row, 2]
+            # Log counts so the transitions show next to the symbol centres.
+            ax.imshow(np.log1p(eye[row].T), aspect="auto", origin="lower",
+                      cmap="inferno",
+                      extent=[0, meta["eye_symbols"], -r, r])
+            ax.set_xlabel("Symbols")
+            ax.set_title(f"Eye, {name}")
+
+    fig.tight_layout()
+    plt.show()
+
+
+if __name__ == "__main__":
+    if len(sys.argv) != 2:
+        print(f"Usage: {sys.argv[0]} prefix  (as given to --monitor)")
+        sys.exit(1)
+    view_monitor(sys.argv[1])